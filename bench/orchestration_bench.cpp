@@ -0,0 +1,287 @@
+/**
+ * @file orchestration_bench.cpp
+ * @brief benchmark of orchestration layer with stub ffmpeg and ffprobe
+ * @details stubs in bench/stubs are put on PATH, so that time spent in external commands is negligible and what is
+ * measured is the app itself: probing through ProcessRunner, parsing and indexing probe results, planning encodes
+ * with a preset, and running them through EncodeScheduler. for each number of files, throughput of each phase,
+ * latency of event loop and growth of resident memory are reported.
+ * the stubs can also be put on PATH of the gui to try import and batch encode of a large number of files by hand.
+ */
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QtDebug>
+#include <QVector>
+#include <algorithm>
+#include <ciso646>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "encodecost.hpp"
+#include "encodescheduler.hpp"
+#include "libraryindex.hpp"
+#include "proberesult.hpp"
+#include "processrunner.hpp"
+#include "procfs.hpp"
+#include "transcodeplan.hpp"
+#include "videoinfo.hpp"
+
+namespace {
+constexpr int LATENCY_PROBE_INTERVAL_MSEC = 10;
+const QList<int> DEFAULT_SIZES{100, 1000, 10000};
+const QList<int> LARGE_SIZES{100, 1000, 10000, 50000};
+/**
+ * @brief measures how late a timer fires while event loop is busy
+ */
+class LatencyProbe {
+   public:
+    LatencyProbe() {
+        timer_.setInterval(LATENCY_PROBE_INTERVAL_MSEC);
+        QObject::connect(&timer_, &QTimer::timeout, [this] { tick_(); });
+    }
+    void start() {
+        max_lateness_ = 0;
+        sum_lateness_ = 0;
+        num_ticks_ = 0;
+        clock_.start();
+        timer_.start();
+    }
+    void stop() {
+        // work done without returning to event loop is only seen here
+        tick_();
+        timer_.stop();
+    }
+    qint64 max_lateness() const { return max_lateness_; }
+    double mean_lateness() const { return num_ticks_ == 0 ? 0.0 : static_cast<double>(sum_lateness_) / num_ticks_; }
+
+   private:
+    QTimer timer_;
+    QElapsedTimer clock_;
+    qint64 max_lateness_ = 0;
+    qint64 sum_lateness_ = 0;
+    int num_ticks_ = 0;
+
+    void tick_() {
+        auto lateness = clock_.restart() - LATENCY_PROBE_INTERVAL_MSEC;
+        max_lateness_ = std::max(max_lateness_, lateness);
+        sum_lateness_ += std::max<qint64>(lateness, 0);
+        num_ticks_++;
+    }
+};
+struct PhaseResult {
+    QString name;
+    int num_files;
+    qint64 elapsed_msec;
+    qint64 max_latency_msec;
+    double mean_latency_msec;
+    qint64 memory_growth;
+};
+qint64 resident_memory() {
+    return concat::read_resident_memory(QCoreApplication::applicationPid()).value_or(0);
+}
+/**
+ * @brief run phase in event loop and measure it
+ *
+ * @param start starts work of phase and calls its argument when the work is done
+ */
+PhaseResult measure(const QString &name, int num_files, const std::function<void(std::function<void()>)> &start) {
+    LatencyProbe probe;
+    QEventLoop loop;
+    auto memory_before = resident_memory();
+    QElapsedTimer clock;
+    clock.start();
+    probe.start();
+    QTimer::singleShot(0, &loop, [&] { start([&] { loop.quit(); }); });
+    loop.exec();
+    probe.stop();
+    return {name, num_files, clock.elapsed(), probe.max_lateness(), probe.mean_lateness(),
+            resident_memory() - memory_before};
+}
+/**
+ * @brief preset used for every file, which re-encodes the stub source (h264 1080p) to hevc 720p
+ */
+concat::VideoInfo preset() {
+    concat::VideoInfo output_info;
+    output_info.resolution = QSize(1280, 720);
+    output_info.framerate = 30.0;
+    output_info.is_vfr = false;
+    output_info.audio_codec = QString("aac");
+    output_info.video_codec = QString("libx265");
+    output_info.encoding_args = {"-preset", "fast", "-crf", "26"};
+    return output_info;
+}
+QList<PhaseResult> run(int num_files, int concurrency) {
+    QTemporaryDir work_dir;
+    QDir dir(work_dir.path());
+    dir.mkdir("sources");
+    dir.mkdir("outputs");
+    QStringList sources;
+    for (int i = 0; i < num_files; i++) {
+        auto path = dir.filePath(QString("sources/%1.mp4").arg(i, 6, 10, QChar('0')));
+        QFile file(path);
+        if (not file.open(QIODevice::WriteOnly)) {
+            qWarning() << "failed to create" << path;
+        }
+        sources.push_back(path);
+    }
+    QList<PhaseResult> results;
+    QVector<std::optional<concat::ProbeResult>> probe_results(num_files);
+    auto index = std::make_unique<concat::LibraryIndex>(dir.filePath("library_index.json"));
+    concat::ProcessRunner runner(concurrency);
+    concat::EncodeScheduler scheduler;
+    scheduler.set_max_concurrent_jobs(concurrency);
+
+    results.push_back(measure("probe", num_files, [&](std::function<void()> done) {
+        auto num_remaining = std::make_shared<int>(num_files);
+        for (int i = 0; i < num_files; i++) {
+            auto on_finished = [&, i, num_remaining, done](const concat::ProcessResult &result) {
+                QString error;
+                auto probe_result = concat::parse_probe_result(result.stdout_text, error);
+                if (probe_result.has_value()) {
+                    index->insert(QFileInfo(sources[i]), probe_result.value());
+                    probe_results[i] = probe_result;
+                } else {
+                    qWarning() << sources[i] << error << result.error;
+                }
+                if (--*num_remaining == 0) {
+                    done();
+                }
+            };
+            runner.run("ffprobe", concat::probe_arguments(sources[i]), on_finished);
+        }
+    }));
+    auto num_probed = std::count_if(probe_results.cbegin(), probe_results.cend(),
+                                    [](const auto &result) { return result.has_value(); });
+    if (num_probed != num_files) {
+        qWarning() << "only" << num_probed << "of" << num_files << "files were probed";
+        return results;
+    }
+
+    results.push_back(measure("index", num_files, [&](std::function<void()> done) {
+        index->save();
+        index = std::make_unique<concat::LibraryIndex>(dir.filePath("library_index.json"));
+        for (const auto &source : sources) {
+            if (not index->find(QFileInfo(source)).has_value()) {
+                qWarning() << source << "is missing in index";
+            }
+        }
+        done();
+    }));
+
+    QList<concat::EncodeJob> jobs;
+    results.push_back(measure("plan", num_files, [&](std::function<void()> done) {
+        auto output_info = preset();
+        for (int i = 0; i < num_files; i++) {
+            const auto &source_info = probe_results[i]->info;
+            auto plan = concat::plan_transcode(source_info, output_info);
+            concat::EncodeJob job;
+            job.program = "ffmpeg";
+            job.input_path = sources[i];
+            job.output_path = dir.filePath(QString("outputs/%1").arg(QFileInfo(sources[i]).fileName()));
+            job.arguments = plan.arguments(job.input_path, output_info) << "-n" << job.output_path;
+            job.length = probe_results[i]->length;
+            job.cost = concat::estimate_cost(source_info, output_info, job.length);
+            job.memory = concat::estimate_memory(source_info, output_info);
+            jobs.push_back(job);
+        }
+        done();
+    }));
+
+    results.push_back(measure("encode", num_files, [&](std::function<void()> done) {
+        auto num_failed = std::make_shared<int>(0);
+        QObject::connect(&scheduler, &concat::EncodeScheduler::job_finished,
+                         [num_failed](int, bool is_success) { *num_failed += is_success ? 0 : 1; });
+        QObject::connect(&scheduler, &concat::EncodeScheduler::idle, [num_failed, done] {
+            if (*num_failed > 0) {
+                qWarning() << *num_failed << "jobs failed";
+            }
+            done();
+        });
+        for (const auto &job : jobs) {
+            scheduler.enqueue(job);
+        }
+    }));
+    return results;
+}
+void print(QTextStream &out, const QList<PhaseResult> &results) {
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+               .arg("phase", -8)
+               .arg("files", 7)
+               .arg("msec", 9)
+               .arg("files/s", 10)
+               .arg("max lat", 8)
+               .arg("mean lat", 9)
+               .arg("rss +KiB", 10);
+    for (const auto &result : results) {
+        auto throughput = result.elapsed_msec == 0 ? 0.0 : result.num_files * 1000.0 / result.elapsed_msec;
+        out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+                   .arg(result.name, -8)
+                   .arg(result.num_files, 7)
+                   .arg(result.elapsed_msec, 9)
+                   .arg(throughput, 10, 'f', 1)
+                   .arg(result.max_latency_msec, 8)
+                   .arg(result.mean_latency_msec, 9, 'f', 2)
+                   .arg(result.memory_growth / 1024, 10);
+    }
+    out.flush();
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("benchmark of orchestration layer with stub ffmpeg and ffprobe");
+    parser.addHelpOption();
+    QCommandLineOption sizes_option("sizes", "comma separated numbers of files", "sizes");
+    QCommandLineOption large_option("large", "add 50000 files to default sizes");
+    QCommandLineOption concurrency_option("concurrency", "concurrent processes of probe and encode", "count",
+                                          QString::number(QThread::idealThreadCount()));
+    QCommandLineOption stubs_option("stubs", "directory of stub ffmpeg and ffprobe", "directory",
+                                    QString(VIDEOS_RE_ENCODER_BENCH_STUBS_DIR));
+    parser.addOptions({sizes_option, large_option, concurrency_option, stubs_option});
+    parser.process(app);
+
+    QList<int> sizes = parser.isSet(large_option) ? LARGE_SIZES : DEFAULT_SIZES;
+    if (parser.isSet(sizes_option)) {
+        sizes.clear();
+        for (const auto &size : parser.value(sizes_option).split(',', Qt::SkipEmptyParts)) {
+            bool ok = false;
+            auto value = size.toInt(&ok);
+            if (not ok || value <= 0) {
+                qCritical() << "invalid size" << size;
+                return 1;
+            }
+            sizes.push_back(value);
+        }
+    }
+    bool ok = false;
+    auto concurrency = parser.value(concurrency_option).toInt(&ok);
+    if (not ok || concurrency <= 0) {
+        qCritical() << "invalid concurrency" << parser.value(concurrency_option);
+        return 1;
+    }
+    auto stubs_dir = QDir(parser.value(stubs_option)).absolutePath();
+    if (not QFileInfo::exists(QDir(stubs_dir).filePath("ffprobe"))) {
+        qCritical() << "stubs are not found in" << stubs_dir;
+        return 1;
+    }
+    auto path = QDir::toNativeSeparators(stubs_dir) + QDir::listSeparator() + qEnvironmentVariable("PATH");
+    qputenv("PATH", path.toLocal8Bit());
+
+    QTextStream out(stdout);
+    out << "concurrency: " << concurrency << ", rss: " << resident_memory() / 1024 << " KiB\n";
+    for (auto size : sizes) {
+        out << "\n";
+        print(out, run(size, concurrency));
+    }
+    return 0;
+}
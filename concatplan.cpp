@@ -0,0 +1,180 @@
+#include "concatplan.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QTextStream>
+#include <QtDebug>
+#include <algorithm>
+#include <ciso646>
+#include <cmath>
+#include <optional>
+
+#include "encodecost.hpp"
+#include "trimplan.hpp"
+
+namespace concat {
+namespace {
+constexpr double FRAMERATE_TOLERANCE = 0.001;
+bool has_same_codec(const SelectableVariant<QString> &one, const SelectableVariant<QString> &the_other) {
+    auto one_value = std::get_if<QString>(&one);
+    auto the_other_value = std::get_if<QString>(&the_other);
+    return one_value != nullptr && the_other_value != nullptr && *one_value == *the_other_value;
+}
+bool has_same_framerate(const RangedVariant<double> &one, const RangedVariant<double> &the_other) {
+    auto one_value = std::get_if<double>(&one);
+    auto the_other_value = std::get_if<double>(&the_other);
+    return one_value != nullptr && the_other_value != nullptr &&
+           std::abs(*one_value - *the_other_value) <= FRAMERATE_TOLERANCE;
+}
+/// encoder writing audio codec, for codecs whose native encoder is experimental or missing
+QString audio_encoder_of_codec(const QString &codec) {
+    static const QHash<QString, QString> encoders{{"opus", "libopus"}, {"mp3", "libmp3lame"}, {"vorbis", "libvorbis"}};
+    return encoders.value(codec, codec);
+}
+/// timescale of mp4/mov track from time base like "1/15360"
+std::optional<QString> timescale_of(const QString &time_base) {
+    auto parts = time_base.split('/');
+    if (parts.size() != 2 || parts[0] != "1") {
+        return std::nullopt;
+    }
+    return parts[1];
+}
+}  // namespace
+bool is_concat_compatible(const ConcatInput &one, const ConcatInput &the_other) {
+    auto one_resolution = std::get_if<QSize>(&one.info.resolution);
+    auto the_other_resolution = std::get_if<QSize>(&the_other.info.resolution);
+    return one_resolution != nullptr && the_other_resolution != nullptr && *one_resolution == *the_other_resolution &&
+           has_same_framerate(one.info.framerate, the_other.info.framerate) &&
+           has_same_codec(one.info.video_codec, the_other.info.video_codec) &&
+           has_same_codec(one.info.audio_codec, the_other.info.audio_codec) && one.time_base == the_other.time_base &&
+           one.format == the_other.format;
+}
+ConcatPlan plan_concat(const QList<ConcatInput> &inputs, const QDir &work_dir, const QString &suffix,
+                       const TranscodeOptions &options) {
+    ConcatPlan plan;
+    if (inputs.isEmpty()) {
+        return plan;
+    }
+    // the format shared by the longest total length is the target, as re-encoding it would cost the most
+    qsizetype reference = 0;
+    std::chrono::milliseconds longest{-1};
+    for (qsizetype i = 0; i < inputs.size(); i++) {
+        std::chrono::milliseconds length{0};
+        for (const auto &input : inputs) {
+            if (is_concat_compatible(inputs[i], input)) {
+                length += input.length;
+            }
+        }
+        if (length > longest) {
+            longest = length;
+            reference = i;
+        }
+    }
+    const auto &reference_info = inputs[reference].info;
+    const auto &reference_format = inputs[reference].format;
+    auto target_info = reference_info;
+    auto timescale = timescale_of(inputs[reference].time_base);
+    auto is_mp4 = QStringList{"mp4", "mov", "m4v"}.contains(suffix.toLower());
+    if (timescale.has_value() && is_mp4) {
+        plan.output_arguments = {"-video_track_timescale", timescale.value()};
+    }
+    auto reference_video_codec = std::get_if<QString>(&reference_info.video_codec);
+    auto reference_audio_codec = std::get_if<QString>(&reference_info.audio_codec);
+    bool is_normalized = std::any_of(inputs.cbegin(), inputs.cend(), [&](const ConcatInput &input) {
+        return not is_concat_compatible(inputs[reference], input);
+    });
+    auto part_suffix = suffix;
+    if (is_normalized && reference_video_codec != nullptr && segment_suffix(*reference_video_codec) == "ts") {
+        part_suffix = "ts";
+    } else {
+        target_info.encoding_args = plan.output_arguments;
+    }
+    for (qsizetype i = 0; i < inputs.size(); i++) {
+        const auto &input = inputs[i];
+        plan.length += input.length;
+        auto output_path = work_dir.filePath(QStringLiteral("%1.%2").arg(i).arg(part_suffix));
+        EncodeJob job;
+        job.program = "ffmpeg";
+        job.input_path = input.path;
+        job.output_path = output_path;
+        job.length = input.length;
+        if (is_concat_compatible(inputs[reference], input)) {
+            if (part_suffix == suffix) {
+                plan.parts << input.path;
+                continue;
+            }
+            job.arguments = QStringList{"-i", input.path, "-map", "0:v:0", "-map", "0:a:0?", "-c", "copy", "-n",
+                                        output_path};
+            job.cost = estimate_cost(VideoInfo(), VideoInfo(), input.length);  // stream copy
+            plan.normalizations << job;
+            plan.parts << output_path;
+            continue;
+        }
+        auto transcode = plan_transcode(input.info, target_info, options);
+        // streams of the same codec may still differ in format, and are re-encoded then
+        bool video_format_differs =
+            input.format.pix_fmt != reference_format.pix_fmt || input.format.profile != reference_format.profile;
+        if (reference_video_codec != nullptr && (transcode.video_is_encoded || video_format_differs)) {
+            transcode.video_is_encoded = true;
+            transcode.video_codec = encoder_of_codec(*reference_video_codec);
+        }
+        bool audio_format_differs = input.format.sample_rate != reference_format.sample_rate ||
+                                    input.format.channels != reference_format.channels;
+        if (reference_audio_codec != nullptr && (transcode.audio_is_encoded || audio_format_differs)) {
+            transcode.audio_is_encoded = true;
+            transcode.audio_codec = audio_encoder_of_codec(*reference_audio_codec);
+        }
+        job.arguments = transcode.arguments(input.path, target_info);
+        if (transcode.video_is_encoded) {
+            if (not reference_format.pix_fmt.isEmpty()) {
+                job.arguments << "-pix_fmt" << reference_format.pix_fmt;
+            }
+            auto profile = profile_of(transcode.video_codec, reference_format.profile);
+            if (profile.has_value()) {
+                job.arguments << "-profile:v" << profile.value();
+            }
+        }
+        if (transcode.audio_is_encoded) {
+            if (reference_format.sample_rate > 0) {
+                job.arguments << "-ar" << QString::number(reference_format.sample_rate);
+            }
+            if (reference_format.channels > 0) {
+                job.arguments << "-ac" << QString::number(reference_format.channels);
+            }
+        }
+        job.arguments << "-n" << output_path;
+        job.cost = estimate_cost(input.info, target_info, input.length, options);
+        job.memory = estimate_memory(input.info, target_info, options);
+        plan.normalizations << job;
+        plan.parts << output_path;
+    }
+    return plan;
+}
+bool write_concat_list(const QString &list_path, const QStringList &parts) {
+    QFile file(list_path);
+    if (not file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qWarning() << "failed to write" << list_path;
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << "ffconcat version 1.0\n";
+    for (const auto &part : parts) {
+        auto escaped = QFileInfo(part).absoluteFilePath().replace("'", R"('\'')");
+        stream << "file '" << escaped << "'\n";
+    }
+    return true;
+}
+EncodeJob create_concat_job(const QString &list_path, const QString &output_path, std::chrono::milliseconds length,
+                            const QStringList &output_arguments) {
+    EncodeJob job;
+    job.program = "ffmpeg";
+    job.arguments = QStringList{"-f", "concat", "-safe", "0", "-i", list_path, "-map", "0", "-c", "copy"}
+                    << output_arguments << "-n" << output_path;
+    job.input_path = list_path;
+    job.output_path = output_path;
+    job.length = length;
+    job.cost = estimate_cost(VideoInfo(), VideoInfo(), length);  // stream copy
+    return job;
+}
+}  // namespace concat
@@ -0,0 +1,73 @@
+#ifndef VIDEO_RE_ENCODER_CONCATPLAN
+#define VIDEO_RE_ENCODER_CONCATPLAN
+
+#include <QDir>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <chrono>
+
+#include "encodescheduler.hpp"
+#include "proberesult.hpp"
+#include "transcodeplan.hpp"
+#include "videoinfo.hpp"
+
+namespace concat {
+struct ConcatInput {
+    QString path;
+    /// info of source, whose references are resolved
+    VideoInfo info;
+    /// time base of video stream reported by ffprobe, such as "1/15360"
+    QString time_base;
+    std::chrono::milliseconds length{0};
+    StreamFormat format;
+};
+/**
+ * @brief how inputs are joined into one output
+ * @details inputs which have the same format as the most common one (by length) are joined as they are with the
+ * concat demuxer and stream copy. only the other inputs are re-encoded to that format beforehand, with pixel format,
+ * profile, sample rate and channels of it.
+ * when anything is re-encoded and the codec keeps parameter sets in-band in mpegts, every part is written as mpegts,
+ * so that parameter sets of re-encoded parts reach decoder, as is done by plan_trim(). compatible inputs are then
+ * remuxed by stream copy.
+ */
+struct ConcatPlan {
+    /// jobs re-encoding incompatible inputs. they can run concurrently
+    QList<EncodeJob> normalizations;
+    /// files joined in order, which are either inputs or outputs of normalizations
+    QStringList parts;
+    std::chrono::milliseconds length{0};
+    /// options of output given to create_concat_job(), such as timescale of track of reference
+    QStringList output_arguments;
+};
+/**
+ * @brief whether two inputs can be joined by the concat demuxer with stream copy
+ */
+bool is_concat_compatible(const ConcatInput &one, const ConcatInput &the_other);
+/**
+ * @brief plan joining inputs in order
+ *
+ * @param inputs
+ * @param work_dir directory where normalized inputs are written
+ * @param suffix suffix of output, used for normalized inputs
+ * @param options
+ */
+ConcatPlan plan_concat(const QList<ConcatInput> &inputs, const QDir &work_dir, const QString &suffix,
+                       const TranscodeOptions &options = TranscodeOptions());
+/**
+ * @brief write list of files read by the concat demuxer
+ */
+bool write_concat_list(const QString &list_path, const QStringList &parts);
+/**
+ * @brief job joining files in list with stream copy
+ *
+ * @param list_path
+ * @param output_path
+ * @param length
+ * @param output_arguments output_arguments of ConcatPlan
+ */
+EncodeJob create_concat_job(const QString &list_path, const QString &output_path, std::chrono::milliseconds length,
+                            const QStringList &output_arguments = QStringList());
+}  // namespace concat
+
+#endif
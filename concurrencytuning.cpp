@@ -0,0 +1,161 @@
+#include "concurrencytuning.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtDebug>
+#include <ciso646>
+
+#include "ffmpegprogress.hpp"
+
+namespace concat {
+namespace {
+/**
+ * @brief frame threads of x265 for threads in its pool, which follows what x265 picks for number of cpus
+ */
+int x265_frame_threads(int threads) {
+    if (threads >= 32) {
+        return 6;
+    }
+    if (threads >= 16) {
+        return 5;
+    }
+    if (threads >= 8) {
+        return 3;
+    }
+    return threads >= 4 ? 2 : 1;
+}
+}  // namespace
+QString resolution_class(const QSize &resolution) {
+    auto lines = qMin(resolution.width(), resolution.height());
+    for (auto lines_of_class : {2160, 1440, 1080, 720, 480}) {
+        // a little smaller frames, such as cropped ones, belong to the same class
+        if (lines >= lines_of_class * 9 / 10) {
+            return QStringLiteral("%1p").arg(lines_of_class);
+        }
+    }
+    return lines > 0 ? QStringLiteral("sd") : QStringLiteral("unknown");
+}
+QStringList thread_arguments(QStringList arguments, const QString &video_codec, int threads) {
+    if (threads <= 0 || arguments.isEmpty() || video_codec == "copy") {
+        return arguments;
+    }
+    if (video_codec == "libx265") {
+        auto params = QStringLiteral("pools=%1:frame-threads=%2").arg(threads).arg(x265_frame_threads(threads));
+        auto index = arguments.indexOf("-x265-params");
+        if (index >= 0 && index + 1 < arguments.size()) {
+            arguments[index + 1] += ':' + params;
+        } else {
+            arguments.insert(arguments.size() - 1, "-x265-params");
+            arguments.insert(arguments.size() - 1, params);
+        }
+        return arguments;
+    }
+    arguments.insert(arguments.size() - 1, "-threads");
+    arguments.insert(arguments.size() - 1, QString::number(threads));
+    return arguments;
+}
+QList<ThreadConfig> tuning_candidates(int num_cpus) {
+    QList<ThreadConfig> result;
+    num_cpus = qMax(num_cpus, 1);
+    for (auto jobs = 1; jobs <= num_cpus; jobs *= 2) {
+        result.push_back({jobs, qMax(num_cpus / jobs, 1)});
+        result.push_back({jobs, 0});
+    }
+    return result;
+}
+ConcurrencyTuner::ConcurrencyTuner(QObject *parent) : QObject(parent) {}
+ConcurrencyTuner::~ConcurrencyTuner() { cancel(); }
+void ConcurrencyTuner::tune(const EncodeJob &job, const QString &video_codec, int num_cpus) {
+    cancel();
+    job_ = job;
+    video_codec_ = video_codec;
+    window_ = spread_windows(job.length, 1, SAMPLE_DURATION).first();
+    candidates_ = tuning_candidates(num_cpus);
+    if (job.arguments.indexOf("-i") < 0 || not dir_.isValid()) {
+        for (const auto &config : candidates_) {
+            results_.push_back({config, 0.0, false});
+        }
+        emit finished(results_);
+        return;
+    }
+    start_candidate_();
+}
+void ConcurrencyTuner::cancel() {
+    for (auto process : running_) {
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished();
+        process->deleteLater();
+    }
+    running_.clear();
+    results_.clear();
+    candidates_.clear();
+}
+std::optional<TuningResult> ConcurrencyTuner::best(const QList<TuningResult> &results) {
+    std::optional<TuningResult> result;
+    for (const auto &candidate : results) {
+        if (candidate.is_success &&
+            (not result.has_value() || candidate.frames_per_second > result->frames_per_second)) {
+            result = candidate;
+        }
+    }
+    return result;
+}
+void ConcurrencyTuner::start_candidate_() {
+    const auto &config = candidates_[results_.size()];
+    frames_ = 0;
+    has_failed_ = false;
+    timer_.start();
+    auto suffix = QFileInfo(job_.output_path).suffix();
+    for (auto i = 0; i < config.concurrent_jobs; i++) {
+        auto arguments = job_.arguments;
+        // output path is the last argument, and -n is harmless as samples are written to a new directory
+        arguments.last() = dir_.filePath(QStringLiteral("%1_%2.%3").arg(results_.size()).arg(i).arg(suffix));
+        auto input = arguments.indexOf("-i");
+        auto input_args = window_.input_args();
+        for (auto j = 0; j < input_args.size(); j++) {
+            arguments.insert(input + j, input_args[j]);
+        }
+        arguments = thread_arguments(arguments, video_codec_, config.threads);
+        auto process = new QProcess(this);
+        connect(process, &QProcess::finished, this, [this, process](int exit_code, QProcess::ExitStatus exit_status) {
+            finish_process_(process, exit_status == QProcess::NormalExit && exit_code == 0);
+        });
+        connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                finish_process_(process, false);
+            }
+        });
+        running_.push_back(process);
+        process->start(job_.program, arguments);
+    }
+}
+void ConcurrencyTuner::finish_process_(QProcess *process, bool is_success) {
+    if (not running_.removeOne(process)) {
+        return;
+    }
+    auto stderr_text = QString::fromUtf8(process->readAllStandardError());
+    auto frames = parse_ffmpeg_frame(stderr_text);
+    if (is_success && frames.has_value()) {
+        frames_ += frames.value();
+    } else {
+        qWarning() << "tuning encode failed" << process->arguments() << stderr_text.right(1000);
+        has_failed_ = true;
+    }
+    QFile::remove(process->arguments().last());
+    process->deleteLater();
+    if (not running_.isEmpty()) {
+        return;
+    }
+    auto elapsed = static_cast<double>(timer_.elapsed()) / 1000.0;
+    auto config = candidates_[results_.size()];
+    results_.push_back({config, has_failed_ || elapsed <= 0.0 ? 0.0 : static_cast<double>(frames_) / elapsed,
+                        not has_failed_});
+    emit progressed(static_cast<int>(results_.size()), num_candidates());
+    if (results_.size() < candidates_.size()) {
+        start_candidate_();
+    } else {
+        emit finished(results_);
+    }
+}
+}  // namespace concat
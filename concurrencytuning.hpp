@@ -0,0 +1,105 @@
+#ifndef VIDEO_RE_ENCODER_CONCURRENCYTUNING
+#define VIDEO_RE_ENCODER_CONCURRENCYTUNING
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <chrono>
+#include <optional>
+
+#include "encodescheduler.hpp"
+#include "samplewindows.hpp"
+
+namespace concat {
+/**
+ * @brief split of cpus between concurrent jobs and threads of each job
+ */
+struct ThreadConfig {
+    int concurrent_jobs = 1;
+    /// threads of encoder of each job. 0 means default of encoder
+    int threads = 0;
+};
+struct TuningResult {
+    ThreadConfig config;
+    /// frames written per second by every job in total
+    double frames_per_second = 0.0;
+    bool is_success = true;
+};
+/**
+ * @brief class of resolution which tuned configs are kept per, such as "1080p"
+ */
+QString resolution_class(const QSize &resolution);
+/**
+ * @brief arguments of ffmpeg whose video encoder uses threads
+ * @details libx265 takes thread pool and frame threads from -x265-params, which are merged into existing one.
+ * other encoders take -threads. options are put before the last argument, which is the output path.
+ *
+ * @param arguments arguments of ffmpeg writing one output
+ * @param video_codec encoder of video, or "copy"
+ * @param threads threads of encoder. arguments are returned as they are if this is 0 or less
+ */
+QStringList thread_arguments(QStringList arguments, const QString &video_codec, int threads);
+/**
+ * @brief configs compared by ConcurrencyTuner
+ * @details concurrent jobs are powers of 2 up to num_cpus. each is tried with cpus divided evenly between jobs, and
+ * with default threads of encoder, which is how jobs are run unless tuned.
+ */
+QList<ThreadConfig> tuning_candidates(int num_cpus);
+/**
+ * @brief find the best split of cpus between concurrent jobs and threads per job by encoding an excerpt of a job
+ * @details for each candidate, as many copies of the excerpt as concurrent jobs are encoded at once, and frames
+ * written by all of them per second of wall time are compared. candidates are run one after another so that they
+ * don't disturb each other.
+ */
+class ConcurrencyTuner : public QObject {
+    Q_OBJECT
+
+   public:
+    static constexpr std::chrono::seconds SAMPLE_DURATION{10};
+    explicit ConcurrencyTuner(QObject *parent = nullptr);
+    ~ConcurrencyTuner();
+    /**
+     * @brief start sweep. finished() is emitted after every candidate is measured.
+     *
+     * @param job sample job writing one output
+     * @param video_codec encoder of video of job
+     * @param num_cpus
+     */
+    void tune(const EncodeJob &job, const QString &video_codec, int num_cpus);
+    /**
+     * @brief stop sweep. finished() is not emitted.
+     */
+    void cancel();
+    int num_candidates() const { return static_cast<int>(candidates_.size()); }
+    /**
+     * @brief successful result with the most frames per second, or std::nullopt if every candidate failed
+     */
+    static std::optional<TuningResult> best(const QList<TuningResult> &results);
+
+   signals:
+    void progressed(int num_finished_candidates, int num_candidates);
+    void finished(QList<concat::TuningResult> results);
+
+   private:
+    QTemporaryDir dir_;
+    EncodeJob job_;
+    QString video_codec_;
+    SampleWindow window_{};
+    QList<ThreadConfig> candidates_;
+    QList<TuningResult> results_;
+    QList<QProcess *> running_;
+    QElapsedTimer timer_;
+    qint64 frames_ = 0;
+    bool has_failed_ = false;
+
+    void start_candidate_();
+    void finish_process_(QProcess *process, bool is_success);
+};
+}  // namespace concat
+
+#endif
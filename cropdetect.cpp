@@ -0,0 +1,90 @@
+#include "cropdetect.hpp"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QtDebug>
+#include <ciso646>
+#include <memory>
+
+namespace concat {
+namespace {
+constexpr int NUM_WINDOWS = 5;
+constexpr std::chrono::seconds WINDOW_DURATION{2};
+/// crops removing less than this ratio of pixels are ignored
+constexpr double MIN_REMOVED_RATIO = 0.02;
+qint64 area_of(const QRect &rect) { return static_cast<qint64>(rect.width()) * rect.height(); }
+}  // namespace
+QStringList cropdetect_arguments(const QString &path, const SampleWindow &window) {
+    QStringList result{"-hide_banner", "-nostats"};
+    // round=2 keeps as much picture as chroma subsampling allows. default of 16 cuts into it
+    result << window.input_args() << "-i" << path;
+    result << "-map" << "0:v:0" << "-vf" << "cropdetect=round=2" << "-f" << "null" << "-";
+    return result;
+}
+QList<QRect> parse_cropdetect(const QString &stderr_text) {
+    static const QRegularExpression crop_pattern(R"(crop=(-?\d+):(-?\d+):(-?\d+):(-?\d+))");
+    QList<QRect> result;
+    auto it = crop_pattern.globalMatch(stderr_text);
+    while (it.hasNext()) {
+        auto match = it.next();
+        QRect rect(match.captured(3).toInt(), match.captured(4).toInt(), match.captured(1).toInt(),
+                   match.captured(2).toInt());
+        if (rect.width() > 0 && rect.height() > 0 && rect.x() >= 0 && rect.y() >= 0) {
+            result.push_back(rect);
+        }
+    }
+    return result;
+}
+std::optional<QRect> settle_crop(const QList<QList<QRect>> &windows, const QSize &source_resolution) {
+    QRect result;
+    for (const auto &rects : windows) {
+        QHash<QString, int> counts;
+        QRect mode;
+        int mode_count = 0;
+        for (const auto &rect : rects) {
+            auto key = QStringLiteral("%1:%2:%3:%4").arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height());
+            auto count = ++counts[key];
+            if (count > mode_count || (count == mode_count && area_of(rect) > area_of(mode))) {
+                mode = rect;
+                mode_count = count;
+            }
+        }
+        if (mode_count > 0) {
+            result = result.isNull() ? mode : result.united(mode);
+        }
+    }
+    QRect frame(QPoint(0, 0), source_resolution);
+    result = result.intersected(frame);
+    if (result.isEmpty() || area_of(result) > area_of(frame) * (1.0 - MIN_REMOVED_RATIO)) {
+        return std::nullopt;
+    }
+    // union of even rectangles may have odd size, which most encoders reject
+    result.setWidth(result.width() / 2 * 2);
+    result.setHeight(result.height() / 2 * 2);
+    return result;
+}
+void detect_crop(ProcessRunner *runner, const QString &path, std::chrono::milliseconds length,
+                 const QSize &source_resolution, std::function<void(std::optional<QRect>)> done, int priority) {
+    struct State {
+        QList<QList<QRect>> windows;
+        int num_remaining;
+    };
+    auto windows = spread_windows(length, NUM_WINDOWS, WINDOW_DURATION);
+    auto state = std::make_shared<State>(State{{}, static_cast<int>(windows.size())});
+    for (const auto &window : windows) {
+        runner->run(
+            "ffmpeg", cropdetect_arguments(path, window),
+            [state, done, path, source_resolution](const ProcessResult &result) {
+                if (result.is_success) {
+                    state->windows.push_back(parse_cropdetect(result.stderr_text));
+                } else {
+                    qWarning() << "failed to detect crop of" << path << result.stderr_text.right(1000) + result.error;
+                }
+                if (--state->num_remaining == 0) {
+                    done(settle_crop(state->windows, source_resolution));
+                }
+            },
+            priority);
+    }
+}
+}  // namespace concat
@@ -0,0 +1,47 @@
+#ifndef VIDEO_RE_ENCODER_CROPDETECT
+#define VIDEO_RE_ENCODER_CROPDETECT
+
+#include <QList>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <chrono>
+#include <functional>
+#include <optional>
+
+#include "processrunner.hpp"
+#include "samplewindows.hpp"
+
+namespace concat {
+/**
+ * @brief arguments of ffmpeg which run cropdetect over window of video and discard output
+ */
+QStringList cropdetect_arguments(const QString &path, const SampleWindow &window);
+/**
+ * @brief rectangles reported by cropdetect, such as "crop=1920:800:0:140", in order. empty ones of black frames are
+ * skipped.
+ *
+ * @param stderr_text stderr of ffmpeg run with cropdetect_arguments()
+ */
+QList<QRect> parse_cropdetect(const QString &stderr_text);
+/**
+ * @brief crop which is safe for every window
+ * @details the most frequent rectangle of each window is taken, so that dark scenes don't make crop too small, and
+ * their union is returned, so that no window loses picture.
+ *
+ * @param windows rectangles of each window
+ * @param source_resolution
+ * @return std::nullopt if crop would remove too little to be worth encoding, or nothing was detected
+ */
+std::optional<QRect> settle_crop(const QList<QList<QRect>> &windows, const QSize &source_resolution);
+/**
+ * @brief run cropdetect on a few windows of file in parallel and settle crop by settle_crop()
+ *
+ * @param done called with crop when every window is analyzed
+ */
+void detect_crop(ProcessRunner *runner, const QString &path, std::chrono::milliseconds length,
+                 const QSize &source_resolution, std::function<void(std::optional<QRect>)> done, int priority = 0);
+}  // namespace concat
+
+#endif
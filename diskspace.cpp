@@ -0,0 +1,126 @@
+#include "diskspace.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <ciso646>
+#include <initializer_list>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#else
+#include <QStorageInfo>
+#endif
+
+namespace concat {
+namespace {
+constexpr double DEFAULT_AUDIO_BITRATE = 192'000.0;
+/// container overhead and overshoot of rate control
+constexpr double OUTPUT_SIZE_MARGIN = 1.2;
+constexpr double BITS_PER_BYTE = 8.0;
+/// bits per pixel at usual quality, when neither bitrate nor history is available
+double bits_per_pixel(const QString &encoder) {
+    for (const auto &codec : {"av1", "rav1e"}) {
+        if (encoder.contains(QLatin1String(codec))) {
+            return 0.05;
+        }
+    }
+    for (const auto &codec : {"265", "hevc", "kvazaar", "vp9"}) {
+        if (encoder.contains(QLatin1String(codec))) {
+            return 0.07;
+        }
+    }
+    return 0.1;
+}
+std::optional<double> bitrate_option(const QVector<QString> &args, std::initializer_list<const char *> options) {
+    for (const auto &option : options) {
+        auto index = args.indexOf(QLatin1String(option));
+        if (index >= 0 && index + 1 < args.size()) {
+            return parse_bitrate(args[index + 1]);
+        }
+    }
+    return std::nullopt;
+}
+}  // namespace
+std::optional<DiskSpace> read_disk_space(const QString &path) {
+    auto dir = QFileInfo(path).absolutePath();
+    while (not QFileInfo::exists(dir)) {
+        auto parent = QFileInfo(dir).absolutePath();
+        if (parent == dir) {
+            return std::nullopt;
+        }
+        dir = parent;
+    }
+#ifdef Q_OS_UNIX
+    auto native_dir = QFile::encodeName(dir);
+    struct statvfs filesystem;
+    struct stat status;
+    if (::statvfs(native_dir.constData(), &filesystem) != 0 || ::stat(native_dir.constData(), &status) != 0) {
+        return std::nullopt;
+    }
+    return DiskSpace{static_cast<quint64>(status.st_dev),
+                     static_cast<qint64>(filesystem.f_bavail) * static_cast<qint64>(filesystem.f_frsize)};
+#else
+    QStorageInfo storage(dir);
+    if (not storage.isValid()) {
+        return std::nullopt;
+    }
+    return DiskSpace{qHash(storage.rootPath()), storage.bytesAvailable()};
+#endif
+}
+std::optional<double> parse_bitrate(const QString &text) {
+    static const QRegularExpression pattern(R"(^(\d+(?:\.\d+)?)([kKmMgG]?)$)");
+    auto match = pattern.match(text.trimmed());
+    if (not match.hasMatch()) {
+        return std::nullopt;
+    }
+    auto value = match.captured(1).toDouble();
+    auto prefix = match.captured(2).toLower();
+    if (prefix == "k") {
+        value *= 1e3;
+    } else if (prefix == "m") {
+        value *= 1e6;
+    } else if (prefix == "g") {
+        value *= 1e9;
+    }
+    return value;
+}
+qint64 estimate_output_size(const VideoInfo &source_info, const VideoInfo &output_info, const TranscodePlan &plan,
+                            std::chrono::milliseconds length, qint64 source_size,
+                            std::optional<double> bitrate_history) {
+    if (not plan.video_is_encoded && not plan.audio_is_encoded) {
+        return source_size;
+    }
+    auto seconds = std::chrono::duration<double>(length).count();
+    auto video_bitrate = bitrate_option(output_info.encoding_args, {"-b:v", "-maxrate"});
+    if (plan.video_is_encoded && not video_bitrate.has_value() && bitrate_history.has_value()) {
+        // history is bitrate of whole output, including audio
+        return static_cast<qint64>(bitrate_history.value() * seconds / BITS_PER_BYTE * OUTPUT_SIZE_MARGIN);
+    }
+    double bits = 0.0;
+    if (not plan.video_is_encoded) {
+        bits += static_cast<double>(source_size) * BITS_PER_BYTE;  // copied video takes most of source
+    } else if (video_bitrate.has_value()) {
+        bits += video_bitrate.value() * seconds;
+    } else {
+        auto resolution = std::get_if<QSize>(&output_info.resolution);
+        if (resolution == nullptr) {
+            resolution = std::get_if<QSize>(&source_info.resolution);
+        }
+        auto framerate = std::get_if<double>(&output_info.framerate);
+        if (framerate == nullptr || *framerate <= 0.0) {
+            framerate = std::get_if<double>(&source_info.framerate);
+        }
+        if (resolution != nullptr && framerate != nullptr) {
+            bits += static_cast<double>(resolution->width()) * resolution->height() * *framerate *
+                    bits_per_pixel(plan.video_codec) * seconds;
+        } else {
+            bits += static_cast<double>(source_size) * BITS_PER_BYTE;
+        }
+    }
+    // when video is copied, size of source includes its audio too. it is counted twice, which errs on the safe side
+    bits += bitrate_option(output_info.encoding_args, {"-b:a"}).value_or(DEFAULT_AUDIO_BITRATE) * seconds;
+    return static_cast<qint64>(bits / BITS_PER_BYTE * OUTPUT_SIZE_MARGIN);
+}
+}  // namespace concat
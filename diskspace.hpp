@@ -0,0 +1,47 @@
+#ifndef VIDEO_RE_ENCODER_DISKSPACE
+#define VIDEO_RE_ENCODER_DISKSPACE
+
+#include <QString>
+#include <QtGlobal>
+#include <chrono>
+#include <optional>
+
+#include "transcodeplan.hpp"
+#include "videoinfo.hpp"
+
+namespace concat {
+struct DiskSpace {
+    /// id of filesystem, which is equal for paths on the same filesystem
+    quint64 device = 0;
+    /// bytes available to unprivileged user
+    qint64 available = 0;
+};
+/**
+ * @brief free space of filesystem which path is written to, read with statvfs
+ *
+ * @param path path of file, which doesn't have to exist yet. its nearest existing ancestor is examined
+ * @return std::nullopt if it is not available
+ */
+std::optional<DiskSpace> read_disk_space(const QString &path);
+/**
+ * @brief parse bitrate of ffmpeg option, such as "800k" or "2.5M", in bits per second
+ */
+std::optional<double> parse_bitrate(const QString &text);
+/**
+ * @brief rough size of output in bytes, which is rather overestimated so that output is unlikely to exceed it
+ * @details size is estimated from the first available of target bitrate in encoding args, bitrate of previous
+ * outputs with the same settings, and bits per pixel typical of the encoder. copied streams take as much as in source.
+ *
+ * @param source_info info of input file
+ * @param output_info info of output file. references must be resolved
+ * @param plan plan of transcode from source_info to output_info
+ * @param length length of input file
+ * @param source_size size of input file in bytes
+ * @param bitrate_history bitrate of previous outputs in bits per second. see SpeedHistory::output_bitrate()
+ */
+qint64 estimate_output_size(const VideoInfo &source_info, const VideoInfo &output_info, const TranscodePlan &plan,
+                            std::chrono::milliseconds length, qint64 source_size,
+                            std::optional<double> bitrate_history = std::nullopt);
+}  // namespace concat
+
+#endif
@@ -0,0 +1,122 @@
+#include "encodecost.hpp"
+
+#include <QMap>
+#include <QRegularExpression>
+#include <cmath>
+#include <ciso646>
+#include <optional>
+
+namespace concat {
+namespace {
+constexpr double REFERENCE_PIXEL_RATE = 1920.0 * 1080.0 * 60.0;  // pixels per second encoded by reference machine
+constexpr double COPY_SPEED = 200.0;                              // realtime factor of remuxing
+constexpr double AUDIO_ENCODE_SPEED = 100.0;                      // realtime factor of encoding audio
+constexpr double DEFAULT_FRAMERATE = 30.0;
+constexpr qint64 BASE_MEMORY = 128 * 1024 * 1024;  // ffmpeg itself, demuxer, muxer and audio
+constexpr double NUM_DECODED_FRAMES = 16.0;        // frames buffered by decoder and filters
+constexpr double BYTES_PER_PIXEL = 1.5;            // 8 bit yuv420p
+template <class T>
+std::optional<T> value_of(const std::variant<SameAsHighest<T>, SameAsLowest<T>, T, ValueRange<T>> &value) {
+    if (std::holds_alternative<T>(value)) {
+        return std::get<T>(value);
+    }
+    return std::nullopt;
+}
+/**
+ * @brief number of frames encoder keeps, such as lookahead and reference frames
+ */
+double num_encoder_frames(const QString &codec) {
+    static const QMap<QString, double> frames{
+        {"libx264", 60.0},    {"h264", 60.0},       {"libx265", 120.0}, {"hevc", 120.0},     {"libvpx-vp9", 60.0},
+        {"vp9", 60.0},        {"libaom-av1", 150.0}, {"av1", 150.0},     {"libsvtav1", 200.0}, {"mpeg4", 8.0},
+    };
+    if (codec.contains("nvenc") || codec.contains("qsv") || codec.contains("vaapi") || codec.contains("amf") ||
+        codec.contains("videotoolbox")) {
+        return 16.0;  // hardware encoders keep frames in device memory
+    }
+    return frames.value(codec, 60.0);
+}
+/**
+ * @brief whether output has more than 8 bits per sample, which doubles size of frames
+ */
+bool is_high_bit_depth(const QVector<QString> &encoding_args) {
+    auto pix_fmt = encoding_args.indexOf("-pix_fmt");
+    if (pix_fmt < 0 || pix_fmt + 1 >= encoding_args.size()) {
+        return false;
+    }
+    static const QRegularExpression pattern(R"((1[0246]|p01[026]))");
+    return pattern.match(encoding_args[pix_fmt + 1]).hasMatch();
+}
+/**
+ * @brief resolution of encoded frames, which is that of cropped picture if output keeps resolution of source
+ */
+std::optional<QSize> encoded_resolution(const VideoInfo &source_info, const VideoInfo &output_info,
+                                        const TranscodeOptions &options) {
+    auto source_resolution = value_of(source_info.resolution);
+    auto output_resolution = value_of(output_info.resolution);
+    if (options.crop.has_value() && options.crop->isValid() &&
+        (not output_resolution.has_value() || output_resolution == source_resolution)) {
+        return options.crop->size();
+    }
+    return output_resolution.has_value() ? output_resolution : source_resolution;
+}
+}  // namespace
+double video_codec_factor(const QString &codec) {
+    static const QMap<QString, double> factors{
+        {"h264", 1.0}, {"libx264", 1.0},    {"hevc", 3.0},       {"libx265", 3.0},   {"vp9", 4.0},
+        {"av1", 8.0},  {"libvpx-vp9", 4.0}, {"libaom-av1", 10.0}, {"libsvtav1", 3.0}, {"mpeg4", 0.3},
+    };
+    if (codec.contains("nvenc") || codec.contains("qsv") || codec.contains("vaapi") || codec.contains("amf") ||
+        codec.contains("videotoolbox")) {
+        return 0.2;  // hardware encoders
+    }
+    return factors.value(codec, 1.5);
+}
+double preset_factor(const QVector<QString> &encoding_args) {
+    static const QMap<QString, double> factors{
+        {"ultrafast", 0.3}, {"superfast", 0.4}, {"veryfast", 0.5}, {"faster", 0.7}, {"fast", 0.85},
+        {"medium", 1.0},    {"slow", 1.6},      {"slower", 2.5},   {"veryslow", 5.0}, {"placebo", 10.0},
+    };
+    auto preset = encoding_args.indexOf("-preset");
+    if (preset < 0 || preset + 1 >= encoding_args.size()) {
+        return 1.0;
+    }
+    return factors.value(encoding_args[preset + 1], 1.0);
+}
+double estimate_cost(const VideoInfo &source_info, const VideoInfo &output_info, std::chrono::milliseconds length,
+                     const TranscodeOptions &options) {
+    auto seconds = std::chrono::duration<double>(length).count();
+    auto plan = plan_transcode(source_info, output_info, options);
+    double cost = seconds / COPY_SPEED;
+    if (plan.audio_is_encoded) {
+        cost += seconds / AUDIO_ENCODE_SPEED;
+    }
+    if (plan.video_is_encoded) {
+        auto resolution = encoded_resolution(source_info, output_info, options).value_or(QSize{1920, 1080});
+        auto framerate = value_of(output_info.framerate).value_or(value_of(source_info.framerate).value_or(0.0));
+        if (not(framerate > 0.0)) {
+            framerate = DEFAULT_FRAMERATE;
+        }
+        auto pixels = static_cast<double>(resolution.width()) * resolution.height() * framerate * seconds;
+        cost += pixels / REFERENCE_PIXEL_RATE * video_codec_factor(plan.video_codec) *
+                preset_factor(output_info.encoding_args);
+    }
+    return cost;
+}
+qint64 estimate_memory(const VideoInfo &source_info, const VideoInfo &output_info, const TranscodeOptions &options) {
+    auto plan = plan_transcode(source_info, output_info, options);
+    if (not plan.video_is_encoded) {
+        return BASE_MEMORY;
+    }
+    // decoder writes whole frames, before they are cropped
+    auto source_size = value_of(source_info.resolution).value_or(QSize{1920, 1080});
+    auto output_size = encoded_resolution(source_info, output_info, options).value_or(source_size);
+    auto decoded_frame = static_cast<double>(source_size.width()) * source_size.height() * BYTES_PER_PIXEL;
+    auto encoded_frame = static_cast<double>(output_size.width()) * output_size.height() * BYTES_PER_PIXEL *
+                         (is_high_bit_depth(output_info.encoding_args) ? 2.0 : 1.0);
+    // slower presets use more reference frames and longer lookahead
+    auto num_frames = num_encoder_frames(plan.video_codec) *
+                      qMax(1.0, std::sqrt(preset_factor(output_info.encoding_args)));
+    return BASE_MEMORY + static_cast<qint64>(decoded_frame * NUM_DECODED_FRAMES + encoded_frame * num_frames);
+}
+}  // namespace concat
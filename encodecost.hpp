@@ -0,0 +1,45 @@
+#ifndef VIDEO_RE_ENCODER_ENCODECOST
+#define VIDEO_RE_ENCODER_ENCODECOST
+
+#include <QString>
+#include <QtGlobal>
+#include <QVector>
+#include <chrono>
+
+#include "transcodeplan.hpp"
+#include "videoinfo.hpp"
+
+namespace concat {
+/**
+ * @brief rough cost of encoding a video, in seconds of a reference machine encoding 1080p60 with libx264 medium in
+ * realtime.
+ * @note only the ratio between costs matters, so this is not expected to match actual wall time.
+ *
+ * @param source_info info of input file
+ * @param output_info info of output file. references must be resolved
+ * @param length length of input file
+ * @param options options of transcode, such as crop which makes video encoded and leaves fewer pixels to encode
+ */
+double estimate_cost(const VideoInfo &source_info, const VideoInfo &output_info, std::chrono::milliseconds length,
+                     const TranscodeOptions &options = TranscodeOptions());
+/**
+ * @brief rough peak memory used by ffmpeg encoding a video, in bytes
+ * @details frames decoded and buffered by encoder (lookahead and reference frames) dominate memory usage.
+ *
+ * @param source_info info of input file
+ * @param output_info info of output file. references must be resolved
+ * @param options options of transcode
+ */
+qint64 estimate_memory(const VideoInfo &source_info, const VideoInfo &output_info,
+                       const TranscodeOptions &options = TranscodeOptions());
+/**
+ * @brief speed factor of encoder relative to libx264. larger is slower.
+ */
+double video_codec_factor(const QString &codec);
+/**
+ * @brief speed factor of x264/x265 style `-preset` found in args relative to medium. larger is slower.
+ */
+double preset_factor(const QVector<QString> &encoding_args);
+}  // namespace concat
+
+#endif
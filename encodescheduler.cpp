@@ -0,0 +1,715 @@
+#include "encodescheduler.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QtDebug>
+#include <algorithm>
+#include <ciso646>
+#include <numeric>
+
+#include "diskspace.hpp"
+#include "ffmpegprogress.hpp"
+#include "procfs.hpp"
+#include "remoteworker.hpp"
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#endif
+
+namespace concat {
+namespace {
+constexpr qint64 MIB = 1024 * 1024;
+#ifdef Q_OS_UNIX
+bool send_signal(QProcess *process, int signal) {
+    if (::kill(static_cast<pid_t>(process->processId()), signal) != 0) {
+        qWarning() << "failed to send signal" << signal << "to" << process->processId() << std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+bool stop_process(QProcess *process) { return send_signal(process, SIGSTOP); }
+bool continue_process(QProcess *process) { return send_signal(process, SIGCONT); }
+#else
+bool stop_process(QProcess *) { return false; }
+bool continue_process(QProcess *) { return false; }
+#endif
+}  // namespace
+EncodeScheduler::EncodeScheduler(QObject *parent) : QObject(parent) {
+    memory_timer_.setInterval(MEMORY_POLLING_INTERVAL_MSEC);
+    connect(&memory_timer_, &QTimer::timeout, this, &EncodeScheduler::poll_memory_);
+    load_timer_.setInterval(LOAD_POLLING_INTERVAL_MSEC);
+    connect(&load_timer_, &QTimer::timeout, this, &EncodeScheduler::poll_load_);
+    disk_timer_.setInterval(DISK_POLLING_INTERVAL_MSEC);
+    connect(&disk_timer_, &QTimer::timeout, this, &EncodeScheduler::retry_held_);
+}
+EncodeScheduler::~EncodeScheduler() {
+    for (auto &entry : jobs_) {
+        if (entry.process != nullptr) {
+            entry.process->disconnect(this);
+            entry.process->kill();
+            entry.process->waitForFinished();
+        }
+    }
+}
+void EncodeScheduler::set_max_concurrent_jobs(int max_concurrent_jobs) {
+    max_concurrent_jobs_ = qMax(max_concurrent_jobs, 1);
+    dispatch_();
+}
+void EncodeScheduler::set_memory_budget(qint64 memory_budget) {
+    memory_budget_ = qMax(memory_budget, qint64(0));
+    dispatch_();
+}
+void EncodeScheduler::set_min_free_disk_space(qint64 min_free_disk_space) {
+    min_free_disk_space_ = qMax(min_free_disk_space, qint64(0));
+    retry_held_();
+}
+void EncodeScheduler::set_overflow_dir(const QString &overflow_dir) {
+    overflow_dir_ = overflow_dir;
+    retry_held_();
+}
+void EncodeScheduler::set_adaptive_concurrency(bool is_enabled, int min_concurrent_jobs,
+                                               const LoadThresholds &thresholds) {
+    is_concurrency_adaptive_ = is_enabled;
+    min_concurrent_jobs_ = qMax(min_concurrent_jobs, 1);
+    load_thresholds_ = thresholds;
+    if (is_enabled) {
+        load_timer_.start();
+    } else {
+        load_timer_.stop();
+        max_concurrent_jobs_under_load_ = 0;
+    }
+    dispatch_();
+}
+int EncodeScheduler::enqueue(const EncodeJob &job) {
+    auto id = next_id_++;
+    if (is_idle()) {
+        batch_.clear();
+        max_concurrent_jobs_after_out_of_memory_ = 0;
+    }
+    jobs_.insert(id, {job});
+    queue_.push_back(id);
+    batch_.push_back(id);
+    dispatch_();
+    return id;
+}
+void EncodeScheduler::cancel(int id) {
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return;
+    }
+    switch (it->state) {
+        case JobState::queued:
+        case JobState::running:
+        case JobState::paused:
+            queue_.removeOne(id);
+            held_.removeOne(id);
+            it->state = JobState::canceled;
+            if (it->remote != nullptr) {
+                it->remote->cancel(id);  // finish_() is called when worker reports
+                break;
+            }
+            if (it->process != nullptr) {
+                it->process->kill();  // finish_() is called from QProcess::finished. SIGKILL terminates stopped one too
+                break;
+            }
+            emit job_finished(id, false);
+            dispatch_();
+            if (is_idle()) {
+                emit idle();
+            }
+            break;
+        default:
+            break;
+    }
+}
+bool EncodeScheduler::can_pause() {
+#ifdef Q_OS_UNIX
+    return true;
+#else
+    return false;
+#endif
+}
+void EncodeScheduler::pause(int id) {
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return;
+    }
+    switch (it->state) {
+        case JobState::queued:
+            queue_.removeOne(id);
+            held_.removeOne(id);
+            it->state = JobState::paused;
+            if (it->process == nullptr) {  // otherwise it is already stopped by preemption
+                emit job_paused(id);
+            }
+            break;
+        case JobState::running:
+            if (it->remote == nullptr && stop_(id)) {
+                it->state = JobState::paused;
+                dispatch_();
+            }
+            break;
+        default:
+            break;
+    }
+}
+void EncodeScheduler::resume(int id) {
+    auto it = jobs_.find(id);
+    if (it == jobs_.end() || it->state != JobState::paused) {
+        return;
+    }
+    it->state = JobState::queued;
+    queue_.push_back(id);
+    dispatch_();
+}
+void EncodeScheduler::set_priority(int id, int priority) {
+    auto it = jobs_.find(id);
+    if (it == jobs_.end() || it->job.priority == priority) {
+        return;
+    }
+    it->job.priority = priority;
+    if (it->process != nullptr) {
+        renice_(id);
+    }
+    dispatch_();
+}
+void EncodeScheduler::add_remote_worker(RemoteWorker *worker) {
+    worker->setParent(this);
+    remote_workers_.push_back(worker);
+    connect(worker, &RemoteWorker::job_output, this, [this](int id, QString stdout_text, QString stderr_text) {
+        if (not stdout_text.isEmpty()) {
+            emit job_output(id, stdout_text, QString());
+        }
+        if (not stderr_text.isEmpty()) {
+            handle_stderr_(id, stderr_text);
+        }
+    });
+    connect(worker, &RemoteWorker::job_finished, this, &EncodeScheduler::finish_);
+    connect(worker, &RemoteWorker::jobs_lost, this, &EncodeScheduler::requeue_lost_);
+    connect(worker, &RemoteWorker::ready, this, &EncodeScheduler::dispatch_);
+}
+void EncodeScheduler::clear_remote_workers() {
+    QList<int> ids;
+    for (auto it = jobs_.cbegin(); it != jobs_.cend(); ++it) {
+        if (it->remote != nullptr) {
+            ids.push_back(it.key());
+        }
+    }
+    for (auto worker : remote_workers_) {
+        worker->disconnect(this);
+        worker->deleteLater();  // worker kills jobs of closed connection
+    }
+    remote_workers_.clear();
+    requeue_lost_(ids);
+}
+void EncodeScheduler::cancel_all() {
+    for (auto id : jobs_.keys()) {
+        cancel(id);
+    }
+}
+int EncodeScheduler::num_running() const {
+    return static_cast<int>(std::count_if(jobs_.cbegin(), jobs_.cend(),
+                                          [](const Entry &entry) { return entry.state == JobState::running; }));
+}
+int EncodeScheduler::num_paused() const {
+    return static_cast<int>(std::count_if(jobs_.cbegin(), jobs_.cend(),
+                                          [](const Entry &entry) { return entry.state == JobState::paused; }));
+}
+bool EncodeScheduler::is_started_before(const EncodeJob &one, const EncodeJob &the_other) {
+    if (one.priority != the_other.priority) {
+        return one.priority > the_other.priority;
+    }
+    return one.cost > the_other.cost;
+}
+std::chrono::milliseconds EncodeScheduler::estimate_makespan(QList<EncodeJob> jobs, int max_concurrent_jobs) {
+    std::stable_sort(jobs.begin(), jobs.end(), is_started_before);
+    QList<std::chrono::milliseconds> finish_times(qMax(max_concurrent_jobs, 1), std::chrono::milliseconds(0));
+    for (const auto &job : jobs) {
+        *std::min_element(finish_times.begin(), finish_times.end()) += job.predicted_duration;
+    }
+    return *std::max_element(finish_times.begin(), finish_times.end());
+}
+int EncodeScheduler::effective_max_concurrent_jobs_() const {
+    auto result = max_concurrent_jobs_;
+    if (max_concurrent_jobs_under_load_ > 0) {
+        result = qMin(result, qMax(max_concurrent_jobs_under_load_, min_concurrent_jobs_));
+    }
+    if (max_concurrent_jobs_after_out_of_memory_ > 0) {
+        result = qMin(result, max_concurrent_jobs_after_out_of_memory_);
+    }
+    return result;
+}
+std::chrono::milliseconds EncodeScheduler::elapsed_time(int id) const {
+    const auto &entry = entry_(id);
+    if (not entry.timer.isValid()) {
+        return entry.wall_time;
+    }
+    return entry.wall_time + std::chrono::milliseconds(entry.timer.elapsed());
+}
+int EncodeScheduler::max_concurrent_jobs_with_(int id) const {
+    auto result = effective_max_concurrent_jobs_();
+    auto limit = [&result](const EncodeJob &job) {
+        if (job.max_concurrent_jobs > 0) {
+            result = qMin(result, job.max_concurrent_jobs);
+        }
+    };
+    limit(job(id));
+    for (const auto &entry : jobs_) {
+        if (entry.state == JobState::running && entry.remote == nullptr) {
+            limit(entry.job);
+        }
+    }
+    return result;
+}
+int EncodeScheduler::num_running_locally_() const {
+    return static_cast<int>(std::count_if(jobs_.cbegin(), jobs_.cend(), [](const Entry &entry) {
+        return entry.state == JobState::running && entry.remote == nullptr;
+    }));
+}
+RemoteWorker *EncodeScheduler::free_remote_worker_() const {
+    RemoteWorker *result = nullptr;
+    for (auto worker : remote_workers_) {
+        if (not worker->has_free_slot()) {
+            continue;
+        }
+        if (result == nullptr ||
+            worker->num_slots() - worker->num_running() > result->num_slots() - result->num_running()) {
+            result = worker;
+        }
+    }
+    return result;
+}
+qint64 EncodeScheduler::memory_of_(int id) const {
+    const auto &entry = *jobs_.find(id);
+    return qMax(entry.job.memory, entry.peak_resident_memory);
+}
+bool EncodeScheduler::is_killed_for_memory_(int id) const {
+    const auto &entry = entry_(id);
+    auto oom_kills = read_oom_kill_count();
+    if (entry.oom_kills_at_start.has_value() && oom_kills.has_value()) {
+        return oom_kills.value() > entry.oom_kills_at_start.value();
+    }
+    auto pressure = read_pressure("memory");
+    if (pressure.has_value()) {
+        return pressure->some >= OUT_OF_MEMORY_PRESSURE;
+    }
+    return true;  // nothing tells, and lack of memory is the likely cause
+}
+const EncodeScheduler::Entry &EncodeScheduler::entry_(int id) const {
+    Q_ASSERT(contains(id));
+    static const Entry unknown{EncodeJob(), JobState::canceled};
+    auto it = jobs_.find(id);
+    return it == jobs_.end() ? unknown : *it;
+}
+qint64 EncodeScheduler::reserved_memory() const {
+    qint64 result = 0;
+    for (auto it = jobs_.cbegin(); it != jobs_.cend(); ++it) {
+        if (it->process != nullptr) {
+            result += memory_of_(it.key());
+        }
+    }
+    return result;
+}
+bool EncodeScheduler::has_memory_for_(int id) const {
+    if (memory_budget_ <= 0 || jobs_.find(id)->process != nullptr) {
+        return true;  // memory of stopped process is already reserved
+    }
+    auto reserved = reserved_memory();
+    return reserved == 0 || reserved + memory_of_(id) <= memory_budget_;  // a job always runs even if it's too large
+}
+void EncodeScheduler::poll_memory_() {
+    bool has_process = false;
+    for (auto &entry : jobs_) {
+        if (entry.process == nullptr) {
+            continue;
+        }
+        has_process = true;
+        auto resident_memory = read_resident_memory(entry.process->processId());
+        if (resident_memory.has_value()) {
+            entry.peak_resident_memory = qMax(entry.peak_resident_memory, resident_memory.value());
+        }
+    }
+    if (not has_process) {
+        memory_timer_.stop();
+    }
+}
+std::optional<double> EncodeScheduler::read_load_ratio_() const {
+    std::optional<double> result;
+    auto add = [&result](std::optional<double> load, double threshold) {
+        if (load.has_value() && threshold > 0.0) {
+            result = qMax(result.value_or(0.0), load.value() / threshold);
+        }
+    };
+    const std::pair<QString, double> pressure_thresholds[] = {{"cpu", load_thresholds_.cpu_pressure},
+                                                              {"memory", load_thresholds_.memory_pressure},
+                                                              {"io", load_thresholds_.io_pressure}};
+    for (const auto &[resource, threshold] : pressure_thresholds) {
+        auto pressure = read_pressure(resource);
+        add(pressure.has_value() ? std::optional(pressure->some) : std::nullopt, threshold);
+    }
+    auto load_average = read_load_average();
+    if (load_average.has_value()) {
+        add(load_average.value() / qMax(QThread::idealThreadCount(), 1), load_thresholds_.load_per_cpu);
+    }
+    return result;
+}
+void EncodeScheduler::poll_load_() {
+    auto ratio = read_load_ratio_();
+    if (not ratio.has_value()) {
+        return;
+    }
+    auto current = effective_max_concurrent_jobs_();
+    auto next = max_concurrent_jobs_under_load_ > 0 ? max_concurrent_jobs_under_load_ : max_concurrent_jobs_;
+    if (ratio.value() >= 1.0) {
+        // lower from the number of jobs actually running, so that it takes effect at the next poll
+        next = qMax(min_concurrent_jobs_, qMin(next, num_running_locally_()) - 1);
+    } else if (ratio.value() < LOAD_LOW_WATERMARK) {
+        next++;
+    }
+    max_concurrent_jobs_under_load_ = next >= max_concurrent_jobs_ ? 0 : next;
+    if (effective_max_concurrent_jobs_() == current) {
+        return;
+    }
+    qDebug() << "load of system is" << ratio.value() << "of threshold. concurrency:"
+             << effective_max_concurrent_jobs_();
+    emit concurrency_adapted(effective_max_concurrent_jobs_());
+    shed_jobs_();
+    dispatch_();
+}
+void EncodeScheduler::shed_jobs_() {
+    // paused jobs keep their progress and are continued when load goes down. where pausing isn't supported, extra
+    // jobs are left to finish and new ones are deferred
+    while (can_pause() && num_running_locally_() > effective_max_concurrent_jobs_()) {
+        auto id = preemptee_();
+        if (id < 0 || not stop_(id)) {
+            break;
+        }
+        jobs_[id].state = JobState::queued;
+        queue_.push_back(id);
+    }
+}
+bool EncodeScheduler::has_disk_space_for_(int id, const QString &output_path) const {
+    auto space = disk_space_of_(output_path);
+    if (not space.has_value()) {
+        return true;
+    }
+    // free space already excludes what running jobs have written, so only the rest of their outputs is reserved
+    qint64 reserved = 0;
+    for (auto it = jobs_.cbegin(); it != jobs_.cend(); ++it) {
+        if (it.key() == id || (it->process == nullptr && it->remote == nullptr) || it->job.output_size <= 0) {
+            continue;
+        }
+        auto other_space = disk_space_of_(it->job.output_path);
+        if (other_space.has_value() && other_space->device == space->device) {
+            reserved += qMax(qint64(0), it->job.output_size - QFileInfo(it->job.output_path).size());
+        }
+    }
+    return space->available - reserved - min_free_disk_space_ >= job(id).output_size;
+}
+std::optional<DiskSpace> EncodeScheduler::disk_space_of_(const QString &path) const {
+    auto dir = QFileInfo(path).absolutePath();
+    auto found = disk_spaces_.constFind(dir);
+    if (found != disk_spaces_.cend()) {
+        return *found;
+    }
+    return *disk_spaces_.insert(dir, read_disk_space(path));
+}
+bool EncodeScheduler::admit_to_disk_(int id) {
+    auto &entry = jobs_[id];
+    // stopped process has already reserved its space
+    if (entry.process != nullptr || entry.job.output_size <= 0 || entry.job.output_path.isEmpty() ||
+        has_disk_space_for_(id, entry.job.output_path)) {
+        return true;
+    }
+    // renditions are kept together rather than only one of them being redirected
+    if (not overflow_dir_.isEmpty() && entry.job.extra_output_paths.isEmpty()) {
+        auto output_path = QDir(overflow_dir_).filePath(QFileInfo(entry.job.output_path).fileName());
+        if (not QFile::exists(output_path) && has_disk_space_for_(id, output_path)) {
+            redirect_(id, output_path);
+            return true;
+        }
+    }
+    queue_.removeOne(id);
+    held_.push_back(id);
+    if (not entry.is_held) {
+        entry.is_held = true;
+        qWarning() << "job" << id << "is held for lack of disk space. estimated output size:" << entry.job.output_size;
+        emit job_output(id, QString(),
+                        tr("waiting for %1 MiB of free disk space\n").arg(entry.job.output_size / MIB));
+        emit job_held(id);
+    }
+    if (not disk_timer_.isActive()) {
+        disk_timer_.start();
+    }
+    return false;
+}
+void EncodeScheduler::redirect_(int id, const QString &output_path) {
+    auto &entry = jobs_[id];
+    // ffmpeg takes output path as the last argument
+    auto index = entry.job.arguments.lastIndexOf(entry.job.output_path);
+    if (index >= 0) {
+        entry.job.arguments[index] = output_path;
+    }
+    entry.job.output_path = output_path;
+    emit job_output(id, QString(), tr("output is redirected to %1 for lack of disk space\n").arg(output_path));
+    emit job_redirected(id, output_path);
+}
+void EncodeScheduler::retry_held_() {
+    disk_timer_.stop();
+    queue_.append(held_);
+    held_.clear();
+    dispatch_();
+}
+void EncodeScheduler::dispatch_() {
+    disk_spaces_.clear();
+    while (not queue_.isEmpty()) {
+        std::stable_sort(queue_.begin(), queue_.end(),
+                         [this](int one, int the_other) { return is_started_before(job(one), job(the_other)); });
+        if (not admit_to_disk_(queue_.first())) {
+            continue;
+        }
+        auto has_memory = has_memory_for_(queue_.first());
+        if (has_memory && num_running_locally_() < max_concurrent_jobs_with_(queue_.first())) {
+            start_(queue_.takeFirst());
+            continue;
+        }
+        // memory of remote jobs is not counted in local budget. jobs stopped by preemption are continued locally
+        auto worker = free_remote_worker_();
+        if (worker != nullptr && jobs_[queue_.first()].process == nullptr) {
+            start_remote_(queue_.takeFirst(), worker);
+            continue;
+        }
+        if (not has_memory) {
+            break;  // starting smaller jobs instead would starve large ones
+        }
+        auto preemptee = preemptee_();
+        if (not can_pause() || preemptee < 0 || job(preemptee).priority >= job(queue_.first()).priority) {
+            break;
+        }
+        if (not stop_(preemptee)) {
+            break;
+        }
+        auto id = queue_.takeFirst();
+        jobs_[preemptee].state = JobState::queued;
+        queue_.push_back(preemptee);
+        start_(id);
+    }
+}
+int EncodeScheduler::preemptee_() const {
+    int result = -1;
+    for (auto it = jobs_.cbegin(); it != jobs_.cend(); ++it) {
+        if (it->state != JobState::running || it->remote != nullptr) {
+            continue;
+        }
+        // among jobs with the same priority, the one started last has the least work to lose
+        if (result < 0 || it->job.priority <= job(result).priority) {
+            result = it.key();
+        }
+    }
+    return result;
+}
+void EncodeScheduler::start_(int id) {
+    auto &entry = jobs_[id];
+    if (entry.process != nullptr) {
+        continue_(id);
+        return;
+    }
+    entry.state = JobState::running;
+    entry.is_held = false;
+    entry.process = new QProcess(this);
+    entry.oom_kills_at_start = read_oom_kill_count();
+    connect(entry.process, &QProcess::readyReadStandardOutput, this, [this, id] {
+        emit job_output(id, QString::fromUtf8(jobs_[id].process->readAllStandardOutput()), QString());
+    });
+    connect(entry.process, &QProcess::readyReadStandardError, this, [this, id] { read_stderr_(id); });
+    connect(entry.process, &QProcess::finished, this, [this, id](int exit_code, QProcess::ExitStatus exit_status) {
+#ifdef Q_OS_UNIX
+        // the OOM killer sends SIGKILL, and so do users and other programs. kill by cancel() is told by state
+        if (exit_status == QProcess::CrashExit && exit_code == SIGKILL && is_killed_for_memory_(id)) {
+            jobs_[id].is_out_of_memory = true;
+        }
+#endif
+        finish_(id, exit_status == QProcess::NormalExit && exit_code == 0);
+    });
+    connect(entry.process, &QProcess::errorOccurred, this, [this, id](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            qWarning() << "failed to start" << jobs_[id].job.program << jobs_[id].process->errorString();
+            finish_(id, false);
+        }
+    });
+    connect(entry.process, &QProcess::started, this, [this, id] { renice_(id); });
+    emit job_started(id);
+    entry.timer.start();
+    entry.process->start(entry.job.program, entry.job.arguments);
+    if (not memory_timer_.isActive()) {
+        memory_timer_.start();
+    }
+}
+void EncodeScheduler::start_remote_(int id, RemoteWorker *worker) {
+    auto &entry = jobs_[id];
+    entry.state = JobState::running;
+    entry.is_held = false;
+    entry.remote = worker;
+    emit job_started(id);
+    emit job_output(id, QString(), tr("sent to worker %1\n").arg(worker->name()));
+    entry.timer.start();
+    worker->start(id, entry.job);
+}
+bool EncodeScheduler::stop_(int id) {
+    auto &entry = jobs_[id];
+    if (not stop_process(entry.process)) {
+        return false;
+    }
+    entry.wall_time += std::chrono::milliseconds(entry.timer.elapsed());
+    entry.timer.invalidate();
+    emit job_paused(id);
+    return true;
+}
+void EncodeScheduler::continue_(int id) {
+    auto &entry = jobs_[id];
+    entry.state = JobState::running;
+    entry.timer.start();
+    if (continue_process(entry.process)) {
+        emit job_resumed(id);
+    }
+}
+void EncodeScheduler::renice_([[maybe_unused]] int id) {
+#ifdef Q_OS_UNIX
+    const auto &entry = jobs_[id];
+    auto niceness = qBound(0, -entry.job.priority, MAX_NICENESS);
+    auto pid = static_cast<id_t>(entry.process->processId());
+    errno = 0;
+    auto current = getpriority(PRIO_PROCESS, pid);
+    if (errno != 0 || current == niceness) {
+        return;
+    }
+    if (setpriority(PRIO_PROCESS, pid, niceness) != 0) {
+        qWarning() << "failed to renice" << entry.process->processId() << "to" << niceness << std::strerror(errno);
+    }
+#endif
+}
+void EncodeScheduler::read_stderr_(int id) {
+    handle_stderr_(id, QString::fromUtf8(jobs_[id].process->readAllStandardError()));
+}
+void EncodeScheduler::handle_stderr_(int id, const QString &text) {
+    auto &entry = jobs_[id];
+    emit job_output(id, QString(), text);
+    // concurrency is lowered only for lack of local memory
+    if (entry.remote == nullptr && text.contains(QStringLiteral("Cannot allocate memory"))) {  // strerror(ENOMEM)
+        entry.is_out_of_memory = true;
+    }
+    auto time = parse_ffmpeg_time(text);
+    if (time.has_value()) {
+        entry.processed = qMin(time.value(), entry.job.length);
+        emit job_progressed(id, entry.processed);
+    }
+}
+double EncodeScheduler::batch_total_cost() const {
+    return std::accumulate(batch_.cbegin(), batch_.cend(), 0.0,
+                           [this](double sum, int id) { return sum + job(id).cost; });
+}
+double EncodeScheduler::batch_finished_cost() const {
+    return std::accumulate(batch_.cbegin(), batch_.cend(), 0.0, [this](double sum, int id) {
+        const auto &entry = *jobs_.find(id);
+        switch (entry.state) {
+            case JobState::queued:
+                return sum;
+            case JobState::running:
+            case JobState::paused:
+                if (entry.job.length.count() <= 0) {
+                    return sum;
+                }
+                return sum + entry.job.cost * static_cast<double>(entry.processed.count()) /
+                                 static_cast<double>(entry.job.length.count());
+            default:
+                return sum + entry.job.cost;  // jobs which failed are not going to take time any more
+        }
+    });
+}
+void EncodeScheduler::requeue_(int id) {
+    auto &entry = jobs_[id];
+    qWarning() << "job" << id << "ran out of memory. peak resident memory:" << entry.peak_resident_memory;
+    // state of this job is still running, so it is counted in num_running_locally_()
+    // remote jobs don't use local memory
+    max_concurrent_jobs_after_out_of_memory_ = qMax(1, num_running_locally_() - 1);
+    entry.job.memory = static_cast<qint64>(static_cast<double>(qMax(entry.job.memory, entry.peak_resident_memory)) *
+                                           OUT_OF_MEMORY_MARGIN);
+    entry.num_out_of_memory++;
+    entry.is_out_of_memory = false;
+    discard_progress_(id);
+    entry.state = JobState::queued;
+    queue_.push_back(id);
+    emit job_requeued(id);
+    dispatch_();
+}
+void EncodeScheduler::discard_progress_(int id) {
+    auto &entry = jobs_[id];
+    entry.peak_resident_memory = 0;
+    entry.processed = std::chrono::milliseconds(0);
+    entry.wall_time = std::chrono::milliseconds(0);
+    entry.timer.invalidate();
+    // ffmpeg is run with -n, so existing output is the partial one written by this job
+    for (const auto &output_path : QStringList{entry.job.output_path} + entry.job.extra_output_paths) {
+        if (not output_path.isEmpty() && QFile::exists(output_path) && not QFile::remove(output_path)) {
+            qWarning() << "failed to remove partial output" << output_path;
+        }
+    }
+}
+void EncodeScheduler::requeue_lost_(const QList<int> &ids) {
+    for (auto id : ids) {
+        auto &entry = jobs_[id];
+        if (entry.remote == nullptr) {
+            continue;
+        }
+        qWarning() << "lost connection to worker running job" << id;
+        entry.remote = nullptr;
+        if (entry.state == JobState::canceled) {
+            emit job_finished(id, false);
+            continue;
+        }
+        discard_progress_(id);
+        entry.state = JobState::queued;
+        queue_.push_back(id);
+        emit job_requeued(id);
+    }
+    dispatch_();
+    if (is_idle()) {
+        emit idle();
+    }
+}
+void EncodeScheduler::finish_(int id, bool is_success) {
+    auto &entry = jobs_[id];
+    if (entry.process == nullptr && entry.remote == nullptr) {
+        return;
+    }
+    if (entry.process != nullptr) {
+        entry.process->deleteLater();
+        entry.process = nullptr;
+    }
+    entry.remote = nullptr;
+    if (entry.timer.isValid()) {
+        entry.wall_time += std::chrono::milliseconds(entry.timer.elapsed());
+        entry.timer.invalidate();
+    }
+    queue_.removeOne(id);  // preempted process may die while it is stopped
+    if (entry.state == JobState::running && not is_success && entry.is_out_of_memory &&
+        entry.num_out_of_memory < MAX_OUT_OF_MEMORY_RETRIES) {
+        requeue_(id);
+        return;
+    }
+    if (entry.state == JobState::running || entry.state == JobState::queued || entry.state == JobState::paused) {
+        entry.state = is_success ? JobState::finished : JobState::failed;
+    }
+    emit job_finished(id, entry.state == JobState::finished);
+    retry_held_();  // output may be smaller than its reservation
+    if (is_idle()) {
+        emit idle();
+    }
+}
+}  // namespace concat
@@ -0,0 +1,331 @@
+#ifndef VIDEO_RE_ENCODER_ENCODESCHEDULER
+#define VIDEO_RE_ENCODER_ENCODESCHEDULER
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <chrono>
+#include <optional>
+
+#include "diskspace.hpp"
+
+namespace concat {
+class RemoteWorker;
+struct EncodeJob {
+    QString program;
+    QStringList arguments;
+    QString input_path;
+    QString output_path;
+    /// outputs written by the same process besides output_path, such as renditions. see rendition_arguments()
+    QStringList extra_output_paths;
+    std::chrono::milliseconds length{0};
+    /// estimated cost. see estimate_cost()
+    double cost = 0.0;
+    /// jobs with higher priority start first. jobs with same priority start in descending order of cost
+    int priority = 0;
+    /// predicted wall time. see SpeedHistory
+    std::chrono::milliseconds predicted_duration{0};
+    /// estimated peak memory in bytes. see estimate_memory()
+    qint64 memory = 0;
+    /// estimated size of output in bytes. see estimate_output_size(). 0 means unknown
+    qint64 output_size = 0;
+    /// jobs run locally at once while this job runs, including itself, as tuned by ConcurrencyTuner. 0 means no limit
+    int max_concurrent_jobs = 0;
+};
+/**
+ * @brief levels of system load above which fewer jobs are run. see EncodeScheduler::set_adaptive_concurrency()
+ * @details pressures are "some" avg10 of /proc/pressure/*, in percent. 0 disables the threshold.
+ */
+struct LoadThresholds {
+    double cpu_pressure = 60.0;
+    double memory_pressure = 10.0;
+    double io_pressure = 40.0;
+    /// 1 minute load average divided by number of cpus
+    double load_per_cpu = 1.5;
+};
+/**
+ * @brief run encode jobs concurrently.
+ * @details queued jobs are started longest-processing-time-first, so that long job doesn't run alone at the end of
+ * batch and total wall time of batch is kept short.
+ * when a job with higher priority is queued while every slot is used, running job with the lowest priority is paused
+ * (SIGSTOP) instead of being killed, and is resumed (SIGCONT) when a slot becomes free again.
+ * jobs are started only while sum of memory of jobs having process, which is the larger of the estimated one and
+ * the measured resident set size, stays under memory budget. jobs killed for lack of memory are requeued and
+ * concurrency is lowered until the batch finishes.
+ * when every local slot is used, jobs are sent to free slots of remote workers. remote jobs can't be paused, and
+ * they are put back to queue if connection to the worker is lost.
+ * jobs are started only while estimated size of their output fits free space of its filesystem, less outputs
+ * still being written by running jobs. jobs which don't fit are held, or redirected to overflow directory unless they
+ * write several outputs.
+ * jobs with tuned concurrency are started only while as many jobs as the smallest tuned one of them run locally.
+ * concurrency can also follow load of the system, so that encodes leave room for other services on shared machines.
+ */
+class EncodeScheduler : public QObject {
+    Q_OBJECT
+
+   public:
+    /// queued jobs include ones paused by preemption and ones held for disk space. paused means paused by pause()
+    enum class JobState { queued, running, paused, finished, failed, canceled };
+    explicit EncodeScheduler(QObject *parent = nullptr);
+    ~EncodeScheduler();
+    void set_max_concurrent_jobs(int max_concurrent_jobs);
+    int max_concurrent_jobs() const { return max_concurrent_jobs_; }
+    /**
+     * @brief set memory budget of jobs in bytes. 0 means unlimited.
+     */
+    void set_memory_budget(qint64 memory_budget);
+    qint64 memory_budget() const { return memory_budget_; }
+    /**
+     * @brief set free space in bytes left on each filesystem after outputs of running jobs are written
+     */
+    void set_min_free_disk_space(qint64 min_free_disk_space);
+    qint64 min_free_disk_space() const { return min_free_disk_space_; }
+    /**
+     * @brief set directory outputs are written to when their own filesystem is full. empty means they are held.
+     */
+    void set_overflow_dir(const QString &overflow_dir);
+    QString overflow_dir() const { return overflow_dir_; }
+    /**
+     * @brief adapt number of local jobs to load of the system between min_concurrent_jobs and max_concurrent_jobs()
+     * @details pressure stall information and load average are polled. while any of them exceeds its threshold,
+     * concurrency is lowered by one per poll, and running jobs above it are paused and put back to queue instead of
+     * being killed. concurrency is raised by one per poll while every one of them is below half of its threshold.
+     */
+    void set_adaptive_concurrency(bool is_enabled, int min_concurrent_jobs = 1,
+                                  const LoadThresholds &thresholds = LoadThresholds());
+    bool is_concurrency_adaptive() const { return is_concurrency_adaptive_; }
+    int min_concurrent_jobs() const { return min_concurrent_jobs_; }
+    /**
+     * @brief number of local jobs allowed now, which is lowered by load of the system or lack of memory
+     */
+    int current_max_concurrent_jobs() const { return effective_max_concurrent_jobs_(); }
+    /**
+     * @brief memory assumed to be used by jobs having process, including paused ones
+     */
+    qint64 reserved_memory() const;
+    /**
+     * @brief peak resident set size of job measured so far
+     */
+    qint64 resident_memory(int id) const { return entry_(id).peak_resident_memory; }
+    /**
+     * @brief add job to queue and start it when a slot is free
+     *
+     * @return int id of job
+     */
+    int enqueue(const EncodeJob &job);
+    void cancel(int id);
+    void cancel_all();
+    /**
+     * @brief whether running process can be paused on this platform
+     */
+    static bool can_pause();
+    /**
+     * @brief pause job until resume() is called. slot of paused job is used by other jobs.
+     */
+    void pause(int id);
+    /**
+     * @brief put job paused by pause() back to queue. its process continues when it gets a slot.
+     */
+    void resume(int id);
+    /**
+     * @brief change priority of job. this may preempt running job or be preempted.
+     * @details process of job with negative priority is reniced to -priority (up to 19), so that it yields cpu to
+     * other jobs. note that decreasing niceness of running process usually requires privilege.
+     */
+    void set_priority(int id, int priority);
+    /**
+     * @brief use slots of remote worker in addition to local ones. scheduler takes ownership of worker.
+     */
+    void add_remote_worker(RemoteWorker *worker);
+    /**
+     * @brief stop using remote workers. jobs running on them are put back to queue.
+     */
+    void clear_remote_workers();
+    /**
+     * @brief whether job is run by remote worker
+     */
+    bool is_remote(int id) const { return entry_(id).remote != nullptr; }
+    bool contains(int id) const { return jobs_.contains(id); }
+    /**
+     * @brief ids of every job enqueued, including finished ones, in ascending order
+     */
+    QList<int> job_ids() const { return jobs_.keys(); }
+    const EncodeJob &job(int id) const { return entry_(id).job; }
+    JobState state(int id) const { return entry_(id).state; }
+    /**
+     * @brief whether queued job is waiting for disk space
+     */
+    bool is_held(int id) const { return held_.contains(id); }
+    int num_queued() const { return queue_.size() + held_.size(); }
+    /**
+     * @brief number of queued jobs waiting for disk space
+     */
+    int num_held() const { return held_.size(); }
+    int num_running() const;
+    int num_paused() const;
+    bool is_idle() const { return num_queued() == 0 && num_running() == 0 && num_paused() == 0; }
+    /**
+     * @brief position of output of running job reported by ffmpeg
+     */
+    std::chrono::milliseconds processed_length(int id) const { return entry_(id).processed; }
+    /**
+     * @brief sum of cost of jobs enqueued since scheduler was idle last time
+     */
+    double batch_total_cost() const;
+    /**
+     * @brief sum of cost of jobs in batch which are already done. running jobs are counted by their progress.
+     */
+    double batch_finished_cost() const;
+    /**
+     * @brief order in which jobs are started
+     */
+    static bool is_started_before(const EncodeJob &one, const EncodeJob &the_other);
+    /**
+     * @brief simulate scheduling of jobs to estimate wall time of batch
+     *
+     * @param jobs jobs whose predicted_duration is set
+     * @param max_concurrent_jobs
+     */
+    static std::chrono::milliseconds estimate_makespan(QList<EncodeJob> jobs, int max_concurrent_jobs);
+    /**
+     * @brief time taken by finished job, excluding the time it was paused
+     */
+    std::chrono::milliseconds wall_time(int id) const { return entry_(id).wall_time; }
+    /**
+     * @brief time taken by job so far, excluding the time it was paused
+     */
+    std::chrono::milliseconds elapsed_time(int id) const;
+
+   signals:
+    void job_started(int id);
+    void job_output(int id, QString stdout_text, QString stderr_text);
+    void job_progressed(int id, std::chrono::milliseconds processed);
+    /// process of job is stopped, either by pause() or by preemption
+    void job_paused(int id);
+    /// process of paused job is continued
+    void job_resumed(int id);
+    /// job is killed for lack of memory and put back to queue. job_started() is emitted again when it restarts
+    void job_requeued(int id);
+    void job_finished(int id, bool is_success);
+    /// output of job doesn't fit free space, and the job waits until space is freed
+    void job_held(int id);
+    /// output of job is written to overflow directory instead, since its own filesystem is full
+    void job_redirected(int id, QString output_path);
+    /// current_max_concurrent_jobs() is changed by load of the system
+    void concurrency_adapted(int max_concurrent_jobs);
+    /// emitted when last running job finished and queue is empty
+    void idle();
+
+   private:
+    struct Entry {
+        EncodeJob job;
+        JobState state = JobState::queued;
+        QProcess *process = nullptr;
+        /// worker running this job, or nullptr
+        RemoteWorker *remote = nullptr;
+        std::chrono::milliseconds processed{0};
+        QElapsedTimer timer;
+        /// time the process was running before it was paused last time
+        std::chrono::milliseconds wall_time{0};
+        qint64 peak_resident_memory = 0;
+        bool is_out_of_memory = false;
+        /// kills by the OOM killer counted when process started. see read_oom_kill_count()
+        std::optional<qint64> oom_kills_at_start;
+        int num_out_of_memory = 0;
+        bool is_held = false;
+    };
+    QMap<int, Entry> jobs_;
+    QList<int> queue_;
+    QList<int> batch_;
+    /// queued jobs whose output doesn't fit free space. they are not in queue_
+    QList<int> held_;
+    QList<RemoteWorker *> remote_workers_;
+    int next_id_ = 0;
+    int max_concurrent_jobs_ = 1;
+    qint64 memory_budget_ = 0;
+    /// concurrency lowered after a job was killed for lack of memory. 0 means not lowered
+    int max_concurrent_jobs_after_out_of_memory_ = 0;
+    QTimer memory_timer_;
+    static constexpr int MEMORY_POLLING_INTERVAL_MSEC = 1000;
+    static constexpr int MAX_OUT_OF_MEMORY_RETRIES = 2;
+    /// memory reserved for job retried after out of memory, relative to its peak memory
+    static constexpr double OUT_OF_MEMORY_MARGIN = 1.5;
+    /// memory pressure (some avg10) above which SIGKILL is blamed on the OOM killer if its kills aren't counted
+    static constexpr double OUT_OF_MEMORY_PRESSURE = 1.0;
+    bool is_concurrency_adaptive_ = false;
+    int min_concurrent_jobs_ = 1;
+    /// concurrency lowered by load of the system. 0 means not lowered
+    int max_concurrent_jobs_under_load_ = 0;
+    LoadThresholds load_thresholds_;
+    QTimer load_timer_;
+    qint64 min_free_disk_space_ = 0;
+    QString overflow_dir_;
+    QTimer disk_timer_;
+    /// free space of directories of outputs, read once per dispatch pass since statvfs is called for every running job
+    mutable QHash<QString, std::optional<DiskSpace>> disk_spaces_;
+    /// free space is not reported by any event, so held jobs are retried at this interval
+    static constexpr int DISK_POLLING_INTERVAL_MSEC = 30000;
+    /// pressures are averaged over 10 seconds, so polling more often only sees the same load again
+    static constexpr int LOAD_POLLING_INTERVAL_MSEC = 10000;
+    /// concurrency is raised only while load is below this ratio to its threshold, so that it doesn't oscillate
+    static constexpr double LOAD_LOW_WATERMARK = 0.5;
+
+    static constexpr int MAX_NICENESS = 19;
+    int effective_max_concurrent_jobs_() const;
+    /// effective_max_concurrent_jobs_() limited further by tuned limits of the job and of running jobs
+    int max_concurrent_jobs_with_(int id) const;
+    int num_running_locally_() const;
+    /// remote worker with the most free slots, or nullptr
+    RemoteWorker *free_remote_worker_() const;
+    qint64 memory_of_(int id) const;
+    /// whether process of job killed by SIGKILL was killed by the OOM killer rather than by someone else
+    bool is_killed_for_memory_(int id) const;
+    /**
+     * @brief entry of job. ids which were never enqueued are asserted, and get an empty canceled entry in release
+     * build, since accessors are called from handlers of queued signals
+     */
+    const Entry &entry_(int id) const;
+    bool has_memory_for_(int id) const;
+    void poll_memory_();
+    /// whether output fits free space of filesystem of path, less outputs being written by other jobs
+    bool has_disk_space_for_(int id, const QString &output_path) const;
+    /// free space of filesystem which path is written to, cached until next dispatch pass
+    std::optional<DiskSpace> disk_space_of_(const QString &path) const;
+    /**
+     * @brief make sure that job has space for its output, by redirecting it or holding it
+     *
+     * @return false if job is held. it is removed from queue_
+     */
+    bool admit_to_disk_(int id);
+    void redirect_(int id, const QString &output_path);
+    void retry_held_();
+    /// highest ratio of load of the system to its threshold, or std::nullopt if load is not available
+    std::optional<double> read_load_ratio_() const;
+    void poll_load_();
+    /// pause running jobs above current_max_concurrent_jobs()
+    void shed_jobs_();
+    /// forget progress of job and remove its partial output, so that it can be started again
+    void discard_progress_(int id);
+    void requeue_(int id);
+    void requeue_lost_(const QList<int> &ids);
+    void dispatch_();
+    /// running job with the lowest priority, or -1
+    int preemptee_() const;
+    void start_(int id);
+    void start_remote_(int id, RemoteWorker *worker);
+    bool stop_(int id);
+    void continue_(int id);
+    void renice_(int id);
+    void finish_(int id, bool is_success);
+    void read_stderr_(int id);
+    void handle_stderr_(int id, const QString &text);
+};
+}  // namespace concat
+
+#endif
@@ -0,0 +1,159 @@
+#include "encodeworker.hpp"
+
+#include <QFile>
+#include <QHostInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QtDebug>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+EncodeWorker::EncodeWorker(const QString &ffmpeg, int max_jobs, const QList<PathMapping> &path_mappings,
+                           QObject *parent)
+    : QObject(parent), ffmpeg_(ffmpeg), max_jobs_(qMax(1, max_jobs)), path_mappings_(path_mappings) {
+    connect(&server_, &QTcpServer::newConnection, this, &EncodeWorker::accept_);
+}
+EncodeWorker::~EncodeWorker() {
+    for (auto &job : jobs_) {
+        if (job.process != nullptr) {
+            job.process->disconnect(this);
+            job.process->kill();
+            job.process->waitForFinished();
+        }
+    }
+}
+bool EncodeWorker::listen(const QHostAddress &address, quint16 port) { return server_.listen(address, port); }
+void EncodeWorker::accept_() {
+    while (server_.hasPendingConnections()) {
+        auto client = server_.nextPendingConnection();
+        qInfo() << "connected from" << client->peerAddress().toString();
+        connect(client, &QTcpSocket::readyRead, this, [this, client] { receive_(client); });
+        connect(client, &QTcpSocket::disconnected, this, [this, client] { drop_client_(client); });
+        send_(client, {{"type", "hello"},
+                       {"version", WORKER_PROTOCOL_VERSION},
+                       {"host", QHostInfo::localHostName()},
+                       {"slots", max_jobs_}});
+    }
+}
+void EncodeWorker::receive_(QTcpSocket *client) {
+    for (const auto &message : read_worker_messages(client)) {
+        auto type = message["type"].toString();
+        if (type == "job") {
+            add_job_(client, message);
+        } else if (type == "cancel") {
+            cancel_job_(client, message["id"].toInt());
+        } else {
+            qWarning() << "ignored unknown message" << type;
+        }
+    }
+}
+void EncodeWorker::add_job_(QTcpSocket *client, const QJsonObject &message) {
+    auto id = message["id"].toInt();
+    auto input_path = map_path(message["input_path"].toString(), path_mappings_);
+    if (not QFile::exists(input_path)) {
+        send_(client, {{"type", "finished"},
+                       {"id", id},
+                       {"success", false},
+                       {"error", tr("input %1 is not found on worker").arg(input_path)}});
+        return;
+    }
+    QStringList arguments;
+    for (const auto &argument : message["arguments"].toArray()) {
+        arguments.push_back(map_path(argument.toString(), path_mappings_));
+    }
+    jobs_.push_back({client, id, arguments});
+    start_next_();
+}
+void EncodeWorker::cancel_job_(QTcpSocket *client, int id) {
+    auto job = std::find_if(jobs_.begin(), jobs_.end(),
+                            [client, id](const Job &one) { return one.client == client && one.id == id; });
+    if (job == jobs_.end()) {
+        return;
+    }
+    if (job->process != nullptr) {
+        job->process->kill();  // reported by finish_()
+        return;
+    }
+    jobs_.erase(job);
+    send_(client, {{"type", "finished"}, {"id", id}, {"success", false}, {"error", tr("canceled")}});
+}
+void EncodeWorker::drop_client_(QTcpSocket *client) {
+    qInfo() << "disconnected from" << client->peerAddress().toString();
+    for (auto it = jobs_.begin(); it != jobs_.end();) {
+        if (it->client != client) {
+            ++it;
+            continue;
+        }
+        if (it->process != nullptr) {
+            it->process->disconnect(this);
+            it->process->kill();
+            it->process->waitForFinished();
+            it->process->deleteLater();
+        }
+        it = jobs_.erase(it);
+    }
+    client->deleteLater();
+    start_next_();
+}
+void EncodeWorker::start_next_() {
+    auto num_running =
+        std::count_if(jobs_.cbegin(), jobs_.cend(), [](const Job &job) { return job.process != nullptr; });
+    for (auto &job : jobs_) {
+        if (num_running >= max_jobs_) {
+            break;
+        }
+        if (job.process != nullptr) {
+            continue;
+        }
+        auto process = new QProcess(this);
+        job.process = process;
+        num_running++;
+        connect(process, &QProcess::readyReadStandardOutput, this, [this, process] {
+            send_output_(process, "stdout", process->readAllStandardOutput());
+        });
+        connect(process, &QProcess::readyReadStandardError, this, [this, process] {
+            send_output_(process, "stderr", process->readAllStandardError());
+        });
+        connect(process, &QProcess::finished, this, [this, process](int exit_code, QProcess::ExitStatus exit_status) {
+            finish_(process, exit_status == QProcess::NormalExit && exit_code == 0, QString());
+        });
+        // queued, because failure to start may be reported inside QProcess::start(), while jobs_ is iterated
+        connect(
+            process, &QProcess::errorOccurred, this,
+            [this, process](QProcess::ProcessError error) {
+                if (error == QProcess::FailedToStart) {
+                    finish_(process, false, process->errorString());
+                }
+            },
+            Qt::QueuedConnection);
+        send_(job.client, {{"type", "started"}, {"id", job.id}});
+        qInfo() << "start" << ffmpeg_ << job.arguments;
+        process->start(ffmpeg_, job.arguments);
+    }
+}
+void EncodeWorker::send_output_(QProcess *process, const QString &channel, const QByteArray &output) {
+    auto job = std::find_if(jobs_.cbegin(), jobs_.cend(), [process](const Job &one) { return one.process == process; });
+    if (job == jobs_.cend()) {
+        return;
+    }
+    send_(job->client, {{"type", "output"}, {"id", job->id}, {channel, QString::fromUtf8(output)}});
+}
+void EncodeWorker::finish_(QProcess *process, bool is_success, const QString &error) {
+    auto job = std::find_if(jobs_.begin(), jobs_.end(), [process](const Job &one) { return one.process == process; });
+    if (job == jobs_.end()) {
+        return;
+    }
+    send_(job->client, {{"type", "finished"}, {"id", job->id}, {"success", is_success}, {"error", error}});
+    jobs_.erase(job);
+    process->deleteLater();
+    start_next_();
+}
+void EncodeWorker::send_(QTcpSocket *client, const QJsonObject &message) {
+    if (client == nullptr || client->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+    client->write(encode_worker_message(message));
+}
+}  // namespace concat
@@ -0,0 +1,65 @@
+#ifndef VIDEO_RE_ENCODER_ENCODEWORKER
+#define VIDEO_RE_ENCODER_ENCODEWORKER
+
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QTcpServer>
+
+#include "workerprotocol.hpp"
+
+class QTcpSocket;
+
+namespace concat {
+/**
+ * @brief daemon side of remote encoding. accepts jobs from EncodeScheduler over tcp and runs them with local ffmpeg.
+ * @details only the ffmpeg given to constructor is run, whatever program client asked for. input and output are
+ * expected to be on a filesystem shared with client, and their paths are translated with path mappings. files are
+ * never transferred over the connection, so a job whose input isn't found on worker fails at once. jobs of a client
+ * are killed when it disconnects.
+ * @warning anyone who can connect can make ffmpeg read and write files as the user running this daemon. listen only
+ * on trusted network.
+ */
+class EncodeWorker : public QObject {
+    Q_OBJECT
+
+   public:
+    EncodeWorker(const QString &ffmpeg, int max_jobs, const QList<PathMapping> &path_mappings,
+                 QObject *parent = nullptr);
+    ~EncodeWorker();
+    bool listen(const QHostAddress &address, quint16 port);
+    QString error_string() const { return server_.errorString(); }
+    quint16 port() const { return server_.serverPort(); }
+
+   private:
+    struct Job {
+        QPointer<QTcpSocket> client;
+        int id;
+        QStringList arguments;
+        /// nullptr while queued
+        QProcess *process = nullptr;
+    };
+    QString ffmpeg_;
+    int max_jobs_;
+    QList<PathMapping> path_mappings_;
+    QTcpServer server_;
+    /// queued jobs are kept in order of arrival
+    QList<Job> jobs_;
+
+    void accept_();
+    void receive_(QTcpSocket *client);
+    void add_job_(QTcpSocket *client, const QJsonObject &message);
+    void cancel_job_(QTcpSocket *client, int id);
+    void drop_client_(QTcpSocket *client);
+    void start_next_();
+    void send_output_(QProcess *process, const QString &channel, const QByteArray &output);
+    void finish_(QProcess *process, bool is_success, const QString &error);
+    void send_(QTcpSocket *client, const QJsonObject &message);
+};
+}  // namespace concat
+
+#endif
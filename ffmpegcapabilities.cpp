@@ -0,0 +1,191 @@
+#include "ffmpegcapabilities.hpp"
+
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtDebug>
+#include <ciso646>
+#include <optional>
+
+namespace concat {
+namespace {
+constexpr auto CACHE_GROUP = "ffmpeg_capabilities";
+constexpr int QUERY_TIMEOUT_MSEC = 10000;
+std::optional<QStringList> list_of(const QString &path, const QString &option) {
+    QProcess process;
+    process.start(path, {"-hide_banner", option});
+    if (not process.waitForFinished(QUERY_TIMEOUT_MSEC) || process.exitStatus() != QProcess::NormalExit) {
+        qWarning() << "failed to execute" << path << option << process.errorString();
+        return std::nullopt;
+    }
+    return QString::fromUtf8(process.readAllStandardOutput()).split('\n');
+}
+/// parse output of `ffmpeg -encoders` or `ffmpeg -decoders`. codec names are registered too, as `-c:v h264` is valid.
+QSet<QString> parse_coders(const QStringList &lines) {
+    QRegularExpression coder_pattern(R"(^\s*[VASFXBD.]{6}\s+(?<name>\S+)\s*(?<description>.*)$)");
+    QRegularExpression codec_pattern(R"(\(codec (?<codec>\S+)\))");
+    QSet<QString> result;
+    bool is_header = true;
+    for (const auto &line : lines) {
+        if (is_header) {
+            is_header = not line.trimmed().startsWith("---");
+            continue;
+        }
+        auto match = coder_pattern.match(line);
+        if (not match.hasMatch()) {
+            continue;
+        }
+        result << match.captured("name");
+        auto codec_match = codec_pattern.match(match.captured("description"));
+        if (codec_match.hasMatch()) {
+            result << codec_match.captured("codec");
+        }
+    }
+    return result;
+}
+QSet<QString> parse_filters(const QStringList &lines) {
+    QRegularExpression filter_pattern(R"(^\s*[T.][S.][C.]\s+(?<name>\S+)\s+\S*->\S*)");
+    QSet<QString> result;
+    for (const auto &line : lines) {
+        auto match = filter_pattern.match(line);
+        if (match.hasMatch()) {
+            result << match.captured("name");
+        }
+    }
+    return result;
+}
+QSet<QString> parse_hwaccels(const QStringList &lines) {
+    QSet<QString> result;
+    for (auto i = 1; i < lines.size(); i++) {  // first line is header
+        auto name = lines[i].trimmed();
+        if (not name.isEmpty()) {
+            result << name;
+        }
+    }
+    return result;
+}
+/// extract filter names from filtergraph description such as "[0:v]scale=1280:-2,fps=30[out]"
+QStringList filter_names_of(const QString &graph) {
+    QRegularExpression label_pattern(R"(\[[^\]]*\])");
+    QRegularExpression name_pattern(R"(^[A-Za-z0-9_]+$)");
+    QStringList result;
+    for (auto filter : graph.split(QRegularExpression("[,;]"), Qt::SkipEmptyParts)) {
+        filter.remove(label_pattern);
+        auto name = filter.trimmed().section('=', 0, 0).section('@', 0, 0);
+        if (name_pattern.match(name).hasMatch()) {
+            result << name;
+        }
+    }
+    return result;
+}
+QStringList to_list(const QSet<QString> &set) { return {set.cbegin(), set.cend()}; }
+QSet<QString> to_set(const QStringList &list) { return {list.cbegin(), list.cend()}; }
+}  // namespace
+FfmpegCapabilities FfmpegCapabilities::load(QSettings *settings, const QString &program) {
+    FfmpegCapabilities result;
+    result.path_ = QStandardPaths::findExecutable(program);
+    if (result.path_.isEmpty()) {
+        qWarning() << program << "was not found";
+        return result;
+    }
+    result.mtime_ = QFileInfo{result.path_}.lastModified();
+    if (settings != nullptr && result.read_cache_(settings)) {
+        return result;
+    }
+    if (result.query_() && settings != nullptr) {
+        result.write_cache_(settings);
+    }
+    return result;
+}
+bool FfmpegCapabilities::query_() {
+    auto encoders = list_of(path_, "-encoders");
+    auto decoders = list_of(path_, "-decoders");
+    auto filters = list_of(path_, "-filters");
+    auto hwaccels = list_of(path_, "-hwaccels");
+    if (not(encoders && decoders && filters && hwaccels)) {
+        return false;
+    }
+    encoders_ = parse_coders(encoders.value());
+    decoders_ = parse_coders(decoders.value());
+    filters_ = parse_filters(filters.value());
+    hwaccels_ = parse_hwaccels(hwaccels.value());
+    is_valid_ = not(encoders_.isEmpty() || decoders_.isEmpty());
+    return is_valid_;
+}
+bool FfmpegCapabilities::read_cache_(QSettings *settings) {
+    settings->beginGroup(CACHE_GROUP);
+    is_valid_ = settings->value("path").toString() == path_ && settings->value("mtime").toDateTime() == mtime_;
+    if (is_valid_) {
+        encoders_ = to_set(settings->value("encoders").toStringList());
+        decoders_ = to_set(settings->value("decoders").toStringList());
+        filters_ = to_set(settings->value("filters").toStringList());
+        hwaccels_ = to_set(settings->value("hwaccels").toStringList());
+    }
+    settings->endGroup();
+    return is_valid_;
+}
+void FfmpegCapabilities::write_cache_(QSettings *settings) const {
+    settings->beginGroup(CACHE_GROUP);
+    settings->setValue("path", path_);
+    settings->setValue("mtime", mtime_);
+    settings->setValue("encoders", to_list(encoders_));
+    settings->setValue("decoders", to_list(decoders_));
+    settings->setValue("filters", to_list(filters_));
+    settings->setValue("hwaccels", to_list(hwaccels_));
+    settings->endGroup();
+}
+bool FfmpegCapabilities::has_encoder(const QString &name) const {
+    return not is_valid_ || name == "copy" || encoders_.contains(name);
+}
+bool FfmpegCapabilities::has_decoder(const QString &name) const { return not is_valid_ || decoders_.contains(name); }
+bool FfmpegCapabilities::has_filter(const QString &name) const { return not is_valid_ || filters_.contains(name); }
+bool FfmpegCapabilities::has_hwaccel(const QString &name) const {
+    return not is_valid_ || name == "auto" || name == "none" || hwaccels_.contains(name);
+}
+QStringList FfmpegCapabilities::validate(const VideoInfo &info) const {
+    QStringList problems;
+    if (not is_valid_) {
+        return problems;
+    }
+    if (std::holds_alternative<QString>(info.audio_codec)) {
+        auto codec = std::get<QString>(info.audio_codec);
+        if (not has_encoder(codec)) {
+            problems << tr("audio encoder '%1' is not supported by %2").arg(codec).arg(path_);
+        }
+    }
+    if (std::holds_alternative<QString>(info.video_codec)) {
+        auto codec = std::get<QString>(info.video_codec);
+        if (not has_encoder(codec)) {
+            problems << tr("video encoder '%1' is not supported by %2").arg(codec).arg(path_);
+        }
+    }
+    validate_args_(info.input_file_args, true, problems);
+    validate_args_(info.encoding_args, false, problems);
+    return problems;
+}
+void FfmpegCapabilities::validate_args_(const QVector<QString> &args, bool is_input, QStringList &problems) const {
+    QRegularExpression codec_option_pattern(R"(^-(c|codec|vcodec|acodec|scodec)(:.*)?$)");
+    QRegularExpression filter_option_pattern(R"(^-(vf|af|filter|filter_complex|lavfi)(:.*)?$)");
+    for (auto i = 0; i + 1 < args.size(); i++) {
+        const auto &option = args[i];
+        const auto &value = args[i + 1];
+        if (codec_option_pattern.match(option).hasMatch()) {
+            if (is_input && not has_decoder(value)) {
+                problems << tr("decoder '%1' given to %2 is not supported by %3").arg(value).arg(option).arg(path_);
+            } else if (not is_input && not has_encoder(value)) {
+                problems << tr("encoder '%1' given to %2 is not supported by %3").arg(value).arg(option).arg(path_);
+            }
+        } else if (filter_option_pattern.match(option).hasMatch()) {
+            for (const auto &filter : filter_names_of(value)) {
+                if (not has_filter(filter)) {
+                    problems << tr("filter '%1' given to %2 is not supported by %3").arg(filter).arg(option).arg(path_);
+                }
+            }
+        } else if (is_input && option == "-hwaccel" && not has_hwaccel(value)) {
+            problems << tr("hwaccel '%1' is not supported by %2").arg(value).arg(path_);
+        }
+    }
+}
+}  // namespace concat
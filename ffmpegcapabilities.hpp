@@ -0,0 +1,61 @@
+#ifndef VIDEO_RE_ENCODER_FFMPEGCAPABILITIES
+#define VIDEO_RE_ENCODER_FFMPEGCAPABILITIES
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "videoinfo.hpp"
+
+class QSettings;
+
+namespace concat {
+/**
+ * @brief encoders, decoders, filters and hwaccels supported by one ffmpeg binary
+ */
+class FfmpegCapabilities {
+    Q_DECLARE_TR_FUNCTIONS(FfmpegCapabilities)
+
+   public:
+    /**
+     * @brief load capabilities of program from cache in settings.
+     * @note ffmpeg is only executed when cache is missing, or path or mtime of the binary differs from cached ones.
+     *
+     * @param settings where cache is stored
+     * @param program name or path of ffmpeg
+     */
+    static FfmpegCapabilities load(QSettings *settings, const QString &program = "ffmpeg");
+    /**
+     * @brief whether capabilities could be retrieved. if this is false, every query returns true.
+     */
+    bool is_valid() const { return is_valid_; }
+    bool has_encoder(const QString &name) const;
+    bool has_decoder(const QString &name) const;
+    bool has_filter(const QString &name) const;
+    bool has_hwaccel(const QString &name) const;
+    /**
+     * @brief check codecs, filters and hwaccels referred by info
+     *
+     * @return QStringList human readable problems. empty when nothing is wrong
+     */
+    QStringList validate(const VideoInfo &info) const;
+
+   private:
+    bool is_valid_ = false;
+    QString path_;
+    QDateTime mtime_;
+    QSet<QString> encoders_;
+    QSet<QString> decoders_;
+    QSet<QString> filters_;
+    QSet<QString> hwaccels_;
+
+    bool query_();
+    bool read_cache_(QSettings *settings);
+    void write_cache_(QSettings *settings) const;
+    void validate_args_(const QVector<QString> &args, bool is_input, QStringList &problems) const;
+};
+}  // namespace concat
+
+#endif
@@ -0,0 +1,63 @@
+#include "ffmpegprogress.hpp"
+
+#include <QRegularExpression>
+#include <ciso646>
+
+namespace concat {
+std::optional<std::chrono::milliseconds> parse_ffmpeg_time(QStringView stderr_text) {
+    static const QRegularExpression time_pattern(
+        R"(time=(?<hours>\d\d):(?<minutes>\d\d):(?<seconds>\d\d).(?<centiseconds>\d\d))");
+    std::optional<std::chrono::milliseconds> result;
+    auto it = time_pattern.globalMatch(stderr_text);
+    while (it.hasNext()) {
+        auto match = it.next();
+        using std::chrono::duration_cast;
+        using std::chrono::hours;
+        using std::chrono::minutes;
+        using std::chrono::seconds;
+        using centiseconds = std::chrono::duration<int, std::centi>;
+        using std::chrono::milliseconds;
+        result = duration_cast<milliseconds>(
+            hours(match.captured("hours").toInt()) + minutes(match.captured("minutes").toInt()) +
+            seconds(match.captured("seconds").toInt()) + centiseconds(match.captured("centiseconds").toInt()));
+    }
+    return result;
+}
+std::optional<qint64> parse_ffmpeg_frame(QStringView stderr_text) {
+    static const QRegularExpression frame_pattern(R"(frame=\s*(?<frame>\d+))");
+    std::optional<qint64> result;
+    auto it = frame_pattern.globalMatch(stderr_text);
+    while (it.hasNext()) {
+        result = it.next().captured("frame").toLongLong();
+    }
+    return result;
+}
+QMap<int, QString> parse_output_errors(QStringView stderr_text, const QStringList &output_paths) {
+    static const QRegularExpression error_pattern(R"(error|invalid|failed|could not|unable)",
+                                                  QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression index_pattern(R"((?:out#|[av]ost#|output file #|output stream )(?<index>\d+))");
+    QMap<int, QString> result;
+    for (auto line : stderr_text.split('\n')) {
+        line = line.trimmed();
+        if (not error_pattern.match(line).hasMatch()) {
+            continue;
+        }
+        auto index = -1;
+        auto match = index_pattern.match(line);
+        if (match.hasMatch()) {
+            index = match.captured("index").toInt();
+        } else {
+            for (auto i = 0; i < output_paths.size(); i++) {
+                if (line.contains(output_paths[i])) {
+                    index = i;
+                    break;
+                }
+            }
+        }
+        if (index >= 0 && index < output_paths.size() && not result.contains(index)) {
+            result.insert(index, line.toString());
+        }
+    }
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,37 @@
+#ifndef VIDEO_RE_ENCODER_FFMPEGPROGRESS
+#define VIDEO_RE_ENCODER_FFMPEGPROGRESS
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <chrono>
+#include <optional>
+
+namespace concat {
+/**
+ * @brief retrieve position of output from progress line of ffmpeg, such as "time=00:01:02.03"
+ *
+ * @param stderr_text new text written to stderr by ffmpeg
+ * @return latest position found in stderr_text. std::nullopt if stderr_text doesn't contain progress
+ */
+std::optional<std::chrono::milliseconds> parse_ffmpeg_time(QStringView stderr_text);
+/**
+ * @brief retrieve number of frames written from progress line of ffmpeg, such as "frame= 1234"
+ *
+ * @return latest number found in stderr_text. std::nullopt if stderr_text doesn't contain progress
+ */
+std::optional<qint64> parse_ffmpeg_frame(QStringView stderr_text);
+/**
+ * @brief find errors of each output of ffmpeg writing several outputs
+ * @details outputs are identified by index in messages, such as "[out#1/mp4 @ ...]", "[vost#1:0/libx265 @ ...]" and
+ * "output stream 1:0", or by their paths.
+ *
+ * @param stderr_text text written to stderr by ffmpeg
+ * @param output_paths paths of outputs in order of arguments
+ * @return index of output -> the first error line about it
+ */
+QMap<int, QString> parse_output_errors(QStringView stderr_text, const QStringList &output_paths);
+}  // namespace concat
+
+#endif
@@ -0,0 +1,180 @@
+#include "folderwatcher.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtDebug>
+#include <algorithm>
+#include <ciso646>
+
+#ifdef Q_OS_LINUX
+#    include <sys/inotify.h>
+#    include <unistd.h>
+
+#    include <QSocketNotifier>
+#endif
+
+namespace concat {
+FolderWatcher::FolderWatcher(QObject *parent) : QObject(parent) {
+    settle_timer_.setInterval(SETTLE_CHECK_INTERVAL_MSEC);
+    connect(&settle_timer_, &QTimer::timeout, this, &FolderWatcher::check_candidates_);
+    connect(&fallback_watcher_, &QFileSystemWatcher::directoryChanged, this,
+            &FolderWatcher::scan_changed_directory_);
+#ifdef Q_OS_LINUX
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        qWarning() << "inotify is not available. falling back to QFileSystemWatcher";
+    } else {
+        inotify_notifier_ = new QSocketNotifier(inotify_fd_, QSocketNotifier::Read, this);
+        connect(inotify_notifier_, &QSocketNotifier::activated, this, &FolderWatcher::read_inotify_events_);
+    }
+#endif
+}
+FolderWatcher::~FolderWatcher() {
+#ifdef Q_OS_LINUX
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+    }
+#endif
+}
+void FolderWatcher::add_folder(const Folder &folder) {
+    auto folder_index = static_cast<int>(folders_.size());
+    folders_.push_back(folder);
+    QList<QRegularExpression> patterns;
+    for (const auto &filter : folder.name_filters) {
+        patterns.push_back(QRegularExpression::fromWildcard(filter, Qt::CaseInsensitive));
+    }
+    name_patterns_.push_back(patterns);
+    scan_folder_(folder_index, true);
+#ifdef Q_OS_LINUX
+    if (inotify_fd_ >= 0) {
+        auto watch = inotify_add_watch(inotify_fd_, QFile::encodeName(folder.path).constData(),
+                                       IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch >= 0) {
+            inotify_watch_to_folder_.insert(watch, folder_index);
+            return;
+        }
+        qWarning() << "failed to watch" << folder.path << "with inotify";
+    }
+#endif
+    fallback_watcher_.addPath(folder.path);
+}
+void FolderWatcher::clear() {
+#ifdef Q_OS_LINUX
+    for (auto it = inotify_watch_to_folder_.cbegin(); it != inotify_watch_to_folder_.cend(); ++it) {
+        inotify_rm_watch(inotify_fd_, it.key());
+    }
+    inotify_watch_to_folder_.clear();
+#endif
+    if (not fallback_watcher_.directories().isEmpty()) {
+        fallback_watcher_.removePaths(fallback_watcher_.directories());
+    }
+    settle_timer_.stop();
+    folders_.clear();
+    name_patterns_.clear();
+    candidates_.clear();
+    known_files_.clear();
+    held_files_.clear();
+}
+void FolderWatcher::set_accepting(bool accepting) {
+    accepting_ = accepting;
+    flush_held_files_();
+}
+bool FolderWatcher::matches_(int folder_index, const QString &file_name) const {
+    const auto &patterns = name_patterns_[folder_index];
+    if (patterns.isEmpty()) {
+        return true;
+    }
+    return std::any_of(patterns.cbegin(), patterns.cend(),
+                       [&file_name](const QRegularExpression &pattern) { return pattern.match(file_name).hasMatch(); });
+}
+void FolderWatcher::scan_folder_(int folder_index, bool is_initial) {
+    QDir dir{folders_[folder_index].path};
+    for (const auto &file_name : dir.entryList(QDir::Files)) {
+        if (not matches_(folder_index, file_name)) {
+            continue;
+        }
+        auto path = dir.absoluteFilePath(file_name);
+        if (is_initial) {
+            known_files_.insert(path);
+        } else {
+            touch_candidate_(folder_index, path, true);  // whether file is closed can't be known here
+        }
+    }
+}
+void FolderWatcher::scan_changed_directory_(const QString &path) {
+    for (auto i = 0; i < folders_.size(); i++) {
+        if (QDir{folders_[i].path} == QDir{path}) {
+            scan_folder_(i, false);
+        }
+    }
+}
+#ifdef Q_OS_LINUX
+void FolderWatcher::read_inotify_events_() {
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+        for (auto offset = 0; offset < length;) {
+            auto event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += static_cast<int>(sizeof(inotify_event) + event->len);
+            if (event->len == 0 || (event->mask & IN_ISDIR) != 0 || not inotify_watch_to_folder_.contains(event->wd)) {
+                continue;
+            }
+            auto folder_index = inotify_watch_to_folder_[event->wd];
+            auto file_name = QFile::decodeName(event->name);
+            if (not matches_(folder_index, file_name)) {
+                continue;
+            }
+            bool is_closed = (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0;
+            touch_candidate_(folder_index, QDir{folders_[folder_index].path}.absoluteFilePath(file_name), is_closed);
+        }
+    }
+}
+#endif
+void FolderWatcher::touch_candidate_(int folder_index, const QString &path, bool is_closed) {
+    if (known_files_.contains(path)) {
+        return;
+    }
+    auto &candidate = candidates_[path];
+    candidate.folder_index = folder_index;
+    candidate.is_closed = is_closed;
+    candidate.num_stable_checks = 0;
+    if (not settle_timer_.isActive()) {
+        settle_timer_.start();
+    }
+}
+void FolderWatcher::check_candidates_() {
+    for (auto it = candidates_.begin(); it != candidates_.end();) {
+        QFileInfo info{it.key()};
+        if (not info.exists()) {
+            it = candidates_.erase(it);
+            continue;
+        }
+        auto &candidate = it.value();
+        if (candidate.is_closed && candidate.size == info.size() && candidate.last_modified == info.lastModified()) {
+            candidate.num_stable_checks++;
+        } else {
+            candidate.size = info.size();
+            candidate.last_modified = info.lastModified();
+            candidate.num_stable_checks = 0;
+        }
+        if (candidate.num_stable_checks >= NUM_STABLE_CHECKS_REQUIRED) {
+            known_files_.insert(it.key());
+            held_files_.push_back({it.key(), folders_[candidate.folder_index].preset});
+            it = candidates_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (candidates_.isEmpty()) {
+        settle_timer_.stop();
+    }
+    flush_held_files_();
+}
+void FolderWatcher::flush_held_files_() {
+    while (accepting_ && not held_files_.isEmpty()) {
+        auto [path, preset] = held_files_.takeFirst();
+        emit file_ready(path, preset);
+    }
+}
+}  // namespace concat
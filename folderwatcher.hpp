@@ -0,0 +1,82 @@
+#ifndef VIDEO_RE_ENCODER_FOLDERWATCHER
+#define VIDEO_RE_ENCODER_FOLDERWATCHER
+
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QRegularExpression>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class QSocketNotifier;
+
+namespace concat {
+/**
+ * @brief watch directories and report files which are no longer written.
+ * @details inotify is used on linux so that files still opened for writing are never reported.
+ * QFileSystemWatcher is used on other platforms and only size and mtime are checked there.
+ */
+class FolderWatcher : public QObject {
+    Q_OBJECT
+
+   public:
+    struct Folder {
+        QString path;
+        QString preset;
+        QStringList name_filters;
+    };
+    explicit FolderWatcher(QObject *parent = nullptr);
+    ~FolderWatcher();
+    /**
+     * @brief start watching folder. files which already exist are ignored.
+     */
+    void add_folder(const Folder &folder);
+    void clear();
+    /**
+     * @brief while this is false, stable files are held and reported after this becomes true again.
+     */
+    void set_accepting(bool accepting);
+    int num_held_files() const { return held_files_.size(); }
+
+   signals:
+    void file_ready(QString path, QString preset);
+
+   private:
+    struct Candidate {
+        int folder_index = 0;
+        qint64 size = -1;
+        QDateTime last_modified;
+        int num_stable_checks = 0;
+        bool is_closed = false;
+    };
+    static constexpr int SETTLE_CHECK_INTERVAL_MSEC = 2000;
+    static constexpr int NUM_STABLE_CHECKS_REQUIRED = 2;
+    QList<Folder> folders_;
+    QList<QList<QRegularExpression>> name_patterns_;
+    QHash<QString, Candidate> candidates_;
+    QSet<QString> known_files_;
+    QList<QPair<QString, QString>> held_files_;
+    QTimer settle_timer_;
+    bool accepting_ = true;
+    QFileSystemWatcher fallback_watcher_;
+#ifdef Q_OS_LINUX
+    int inotify_fd_ = -1;
+    QSocketNotifier *inotify_notifier_ = nullptr;
+    QHash<int, int> inotify_watch_to_folder_;
+    void read_inotify_events_();
+#endif
+
+    bool matches_(int folder_index, const QString &file_name) const;
+    void scan_folder_(int folder_index, bool is_initial);
+    void scan_changed_directory_(const QString &path);
+    void touch_candidate_(int folder_index, const QString &path, bool is_closed);
+    void check_candidates_();
+    void flush_held_files_();
+};
+}  // namespace concat
+
+#endif
@@ -0,0 +1,72 @@
+#include "libraryindex.hpp"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtDebug>
+#include <ciso646>
+
+namespace concat {
+LibraryIndex::LibraryIndex(const QString &path) : path_(path) { load_(); }
+std::optional<ProbeResult> LibraryIndex::find(const QFileInfo &file) const {
+    auto entry = entries_.find(file.absoluteFilePath());
+    if (entry == entries_.end() || entry->size != file.size() ||
+        entry->mtime_msecs != file.lastModified().toMSecsSinceEpoch()) {
+        return std::nullopt;
+    }
+    return entry->result;
+}
+void LibraryIndex::insert(const QFileInfo &file, const ProbeResult &result) {
+    entries_.insert(file.absoluteFilePath(), {file.size(), file.lastModified().toMSecsSinceEpoch(), result});
+    is_modified_ = true;
+}
+void LibraryIndex::load_() {
+    if (path_.isEmpty() || not QFile::exists(path_)) {
+        return;
+    }
+    QFile file(path_);
+    if (not file.open(QIODevice::ReadOnly)) {
+        qWarning() << "failed to open" << path_;
+        return;
+    }
+    QJsonParseError err;
+    auto document = QJsonDocument::fromJson(file.readAll(), &err);
+    if (document.isNull() || document["VERSION"].toInt() != VERSION) {
+        qWarning() << "failed to parse" << path_ << err.errorString();
+        return;
+    }
+    auto files = document["files"].toObject();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        auto entry = it.value().toObject();
+        auto result = ProbeResult::from_json(entry["probe"].toObject());
+        if (result.has_value()) {
+            entries_.insert(it.key(), {entry["size"].toInteger(), entry["mtime"].toInteger(), result.value()});
+        }
+    }
+}
+void LibraryIndex::save() {
+    if (path_.isEmpty() || not is_modified_) {
+        return;
+    }
+    QJsonObject files;
+    for (auto it = entries_.constBegin(); it != entries_.constEnd(); ++it) {
+        files.insert(it.key(),
+                     QJsonObject{{"size", it->size}, {"mtime", it->mtime_msecs}, {"probe", it->result.to_json()}});
+    }
+    // index of large library takes a while to write, and half-written one would be lost entirely
+    QSaveFile file(path_);
+    if (not file.open(QIODevice::WriteOnly)) {
+        qWarning() << "failed to write" << path_;
+        return;
+    }
+    file.write(QJsonDocument(QJsonObject{{"VERSION", VERSION}, {"files", files}}).toJson(QJsonDocument::Compact));
+    if (file.commit()) {
+        is_modified_ = false;
+    } else {
+        qWarning() << "failed to write" << path_ << file.errorString();
+    }
+}
+}  // namespace concat
@@ -0,0 +1,50 @@
+#ifndef VIDEO_RE_ENCODER_LIBRARYINDEX
+#define VIDEO_RE_ENCODER_LIBRARYINDEX
+
+#include <QHash>
+#include <QString>
+#include <optional>
+
+#include "proberesult.hpp"
+
+class QFileInfo;
+
+namespace concat {
+/**
+ * @brief probe results of files, which are valid while size and mtime of the file are unchanged
+ * @details this is used as cache of ffprobe both by import and by library scan, so that rescanning large library
+ * only probes files added or modified since the last scan.
+ */
+class LibraryIndex {
+   public:
+    static constexpr int VERSION = 1;
+    /**
+     * @brief load index from path. empty index is created if path doesn't exist.
+     */
+    explicit LibraryIndex(const QString &path = QString());
+    /**
+     * @brief probe result of file if it is indexed and not modified since then
+     */
+    std::optional<ProbeResult> find(const QFileInfo &file) const;
+    void insert(const QFileInfo &file, const ProbeResult &result);
+    int size() const { return static_cast<int>(entries_.size()); }
+    /**
+     * @brief write index to file if it has changed since it was loaded or saved last time
+     */
+    void save();
+
+   private:
+    struct Entry {
+        qint64 size;
+        qint64 mtime_msecs;
+        ProbeResult result;
+    };
+    QString path_;
+    QHash<QString, Entry> entries_;
+    bool is_modified_ = false;
+
+    void load_();
+};
+}  // namespace concat
+
+#endif
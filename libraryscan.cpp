@@ -0,0 +1,194 @@
+#include "libraryscan.hpp"
+
+#include <QDir>
+#include <QMetaObject>
+#include <QtDebug>
+#include <ciso646>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace concat {
+namespace {
+constexpr double FRAMERATE_TOLERANCE = 0.001;
+template <class T>
+std::optional<T> value_of(const RangedVariant<T> &value) {
+    if (std::holds_alternative<T>(value)) {
+        return std::get<T>(value);
+    }
+    return std::nullopt;
+}
+std::optional<QString> value_of(const SelectableVariant<QString> &value) {
+    if (std::holds_alternative<QString>(value)) {
+        return std::get<QString>(value);
+    }
+    return std::nullopt;
+}
+}  // namespace
+QString codec_of_encoder(const QString &encoder) {
+    static const QHash<QString, QString> codecs{
+        {"libx264", "h264"},     {"libx264rgb", "h264"}, {"libopenh264", "h264"}, {"libx265", "hevc"},
+        {"libkvazaar", "hevc"},  {"libvpx", "vp8"},      {"libvpx-vp9", "vp9"},   {"libaom-av1", "av1"},
+        {"libsvtav1", "av1"},    {"librav1e", "av1"},    {"libfdk_aac", "aac"},   {"libmp3lame", "mp3"},
+        {"libopus", "opus"},     {"libvorbis", "vorbis"}, {"libxvid", "mpeg4"},
+    };
+    if (codecs.contains(encoder)) {
+        return codecs.value(encoder);
+    }
+    // hardware encoders are named after codec, such as hevc_nvenc, h264_qsv and av1_vaapi
+    static const QStringList hardware_suffixes{"_nvenc", "_qsv", "_vaapi", "_amf", "_videotoolbox", "_v4l2m2m", "_mf"};
+    for (const auto &suffix : hardware_suffixes) {
+        if (encoder.endsWith(suffix)) {
+            return encoder.chopped(suffix.size());
+        }
+    }
+    return encoder;
+}
+bool is_compliant(const VideoInfo &source_info, const VideoInfo &output_info, bool resolution_is_maximum) {
+    auto output_video_codec = value_of(output_info.video_codec);
+    if (output_video_codec.has_value() &&
+        codec_of_encoder(output_video_codec.value()) != value_of(source_info.video_codec)) {
+        return false;
+    }
+    auto output_audio_codec = value_of(output_info.audio_codec);
+    if (output_audio_codec.has_value() &&
+        codec_of_encoder(output_audio_codec.value()) != value_of(source_info.audio_codec)) {
+        return false;
+    }
+    auto source_resolution = value_of(source_info.resolution);
+    auto output_resolution = value_of(output_info.resolution);
+    if (output_resolution.has_value()) {
+        if (not source_resolution.has_value()) {
+            return false;
+        }
+        bool fits = resolution_is_maximum ? source_resolution->width() <= output_resolution->width() &&
+                                                source_resolution->height() <= output_resolution->height()
+                                          : source_resolution == output_resolution;
+        if (not fits) {
+            return false;
+        }
+    }
+    auto source_framerate = value_of(source_info.framerate);
+    auto output_framerate = value_of(output_info.framerate);
+    if (output_framerate.has_value() && output_framerate.value() > 0.0) {
+        if (not source_framerate.has_value() ||
+            std::abs(source_framerate.value() - output_framerate.value()) > FRAMERATE_TOLERANCE) {
+            return false;
+        }
+    }
+    return output_info.is_vfr || not source_info.is_vfr;
+}
+LibraryScanner::LibraryScanner(ProcessRunner *runner, LibraryIndex *index, QObject *parent)
+    : QObject(parent), runner_(runner), index_(index) {}
+LibraryScanner::~LibraryScanner() {
+    cancel();
+    pool_.waitForDone();
+}
+void LibraryScanner::scan(const QStringList &roots, const QStringList &name_filters) {
+    if (not is_scanning()) {
+        num_found_ = 0;
+        num_scanned_ = 0;
+    }
+    name_filters_ = name_filters;
+    for (const auto &root : roots) {
+        list_(QDir(root).absolutePath());
+    }
+    if (not is_scanning()) {
+        emit finished();
+    }
+}
+void LibraryScanner::cancel() {
+    generation_++;
+    num_listings_ = 0;
+    unprobed_.clear();
+    // callbacks of canceled probes are called from cancel(), and are ignored as they are no longer probing
+    auto probing = std::exchange(probing_, {});
+    for (auto it = probing.cbegin(); not runner_.isNull() && it != probing.cend(); ++it) {
+        runner_->cancel(it.key());
+    }
+    index_->save();
+}
+void LibraryScanner::list_(const QString &dir) {
+    num_listings_++;
+    auto generation = generation_;
+    auto name_filters = name_filters_;
+    pool_.start([this, dir, generation, name_filters] {
+        QDir directory(dir);
+        auto files = directory.entryInfoList(name_filters, QDir::Files | QDir::Readable);
+        for (const auto &file : files) {
+            // stat in this thread. QFileInfo keeps the result
+            file.size();
+            file.lastModified();
+        }
+        QStringList dirs;
+        for (const auto &name : directory.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+            dirs.push_back(directory.filePath(name));
+        }
+        QMetaObject::invokeMethod(
+            this, [this, generation, files, dirs] { add_listing_(generation, files, dirs); }, Qt::QueuedConnection);
+    });
+}
+void LibraryScanner::add_listing_(int generation, const QList<QFileInfo> &files, const QStringList &dirs) {
+    if (generation != generation_) {
+        return;
+    }
+    num_listings_--;
+    for (const auto &dir : dirs) {
+        list_(dir);
+    }
+    num_found_ += static_cast<int>(files.size());
+    for (const auto &file : files) {
+        auto result = index_->find(file);
+        if (result.has_value()) {
+            num_scanned_++;
+            emit file_scanned(file.absoluteFilePath(), result.value());
+        } else {
+            unprobed_.push_back(file);
+        }
+    }
+    emit progressed(num_scanned_, num_found_);
+    probe_next_();
+    finish_if_done_();
+}
+void LibraryScanner::probe_next_() {
+    if (runner_.isNull()) {
+        return;
+    }
+    auto max_in_flight = runner_->max_processes() * PROBES_IN_FLIGHT_PER_PROCESS;
+    while (not unprobed_.isEmpty() && probing_.size() < max_in_flight) {
+        auto file = unprobed_.takeFirst();
+        // callback is created before run() returns id. it is called later from event loop
+        auto id = std::make_shared<int>(-1);
+        *id = runner_->run(
+            "ffprobe", probe_arguments(file.absoluteFilePath()),
+            [this, id](const ProcessResult &result) { finish_probe_(*id, result); }, PROBE_PRIORITY);
+        probing_.insert(*id, file);
+    }
+}
+void LibraryScanner::finish_probe_(int id, const ProcessResult &result) {
+    if (not probing_.contains(id)) {
+        return;
+    }
+    auto file = probing_.take(id);
+    num_scanned_++;
+    QString error;
+    auto probe_result = result.is_success ? parse_probe_result(result.stdout_text, error) : std::nullopt;
+    if (probe_result.has_value()) {
+        index_->insert(file, probe_result.value());
+        emit file_scanned(file.absoluteFilePath(), probe_result.value());
+    } else {
+        emit file_failed(file.absoluteFilePath(), result.is_success ? error : result.stderr_text + result.error);
+    }
+    emit progressed(num_scanned_, num_found_);
+    probe_next_();
+    finish_if_done_();
+}
+void LibraryScanner::finish_if_done_() {
+    if (is_scanning()) {
+        return;
+    }
+    index_->save();
+    emit finished();
+}
+}  // namespace concat
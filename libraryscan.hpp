@@ -0,0 +1,86 @@
+#ifndef VIDEO_RE_ENCODER_LIBRARYSCAN
+#define VIDEO_RE_ENCODER_LIBRARYSCAN
+
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "libraryindex.hpp"
+#include "processrunner.hpp"
+#include "proberesult.hpp"
+#include "videoinfo.hpp"
+
+namespace concat {
+/**
+ * @brief codec written by encoder, such as "hevc" for "libx265" or "hevc_nvenc". name of codec is returned as is.
+ */
+QString codec_of_encoder(const QString &encoder);
+/**
+ * @brief whether source already satisfies output, so that it doesn't have to be re-encoded
+ * @details codecs are compared by codec rather than by encoder, unlike plan_transcode().
+ *
+ * @param source_info info of source
+ * @param output_info info of output. references must be resolved
+ * @param resolution_is_maximum treat resolution of output as upper bound, so that smaller source satisfies it
+ */
+bool is_compliant(const VideoInfo &source_info, const VideoInfo &output_info, bool resolution_is_maximum);
+/**
+ * @brief find videos in directory trees and probe them through LibraryIndex
+ * @details directories are listed in parallel on a thread pool. files whose size and mtime are unchanged since
+ * they were indexed are not probed again, so rescan of a large library is incremental.
+ */
+class LibraryScanner : public QObject {
+    Q_OBJECT
+
+   public:
+    LibraryScanner(ProcessRunner *runner, LibraryIndex *index, QObject *parent = nullptr);
+    ~LibraryScanner();
+    /**
+     * @brief scan roots recursively. symbolic links to directories are not followed.
+     *
+     * @param roots directories to scan
+     * @param name_filters wildcards of file names such as "*.mp4"
+     */
+    void scan(const QStringList &roots, const QStringList &name_filters);
+    void cancel();
+    bool is_scanning() const { return num_listings_ > 0 || not unprobed_.isEmpty() || not probing_.isEmpty(); }
+
+   signals:
+    /// probe result of file is known, either from index or from ffprobe
+    void file_scanned(QString path, concat::ProbeResult result);
+    void file_failed(QString path, QString error);
+    void progressed(int num_scanned, int num_found);
+    /// every file found has been scanned. index is saved before this is emitted
+    void finished();
+
+   private:
+    static constexpr int PROBE_PRIORITY = 0;
+    /// probes queued in runner at once, relative to its processes. the rest are kept here so that they can be canceled
+    static constexpr int PROBES_IN_FLIGHT_PER_PROCESS = 2;
+    QPointer<ProcessRunner> runner_;
+    LibraryIndex *index_;
+    QThreadPool pool_;
+    QStringList name_filters_;
+    /// incremented by cancel(), so that listings of canceled scan are ignored
+    int generation_ = 0;
+    int num_listings_ = 0;
+    int num_found_ = 0;
+    int num_scanned_ = 0;
+    QList<QFileInfo> unprobed_;
+    /// id of command of runner -> file
+    QHash<int, QFileInfo> probing_;
+
+    void list_(const QString &dir);
+    void add_listing_(int generation, const QList<QFileInfo> &files, const QStringList &dirs);
+    void probe_next_();
+    void finish_probe_(int id, const ProcessResult &result);
+    void finish_if_done_();
+};
+}  // namespace concat
+
+#endif
@@ -6,6 +6,7 @@
 #include <fmt/ranges.h>
 
 #include <QApplication>
+#include <QBrush>
 #include <QDataStream>
 #include <QDebug>
 #include <QDir>
@@ -13,7 +14,9 @@
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QGridLayout>
+#include <QHash>
 #include <QHBoxLayout>
+#include <QIcon>
 #include <QInputDialog>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -24,11 +27,17 @@
 #include <QMetaEnum>
 #include <QPair>
 #include <QPushButton>
+#include <QPixmap>
+#include <QProgressDialog>
 #include <QRegularExpression>
+#include <QScrollBar>
+#include <QSignalBlocker>
 #include <QStandardPaths>
 #include <QStringList>
 #include <QStyle>
+#include <QSysInfo>
 #include <QTextStream>
+#include <QThread>
 #include <QTime>
 #include <QUrl>
 #include <QVBoxLayout>
@@ -41,14 +50,20 @@
 #include <filesystem>
 #include <functional>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <timedialog.hpp>
 
 #include "./ui_mainwindow.h"
+#include "diskspace.hpp"
+#include "encodecost.hpp"
+#include "ffmpegprogress.hpp"
 #include "processwidget.hpp"
-#include "util_macros.hpp"
+#include "transcodeplan.hpp"
+#include "procfs.hpp"
+#include "speedhistory.hpp"
 #include "videoinfodialog.hpp"
 #include "videoinfowidget.hpp"
 
@@ -103,6 +118,37 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui_(new Ui::MainW
     connect(ui_->comboBox_preset, &QComboBox::currentTextChanged, this, &MainWindow::change_preset_);
     connect(ui_->actiondefault_preset, &QAction::triggered, this, &MainWindow::select_default_preset_);
     connect(ui_->pushButton_clear, &QPushButton::clicked, ui_->listWidget_files, &QListWidget::clear);
+    ui_->listWidget_files->setIconSize(
+        QSize(concat::ThumbnailCache::NUM_THUMBNAILS * concat::ThumbnailCache::THUMBNAIL_HEIGHT * 16 / 9,
+              concat::ThumbnailCache::THUMBNAIL_HEIGHT));
+    thumbnail_timer_.setSingleShot(true);
+    thumbnail_timer_.setInterval(THUMBNAIL_REQUEST_DELAY_MSEC);
+    connect(&thumbnail_timer_, &QTimer::timeout, this, &MainWindow::request_visible_thumbnails_);
+    connect(ui_->listWidget_files->verticalScrollBar(), &QScrollBar::valueChanged, &thumbnail_timer_,
+            qOverload<>(&QTimer::start));
+    connect(ui_->listWidget_files->model(), &QAbstractItemModel::rowsInserted, &thumbnail_timer_,
+            qOverload<>(&QTimer::start));
+    connect(ui_->listWidget_files->model(), &QAbstractItemModel::dataChanged, &thumbnail_timer_,
+            qOverload<>(&QTimer::start));
+    connect(ui_->listWidget_files->model(), &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex &top_left, const QModelIndex &bottom_right) {
+                invalidate_estimates_(top_left.row(), bottom_right.row());
+            });
+    connect(ui_->listWidget_files->model(), &QAbstractItemModel::rowsAboutToBeRemoved, this,
+            [this](const QModelIndex &, int first, int last) { invalidate_estimates_(first, last); });
+    // items keep their job ids when they are taken and added again, such as by sort_files_()
+    connect(ui_->listWidget_files->model(), &QAbstractItemModel::rowsInserted, this,
+            [this](const QModelIndex &, int first, int last) {
+                for (auto row = first; row <= last; row++) {
+                    register_job_id_(ui_->listWidget_files->item(row));
+                }
+            });
+    connect(ui_->listWidget_files->model(), &QAbstractItemModel::rowsAboutToBeRemoved, this,
+            [this](const QModelIndex &, int first, int last) {
+                for (auto row = first; row <= last; row++) {
+                    unregister_job_id_(ui_->listWidget_files->item(row));
+                }
+            });
     connect(ui_->pushButton_remove_item, &QPushButton::clicked, [this] {
         delete this->ui_->listWidget_files->takeItem(this->ui_->listWidget_files->currentRow());
         if (this->ui_->listWidget_files->count() == 0) {
@@ -114,9 +160,38 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui_(new Ui::MainW
     });
     connect(ui_->listWidget_files, &QListWidget::currentItemChanged, this, &MainWindow::update_output_infos_);
     connect(ui_->videoInfoWidget, &VideoInfoWidget::info_changed, this, &MainWindow::register_user_video_info_);
+    connect(ui_->videoInfoWidget, &VideoInfoWidget::crop_toggled, this, &MainWindow::register_user_crop_);
     connect(ui_->lineEdit_output_dir, &QLineEdit::textEdited, this, &MainWindow::register_user_output_path_);
     connect(ui_->lineEdit_output_filename, &QLineEdit::textEdited, this, &MainWindow::register_user_output_path_);
     connect(ui_->pushButton_sort, &QPushButton::clicked, this, &MainWindow::sort_files_);
+    connect(ui_->spinBox_priority, &QSpinBox::valueChanged, this, &MainWindow::register_user_priority_);
+    connect(ui_->actionmax_concurrent_jobs, &QAction::triggered, this, &MainWindow::update_max_concurrent_jobs_);
+    connect(ui_->actionmemory_budget, &QAction::triggered, this, &MainWindow::update_memory_budget_);
+    connect(ui_->actionadapt_concurrency_to_load, &QAction::toggled, this, &MainWindow::toggle_adapting_concurrency_);
+    connect(ui_->actionmin_concurrent_jobs, &QAction::triggered, this, &MainWindow::update_min_concurrent_jobs_);
+    connect(ui_->actionmin_free_disk_space, &QAction::triggered, this, &MainWindow::update_min_free_disk_space_);
+    connect(ui_->actionoverflow_dir, &QAction::triggered, this, &MainWindow::select_overflow_dir_);
+    connect(ui_->actionremote_workers, &QAction::triggered, this, &MainWindow::update_remote_workers_);
+    connect(ui_->actionthumbnail_cache_size, &QAction::triggered, this, &MainWindow::update_thumbnail_cache_size_);
+    connect(ui_->actioncheck_quality, &QAction::toggled, this, &MainWindow::toggle_checking_quality_);
+    connect(ui_->actionserve_status, &QAction::toggled, this, &MainWindow::toggle_serving_status_);
+    connect(ui_->actionsplit_audio_video, &QAction::toggled, this, &MainWindow::toggle_splitting_encodes_);
+    connect(ui_->actionscaling_algorithm, &QAction::triggered, this, &MainWindow::select_scaling_algorithm_);
+    connect(ui_->actiontrial_encode, &QAction::triggered, this, &MainWindow::start_trial_);
+    connect(ui_->actionconcatenate, &QAction::triggered, this, &MainWindow::concatenate_files_);
+    connect(ui_->actiontrim, &QAction::triggered, this, &MainWindow::trim_current_file_);
+    connect(ui_->actiontune_concurrency, &QAction::triggered, this, &MainWindow::tune_concurrency_);
+    connect(ui_->actionadd_rendition, &QAction::triggered, this, &MainWindow::add_rendition_);
+    connect(ui_->actionclear_renditions, &QAction::triggered, this, &MainWindow::clear_renditions_);
+    connect(ui_->actiondetect_black_bars, &QAction::triggered, this, &MainWindow::detect_black_bars_);
+    connect(ui_->actionscan_library, &QAction::triggered, this, &MainWindow::scan_library_);
+    connect(ui_->actionshow_background_processes, &QAction::triggered, this, &MainWindow::show_background_processes_);
+    connect(ui_->actionquality_thresholds, &QAction::triggered, this, &MainWindow::update_quality_thresholds_);
+    connect(ui_->actionwatch_folders, &QAction::toggled, this, &MainWindow::toggle_watching_folders_);
+    connect(ui_->actionadd_watch_folder, &QAction::triggered, this, &MainWindow::add_watch_folder_);
+    connect(ui_->actionclear_watch_folders, &QAction::triggered, this, &MainWindow::clear_watch_folders_);
+    connect(ui_->actionmax_queued_jobs_of_watch_folders, &QAction::triggered, this,
+            &MainWindow::update_max_queued_jobs_of_watch_folders_);
 
     QDir settings_dir(QApplication::applicationDirPath() + "/settings");
     if (QDir().mkpath(settings_dir.absolutePath())) {  // QDir::mkpath() returns true even when path already exists
@@ -136,12 +211,68 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui_(new Ui::MainW
                 ui_->comboBox_preset->addItem(QString::fromStdString(key));
             }
         }
+        ffmpeg_capabilities_ = concat::FfmpegCapabilities::load(settings_);
+        speed_history_ = concat::SpeedHistory(settings_dir.filePath("speed_history.json"));
+        library_index_ = concat::LibraryIndex(settings_dir.filePath("library_index.json"));
+        validate_presets_();
     }
     ui_->comboBox_preset->setCurrentText(settings_->value("default_preset", tr("custom")).toString());
+
+    process_runner_ = new concat::ProcessRunner(MAX_BACKGROUND_PROCESSES, this);
+    thumbnail_cache_ = new concat::ThumbnailCache(
+        QApplication::applicationDirPath() + "/cache/thumbnails",
+        settings_->value("thumbnail_cache/max_size_mib", DEFAULT_THUMBNAIL_CACHE_SIZE_MIB).toLongLong() * MIB,
+        process_runner_, this);
+    connect(thumbnail_cache_, &concat::ThumbnailCache::thumbnail_ready, this, &MainWindow::show_thumbnail_);
+    library_scanner_ = new concat::LibraryScanner(process_runner_, &library_index_, this);
+    connect(library_scanner_, &concat::LibraryScanner::file_scanned, this, &MainWindow::enqueue_noncompliant_file_);
+    connect(library_scanner_, &concat::LibraryScanner::file_failed, this, [](QString path, QString error) {
+        qWarning() << "failed to scan" << path << error;
+    });
+    connect(ui_->pushButton_clear, &QPushButton::clicked, thumbnail_cache_, &concat::ThumbnailCache::cancel_pending);
+
+    quality_checker_ = new concat::QualityChecker(ffmpeg_capabilities_.has_filter("libvmaf"), this);
+    connect(quality_checker_, &concat::QualityChecker::checked, this, &MainWindow::show_quality_scores_);
+    connect(quality_checker_, &concat::QualityChecker::idle, this, &MainWindow::report_low_quality_outputs_);
+    quality_thresholds_.min_psnr = settings_->value("quality_check/min_psnr", quality_thresholds_.min_psnr).toDouble();
+    quality_thresholds_.min_ssim = settings_->value("quality_check/min_ssim", quality_thresholds_.min_ssim).toDouble();
+    quality_thresholds_.min_vmaf = settings_->value("quality_check/min_vmaf", quality_thresholds_.min_vmaf).toDouble();
+    ui_->actioncheck_quality->setChecked(settings_->value("quality_check/enabled", false).toBool());
+    transcode_options_.scaling_algorithm =
+        settings_->value("scaling_algorithm", transcode_options_.scaling_algorithm).toString();
+
+    scheduler_ = new concat::EncodeScheduler(this);
+    scheduler_->set_max_concurrent_jobs(settings_->value("max_concurrent_jobs", 1).toInt());
+    scheduler_->set_memory_budget(settings_->value("memory_budget_mib", default_memory_budget_mib_()).toLongLong() *
+                                  MIB);
+    scheduler_->set_min_free_disk_space(
+        settings_->value("min_free_disk_space_mib", DEFAULT_MIN_FREE_DISK_SPACE_MIB).toLongLong() * MIB);
+    scheduler_->set_overflow_dir(settings_->value("overflow_dir").toString());
+    connect(scheduler_, &concat::EncodeScheduler::job_started, this, &MainWindow::show_started_job_);
+    connect(scheduler_, &concat::EncodeScheduler::job_output, this, &MainWindow::show_job_output_);
+    connect(scheduler_, &concat::EncodeScheduler::job_finished, this, &MainWindow::show_finished_job_);
+    connect(scheduler_, &concat::EncodeScheduler::job_progressed, this, &MainWindow::update_batch_progress_);
+    connect(scheduler_, &concat::EncodeScheduler::job_paused, this, &MainWindow::show_paused_job_);
+    connect(scheduler_, &concat::EncodeScheduler::job_resumed, this, &MainWindow::show_resumed_job_);
+    connect(scheduler_, &concat::EncodeScheduler::job_requeued, this, &MainWindow::show_requeued_job_);
+    connect(scheduler_, &concat::EncodeScheduler::job_redirected, this, &MainWindow::register_redirected_output_);
+    connect(scheduler_, &concat::EncodeScheduler::idle, this, &MainWindow::cleanup_after_saving_);
+    connect(scheduler_, &concat::EncodeScheduler::concurrency_adapted, this, &MainWindow::update_batch_estimate_);
+    ui_->actionadapt_concurrency_to_load->setChecked(settings_->value("adaptive_concurrency/enabled", false).toBool());
+    status_server_ = new concat::StatusServer(scheduler_, this);
+    connect(status_server_, &concat::StatusServer::cancel_requested, scheduler_, &concat::EncodeScheduler::cancel);
+    connect(status_server_, &concat::StatusServer::pause_requested, scheduler_, &concat::EncodeScheduler::pause);
+    connect(status_server_, &concat::StatusServer::resume_requested, scheduler_, &concat::EncodeScheduler::resume);
+    connect(status_server_, &concat::StatusServer::priority_change_requested, this, &MainWindow::reprioritize_job_);
+    ui_->actionserve_status->setChecked(settings_->value("status_server/enabled", false).toBool());
+    ui_->actionsplit_audio_video->setChecked(settings_->value("split_encode/enabled", false).toBool());
+    apply_remote_workers_();
+    update_batch_estimate_();
 }
 
 MainWindow::~MainWindow() {
     TRACE
+    library_index_.save();
     delete ui_;
     if (settings_ != nullptr) {
         settings_->deleteLater();
@@ -191,16 +322,18 @@ void MainWindow::open_video_() {
         QMessageBox::warning(nullptr, tr("warning"), tr("no file was selected"));
         return;
     }
+    bool is_opening = not current_unregistered_input_paths_.isEmpty();
     for (const auto &filename : filenames) {
         current_unregistered_input_paths_.push_back(QUrl::fromLocalFile(filename));
     }
-    QDir filedir{current_unregistered_input_paths_[0].toLocalFile()};
+    QDir filedir{filenames[0]};
     filedir.cdUp();
     write_video_dir_cache_(QUrl::fromLocalFile(filedir.path()));
     ui_->pushButton_save->setEnabled(true);
     ui_->pushButton_remove_item->setEnabled(true);
-    process_ = new ProcessWidget(true);
-    process_->setAttribute(Qt::WA_DeleteOnClose, true);
+    if (is_opening) {
+        return;  // picked up by register_video_info_(), as files opened before are still being registered
+    }
     create_savefile_name_();
 }
 
@@ -213,48 +346,34 @@ void MainWindow::select_output_dir_() {
     }
     ui_->lineEdit_output_dir->setText(output_dir);
 }
-namespace impl_ {
-constexpr Qt::ConnectionType ONESHOT_AUTO_CONNECTION =
-    static_cast<Qt::ConnectionType>(Qt::AutoConnection | Qt::SingleShotConnection);
-class OnTrue {
-    std::function<void(void)> func_;
-
-   public:
-    OnTrue(std::function<void(void)> func) : func_(func) { TRACE }
-    void operator()(bool arg) {
-        TRACE
-        if (arg) {
-            this->func_();
-        }
-    }
-};
-}  // namespace impl_
 void MainWindow::create_savefile_name_() {
     TRACE
     auto current_input_path = current_unregistered_input_paths_.front();
     auto new_item = new QListWidgetItem(current_input_path.toLocalFile());
-    new_item->setData(static_cast<int>(VideoDataRole::preset), settings_->value("default_preset", tr("custom")));
+    new_item->setData(static_cast<int>(VideoDataRole::preset), preset_of_(current_input_path));
     ui_->listWidget_files->addItem(new_item);
     QString filename = current_input_path.fileName();
     if (settings_->contains("savefile_name_plugin") && settings_->value("savefile_name_plugin") != NO_PLUGIN) {
-        process_->start(
+        process_runner_->run(
             PYTHON,
             {savefile_name_plugins_dir_().absoluteFilePath(settings_->value("savefile_name_plugin").toString()),
              filename},
-            false);
-        connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->register_savefile_name_(); }),
-                impl_::ONESHOT_AUTO_CONNECTION);
+            [this](const concat::ProcessResult &result) {
+                if (not result.is_success) {
+                    abort_opening_video_(tr("plugin error"),
+                                         tr("savefile name plugin failed\n%1").arg(result.stderr_text + result.error));
+                    return;
+                }
+                register_savefile_name_(result.stdout_text);
+            },
+            OPENING_PRIORITY);
     } else {
-        register_savefile_name_();
+        register_savefile_name_(filename);
     }
 }
-void MainWindow::register_savefile_name_() {
+void MainWindow::register_savefile_name_(const QString &default_savefile_name) {
     TRACE
     auto current_input_path = current_unregistered_input_paths_.front();
-    QString default_savefile_name = current_input_path.fileName();
-    if (settings_->contains("savefile_name_plugin") && settings_->value("savefile_name_plugin") != NO_PLUGIN) {
-        default_savefile_name = process_->get_stdout();
-    }
     QDir source_dir{current_input_path.toLocalFile()};
     source_dir.cdUp();
     auto current_index = ui_->listWidget_files->count() - 1;
@@ -266,372 +385,1863 @@ void MainWindow::register_savefile_name_() {
 void MainWindow::probe_for_video_info_() {
     TRACE
     auto current_input_path = current_unregistered_input_paths_.front();
-    QStringList ffprobe_arguments{"-hide_banner", "-show_streams", "-show_format", "-of", "json", "-v", "quiet"};
-    QString filename = current_input_path.toLocalFile();
-    process_->start("ffprobe", ffprobe_arguments + QStringList{filename}, false);
-    connect(process_, &ProcessWidget::finished, this, impl_::OnTrue([=] { this->register_video_info_(); }),
-            impl_::ONESHOT_AUTO_CONNECTION);
-}
-void MainWindow::register_video_info_() {
-    TRACE
-    auto current_input_path = current_unregistered_input_paths_.front();
-    QString filepath = current_input_path.toLocalFile();
-    QRegularExpression fraction_pattern(R"((\d+)/(\d+))");
-    QJsonParseError err;
-    auto prove_result = QJsonDocument::fromJson(process_->get_stdout().toUtf8(), &err);
-    if (prove_result.isNull()) {
-        QMessageBox::critical(this, tr("ffprobe parse error"),
-                              tr("failed to parse result of ffprobe\nerror message:%1").arg(err.errorString()));
+    QFileInfo file(current_input_path.toLocalFile());
+    auto indexed = library_index_.find(file);
+    if (indexed.has_value() && not indexed->vfr_confidence.has_value()) {
+        sample_frame_intervals_(file, indexed.value());  // indexed before vfr was sampled
         return;
     }
-    auto duration_str = prove_result.object()["format"].toObject()["duration"].toString();
-    bool ok;
-    double duration = duration_str.toDouble(&ok);
-    if (not ok) {
-        QMessageBox::critical(this, tr("ffprobe parse error"), tr("failed to parse duration [%1]").arg(duration_str));
+    if (indexed.has_value()) {
+        // queued, so that importing many indexed files doesn't recurse deeply
+        QMetaObject::invokeMethod(
+            this, [this, result = indexed.value()] { register_video_info_(result); }, Qt::QueuedConnection);
         return;
     }
-    auto current_index = ui_->listWidget_files->count() - 1;
-    auto source_length = QTime::fromMSecsSinceStartOfDay(
-        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(duration)).count());
-    ui_->listWidget_files->item(current_index)->setData(static_cast<int>(VideoDataRole::length), source_length);
-    auto info = concat::VideoInfo::create_input_info();
-    bool video_found = false, audio_found = false;
-    for (auto stream_value : prove_result.object()["streams"].toArray()) {
-        auto stream = stream_value.toObject();
-        if (stream["codec_type"] == "video") {
-            video_found = true;
-            info.video_codec = stream["codec_name"].toString();
-            info.resolution = QSize(stream["width"].toInt(), stream["height"].toInt());
-            auto match = fraction_pattern.match(stream["r_frame_rate"].toString());
-            bool ok1, ok2;
-            info.framerate = static_cast<double>(match.captured(1).toInt(&ok1)) / match.captured(2).toInt(&ok2);
-            if (not(ok1 && ok2)) {
-                QMessageBox::critical(this, tr("ffprobe parse error"),
-                                      tr("failed to parse frame rate [%1]").arg(stream["r_frame_rate"].toString()));
+    process_runner_->run(
+        "ffprobe", concat::probe_arguments(file.absoluteFilePath()),
+        [this, file](const concat::ProcessResult &result) {
+            if (not result.is_success) {
+                abort_opening_video_(tr("ffprobe error"),
+                                     tr("ffprobe failed\n%1").arg(result.stderr_text + result.error));
                 return;
             }
-            match = fraction_pattern.match(stream["avg_frame_rate"].toString());
-            double avg_framerate = static_cast<double>(match.captured(1).toInt(&ok1)) / match.captured(2).toInt(&ok2);
-            if (not(ok1 && ok2)) {
-                QMessageBox::critical(this, tr("ffprobe parse error"),
-                                      tr("failed to parse frame rate [%1]").arg(stream["r_frame_rate"].toString()));
+            QString error;
+            auto probe_result = concat::parse_probe_result(result.stdout_text, error);
+            if (not probe_result.has_value()) {
+                abort_opening_video_(tr("ffprobe parse error"), error);
                 return;
             }
-            info.is_vfr = std::get<double>(info.framerate) != avg_framerate;
-        } else if (stream["codec_type"] == "audio") {
-            audio_found = true;
-            info.audio_codec = stream["codec_name"].toString();
-        }
-    }
-    if (not video_found) {
-        QMessageBox::critical(this, tr("ffprobe parse error"), tr("video stream was not found"));
-        return;
-    }
-    if (not audio_found) {
-        QMessageBox::critical(this, tr("ffprobe parse error"), tr("audio stream was not found"));
-        return;
-    }
+            sample_frame_intervals_(file, probe_result.value());
+        },
+        OPENING_PRIORITY);
+}
+void MainWindow::sample_frame_intervals_(const QFileInfo &file, const concat::ProbeResult &probe_result) {
+    TRACE
+    concat::detect_vfr(
+        process_runner_, file.absoluteFilePath(), probe_result,
+        [this, file](concat::ProbeResult result) {
+            qDebug() << file.absoluteFilePath() << "is_vfr:" << result.info.is_vfr
+                     << "confidence:" << result.vfr_confidence.value_or(-1.0);
+            library_index_.insert(file, result);
+            register_video_info_(result);
+        },
+        OPENING_PRIORITY);
+}
+void MainWindow::register_video_info_(const concat::ProbeResult &probe_result) {
+    TRACE
+    auto current_input_path = current_unregistered_input_paths_.front();
+    auto current_index = ui_->listWidget_files->count() - 1;
+    auto source_length = QTime::fromMSecsSinceStartOfDay(static_cast<int>(probe_result.length.count()));
+    ui_->listWidget_files->item(current_index)->setData(static_cast<int>(VideoDataRole::length), source_length);
+    ui_->listWidget_files->item(current_index)
+        ->setData(static_cast<int>(VideoDataRole::source_time_base), probe_result.time_base);
+    ui_->listWidget_files->item(current_index)
+        ->setData(static_cast<int>(VideoDataRole::source_format), QVariant::fromValue(probe_result.format));
+    const auto &info = probe_result.info;
     ui_->listWidget_files->item(current_index)
         ->setData(static_cast<double>(VideoDataRole::source_video_info), QVariant::fromValue(info));
-    auto default_preset_name = settings_->value("default_preset", tr("custom")).toString();
     auto initial_output_info = concat::VideoInfo();
-    if (default_preset_name != tr("custom")) {
-        initial_output_info =
-            concat::VideoInfo::from_toml(presets_["VERSION"].as_integer(), presets_[default_preset_name.toStdString()]);
+    // preset of watched folder is kept in settings, and may have been renamed or removed from presets.toml since
+    QString preset_name = tr("custom");
+    for (const auto &name : {preset_of_(current_input_path), settings_->value("default_preset").toString()}) {
+        if (name.isEmpty() || name == tr("custom") || name == "custom") {
+            break;
+        }
+        if (presets_.as_table().count(name.toStdString()) == 0) {
+            qWarning() << "preset" << name << "no longer exists";
+            continue;
+        }
+        try {
+            initial_output_info =
+                concat::VideoInfo::from_toml(presets_["VERSION"].as_integer(), presets_[name.toStdString()]);
+            preset_name = name;
+            break;
+        } catch (std::exception &e) {
+            qWarning() << "failed to load preset" << name << e.what();
+        }
+    }
+    if (preset_name != preset_of_(current_input_path)) {
+        ui_->listWidget_files->item(current_index)->setData(static_cast<int>(VideoDataRole::preset), preset_name);
     }
     initial_output_info.bound_input_info(retrieve_input_info(info));
     ui_->listWidget_files->item(current_index)
         ->setData(static_cast<double>(VideoDataRole::output_video_info), QVariant::fromValue(initial_output_info));
+    unregistered_input_presets_.remove(current_input_path);
+    current_unregistered_input_paths_.pop_front();
+    if (not current_unregistered_input_paths_.isEmpty()) {
+        create_savefile_name_();
+    } else {
+        finish_opening_();
+    }
+}
+void MainWindow::abort_opening_video_(const QString &title, const QString &message) {
+    TRACE
+    auto current_input_path = current_unregistered_input_paths_.front();
+    // files of watched folders and library scans have presets of their own. nobody may be there to close dialogs
+    if (unregistered_input_presets_.contains(current_input_path)) {
+        qWarning() << title << current_input_path.toLocalFile() << message;
+        ui_->statusbar->showMessage(tr("%1: %2").arg(title, current_input_path.toLocalFile()));
+    } else {
+        QMessageBox::critical(this, title, message);
+    }
+    delete ui_->listWidget_files->takeItem(ui_->listWidget_files->count() - 1);  // added by create_savefile_name_()
+    unregistered_input_presets_.remove(current_input_path);
     current_unregistered_input_paths_.pop_front();
     if (not current_unregistered_input_paths_.isEmpty()) {
         create_savefile_name_();
     } else {
-        process_->close();
-        ui_->listWidget_files->setCurrentRow(0);
-        update_output_infos_();
+        finish_opening_();
+    }
+    update_watch_back_pressure_();
+}
+void MainWindow::finish_opening_() {
+    TRACE
+    library_index_.save();
+    ui_->listWidget_files->setCurrentRow(0);
+    update_output_infos_();
+    if (ui_->actionwatch_folders->isChecked()) {
+        continue_saving_();
+    }
+}
+void MainWindow::show_background_processes_() {
+    TRACE
+    if (not background_process_view_.isNull()) {
+        background_process_view_->raise();
+        background_process_view_->activateWindow();
+        return;
     }
+    // only commands started after this is shown are listed
+    background_process_view_ = new ProcessWidget(false, false, this, Qt::Window);
+    background_process_view_->setWindowTitle(tr("background processes"));
+    background_process_view_->setAttribute(Qt::WA_DeleteOnClose, true);
+    connect(process_runner_, &concat::ProcessRunner::started, background_process_view_,
+            [this](int id, QString program, QStringList arguments) {
+                background_process_view_->add_job(id, program, arguments);
+            });
+    connect(process_runner_, &concat::ProcessRunner::output, background_process_view_,
+            &ProcessWidget::append_job_output);
+    connect(process_runner_, &concat::ProcessRunner::finished, background_process_view_, &ProcessWidget::finish_job);
+    connect(background_process_view_, &ProcessWidget::cancel_requested, process_runner_,
+            &concat::ProcessRunner::cancel);
+    background_process_view_->show();
 }
 namespace impl_ {
 int decode_ffmpeg(QStringView, QStringView new_stderr) {
     TRACE
-    QRegularExpression time_pattern(R"(time=(?<hours>\d\d):(?<minutes>\d\d):(?<seconds>\d\d).(?<centiseconds>\d\d))");
-    auto match = time_pattern.match(new_stderr);
-    if (not match.hasMatch()) {
+    auto time = concat::parse_ffmpeg_time(new_stderr);
+    if (not time.has_value()) {
         return -1;
     }
-    using std::chrono::duration_cast;
-    using std::chrono::hours;
-    using std::chrono::minutes;
-    using std::chrono::seconds;
-    using centiseconds = std::chrono::duration<int, std::centi>;
-    using std::chrono::milliseconds;
-    return duration_cast<milliseconds>(
-               hours(match.captured("hours").toInt()) + minutes(match.captured("minutes").toInt()) +
-               seconds(match.captured("seconds").toInt()) + centiseconds(match.captured("centiseconds").toInt()))
-        .count();
+    return static_cast<int>(time->count());
 }
 }  // namespace impl_
-void MainWindow::re_encode_video_() {
+concat::EncodeJob MainWindow::create_encode_job_(QListWidgetItem *item) {
     TRACE
-    bool resolution_changed = false, audio_codec_changed = false, video_codec_changed = false;
-    auto current_item = ui_->listWidget_files->item(encoding_loop_current_index_);
-    auto output_video_info =
-        current_item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
-    auto source_video_info =
-        current_item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
     output_video_info.resolve_reference();
-    VIDEO_RE_ENCODER_TRY_VARIANT {
-        if (std::get<QSize>(output_video_info.resolution) != std::get<QSize>(source_video_info.resolution)) {
-            resolution_changed = true;
+    auto plan = concat::plan_transcode(source_video_info, output_video_info, transcode_options_of_(item));
+    auto length =
+        std::chrono::milliseconds(item->data(static_cast<int>(VideoDataRole::length)).toTime().msecsSinceStartOfDay());
+    auto source_size = QFileInfo(item->text()).size();
+    auto trim = trim_of_(item);
+    if (trim.has_value()) {
+        // input options, so that only trimmed range is decoded
+        output_video_info.input_file_args =
+            concat::trim_input_arguments(trim.value()) + output_video_info.input_file_args;
+        if (length.count() > 0) {
+            source_size = source_size * trim->length().count() / length.count();
         }
+        length = trim->length();
     }
-    VIDEO_RE_ENCODER_CATCH_VARIANT_2(output_video_info.resolution, source_video_info.resolution);
-    VIDEO_RE_ENCODER_TRY_VARIANT {
-        if (std::get<QString>(output_video_info.audio_codec) != std::get<QString>(source_video_info.audio_codec)) {
-            audio_codec_changed = true;
+    auto output_path = item->data(static_cast<int>(VideoDataRole::output_path)).toUrl().toLocalFile();
+    concat::EncodeJob job;
+    job.program = "ffmpeg";
+    job.input_path = item->text();
+    job.output_path = output_path;
+    job.length = length;
+    job.cost = concat::estimate_cost(source_video_info, output_video_info, length, transcode_options_of_(item));
+    job.memory = concat::estimate_memory(source_video_info, output_video_info, transcode_options_of_(item));
+    job.output_size =
+        concat::estimate_output_size(source_video_info, output_video_info, plan, length, source_size,
+                                     speed_history_.output_bitrate(speed_history_key_(item)));
+    auto renditions = renditions_of_(item);
+    if (renditions.isEmpty()) {
+        job.arguments = plan.arguments(item->text(), output_video_info);
+        job.arguments << "-n";  // never overwrite, as ffmpeg would wait for answer from stdin
+        job.arguments << output_path;
+    } else {
+        for (const auto &rendition : renditions) {
+            job.extra_output_paths << rendition.output_path;
+            // source is decoded only once, so this overestimates cost of renditions a little
+            job.cost +=
+                concat::estimate_cost(source_video_info, rendition.output_info, length, transcode_options_of_(item));
+            job.memory +=
+                concat::estimate_memory(source_video_info, rendition.output_info, transcode_options_of_(item));
+            auto rendition_plan =
+                concat::plan_transcode(source_video_info, rendition.output_info, transcode_options_of_(item));
+            job.output_size += concat::estimate_output_size(source_video_info, rendition.output_info, rendition_plan,
+                                                            length, source_size);
         }
+        renditions.prepend({output_video_info, output_path});
+        job.arguments =
+            concat::rendition_arguments(item->text(), source_video_info, renditions, transcode_options_of_(item));
     }
-    VIDEO_RE_ENCODER_CATCH_VARIANT_2(output_video_info.audio_codec, source_video_info.audio_codec);
-    VIDEO_RE_ENCODER_TRY_VARIANT {
-        if (std::get<QString>(output_video_info.video_codec) != std::get<QString>(source_video_info.video_codec)) {
-            video_codec_changed = true;
-        }
+    job.priority = item->data(static_cast<int>(VideoDataRole::priority)).toInt();
+    job.predicted_duration = speed_history_.predict(speed_history_key_(item), job.length, job.cost).duration;
+    return job;
+}
+concat::SpeedHistory::Key MainWindow::speed_history_key_(QListWidgetItem *item) {
+    TRACE
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    output_video_info.resolve_reference();
+    concat::SpeedHistory::Key key;
+    if (auto resolution = std::get_if<QSize>(&source_video_info.resolution)) {
+        key.source_resolution = *resolution;
     }
-    VIDEO_RE_ENCODER_CATCH_VARIANT_2(output_video_info.video_codec, source_video_info.video_codec);
-    QStringList arguments;
-    VIDEO_RE_ENCODER_TRY_VARIANT {
-        // clang-format off
-        arguments << output_video_info.input_file_args
-                  << "-i" << current_item->text()
-                  << "-c:a" << (audio_codec_changed? std::get<QString>(output_video_info.audio_codec) : "copy")
-                  << "-c:v" << (video_codec_changed? std::get<QString>(output_video_info.video_codec) : "copy");
-        // clang-format on
+    if (auto codec = std::get_if<QString>(&source_video_info.video_codec)) {
+        key.source_codec = *codec;
     }
-    VIDEO_RE_ENCODER_CATCH_VARIANT_2(output_video_info.audio_codec, output_video_info.video_codec);
-    VIDEO_RE_ENCODER_TRY_VARIANT {
-        if (resolution_changed) {
-            auto resolution = std::get<QSize>(output_video_info.resolution);
-            arguments << "-s" << QStringLiteral("%1x%2").arg(resolution.width()).arg(resolution.height());
+    key.target_codec =
+        concat::plan_transcode(source_video_info, output_video_info, transcode_options_of_(item)).video_codec;
+    key.preset = item->data(static_cast<int>(VideoDataRole::preset)).toString();
+    key.host = QSysInfo::machineHostName();
+    return key;
+}
+void MainWindow::enqueue_new_items_() {
+    TRACE
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        auto item = ui_->listWidget_files->item(i);
+        if (item->data(static_cast<int>(VideoDataRole::job_id)).isValid()) {
+            continue;
+        }
+        if (is_smart_trimmed_(item)) {
+            start_trimming_(item);
+            continue;
         }
+        auto job = create_encode_job_(item);
+        if (is_split_(item)) {
+            start_splitting_(item, job);
+            continue;
+        }
+        apply_tuned_threads_(item, job);
+        enqueue_item_job_(item, job);
+    }
+    update_batch_progress_();
+    update_watch_back_pressure_();
+}
+void MainWindow::enqueue_item_job_(QListWidgetItem *item, const concat::EncodeJob &job) {
+    TRACE
+    qDebug() << __FUNCTION__ << job.arguments;
+    auto id = scheduler_->enqueue(job);
+    set_job_id_(item, id);
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    auto framerate = std::get_if<double>(&source_video_info.framerate);
+    auto frames = framerate != nullptr ? *framerate * std::chrono::duration<double>(job.length).count() : 0.0;
+    speed_samples_of_jobs_.insert(id, {speed_history_key_(item), frames});
+}
+void MainWindow::create_encode_process_(bool is_modal) {
+    TRACE
+    encode_process_ = new ProcessWidget(false, true, this,
+                                        Qt::Window | Qt::CustomizeWindowHint | Qt::WindowMinMaxButtonsHint);
+    if (is_modal) {
+        encode_process_->setWindowModality(Qt::WindowModal);
+    }
+    encode_process_->setAttribute(Qt::WA_DeleteOnClose, true);
+    connect(encode_process_, &ProcessWidget::cancel_requested, scheduler_, &concat::EncodeScheduler::cancel);
+    connect(encode_process_, &ProcessWidget::pause_requested, scheduler_, &concat::EncodeScheduler::pause);
+    connect(encode_process_, &ProcessWidget::resume_requested, scheduler_, &concat::EncodeScheduler::resume);
+    connect(encode_process_, &ProcessWidget::priority_change_requested, this, &MainWindow::reprioritize_job_);
+    encode_process_->show();
+}
+void MainWindow::show_started_job_(int id) {
+    TRACE
+    if (scheduler_->is_remote(id)) {
+        speed_samples_of_jobs_.remove(id);  // speed history is kept per host
+    }
+    if (encode_process_.isNull()) {
+        return;
     }
-    VIDEO_RE_ENCODER_CATCH_VARIANT(output_video_info.resolution);
-    arguments += output_video_info.encoding_args;
-    arguments << current_item->data(static_cast<int>(VideoDataRole::output_path)).toUrl().toLocalFile();
+    const auto &job = scheduler_->job(id);
     using VT = ProcessWidget::ProgressParams::ValueType;
     auto format = [](VT value) {
         return QTime::fromMSecsSinceStartOfDay(value).toString(tr("hh'h'mm'm'ss's'zzz'ms'"));
     };
-    qDebug() << __FUNCTION__ << arguments;
-    process_->start("ffmpeg", arguments, encoding_loop_current_index_ == ui_->listWidget_files->count() - 1,
-                    {0, current_item->data(static_cast<int>(VideoDataRole::length)).toTime().msecsSinceStartOfDay(),
-                     impl_::decode_ffmpeg,
-                     [format](VT, VT current, VT total) {
-                         return QStringLiteral("%1/%2").arg(format(current)).arg(format(total));
-                     }},
-                    current_item->data(static_cast<int>(VideoDataRole::length)).toTime());
-    connect(process_, &ProcessWidget::finished, this, &MainWindow::check_loop_state_, impl_::ONESHOT_AUTO_CONNECTION);
+    auto length = static_cast<VT>(job.length.count());
+    encode_process_->add_job(id, job.program, job.arguments,
+                             {0, length, impl_::decode_ffmpeg, [format](VT, VT current, VT total) {
+                                  return QStringLiteral("%1/%2").arg(format(current)).arg(format(total));
+                              }});
+    encode_process_->set_job_priority(id, job.priority);
 }
-void MainWindow::check_loop_state_() {
+void MainWindow::show_paused_job_(int id) {
     TRACE
-    if (++encoding_loop_current_index_ < ui_->listWidget_files->count()) {
-        re_encode_video_();
+    if (not encode_process_.isNull()) {
+        encode_process_->set_job_paused(id, true);
     }
 }
-void MainWindow::cleanup_after_saving_() { TRACE }
-void MainWindow::start_saving_() {
+void MainWindow::show_resumed_job_(int id) {
     TRACE
-    int total_length = 0;
-    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
-        total_length += ui_->listWidget_files->item(i)
-                            ->data(static_cast<int>(VideoDataRole::length))
-                            .toTime()
-                            .msecsSinceStartOfDay();
-    }
-    process_ = new ProcessWidget(false, QTime::fromMSecsSinceStartOfDay(total_length), this,
-                                 Qt::Window | Qt::CustomizeWindowHint | Qt::WindowMinMaxButtonsHint);
-    process_->setWindowModality(Qt::WindowModal);
-    process_->setAttribute(Qt::WA_DeleteOnClose, true);
-    process_->show();
-    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
-        auto output_path = ui_->listWidget_files->item(i)->data(static_cast<int>(VideoDataRole::output_path)).toUrl();
-        if (QFile{output_path.toLocalFile()}.exists()) {
-            QMessageBox::warning(
-                nullptr, tr("existing file"),
-                tr("file '%1' already exists. This software currently doesn't support overwriting file.")
-                    .arg(output_path.toLocalFile()));
-            process_->close();
-            return;
-        }
+    if (not encode_process_.isNull()) {
+        encode_process_->set_job_paused(id, false);
     }
-    encoding_loop_current_index_ = 0;
-    re_encode_video_();
 }
-void MainWindow::update_output_infos_() {
+void MainWindow::show_requeued_job_(int id) {
     TRACE
-    auto new_item = ui_->listWidget_files->currentItem();
-    if (new_item == nullptr) {
-        qDebug() << "new_item is nullptr";
-        return;
+    if (not encode_process_.isNull()) {
+        encode_process_->append_job_output(
+            id, QString(), tr("\nkilled for lack of memory. this job is retried with fewer concurrent jobs.\n"));
+        encode_process_->finish_job(id, false);
     }
-    ui_->videoInfoWidget->set_infos(
-        new_item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>(),
-        retrieve_input_info(
-            new_item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>()));
-    change_preset_(new_item->data(static_cast<int>(VideoDataRole::preset)).toString());
-    auto output_path = new_item->data(static_cast<int>(VideoDataRole::output_path)).toUrl();
-    auto output_dir = QDir{output_path.toLocalFile()};
-    output_dir.cdUp();
-    ui_->lineEdit_output_dir->setText(output_dir.absolutePath());
-    ui_->lineEdit_output_filename->setText(QFileInfo{output_path.toLocalFile()}.fileName());
-    ui_->timeEdit_item_length->setTime(new_item->data(static_cast<int>(VideoDataRole::length)).toTime());
-    update_total_length_();
+    stderr_of_renditions_.remove(id);  // errors of the killed run don't belong to the retry
+    update_batch_progress_();
 }
-void MainWindow::update_total_length_() {
+void MainWindow::register_redirected_output_(int id, QString output_path) {
     TRACE
-    int total_length = 0;
-    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
-        total_length += ui_->listWidget_files->item(i)
-                            ->data(static_cast<int>(VideoDataRole::length))
-                            .toTime()
-                            .msecsSinceStartOfDay();
+    auto item = item_of_job_(id);
+    if (item != nullptr) {
+        item->setData(static_cast<int>(VideoDataRole::output_path), QUrl::fromLocalFile(output_path));
     }
-    ui_->timeEdit->setTime(QTime::fromMSecsSinceStartOfDay(total_length));
 }
-void MainWindow::register_output_path_() {
+void MainWindow::reprioritize_job_(int id, int priority) {
     TRACE
-    auto path =
-        QUrl::fromLocalFile(QDir{ui_->lineEdit_output_dir->text()}.filePath(ui_->lineEdit_output_filename->text()));
-    auto current_item = ui_->listWidget_files->currentItem();
-    if (current_item == nullptr) {
+    scheduler_->set_priority(id, priority);
+    auto item = item_of_job_(id);
+    if (item == nullptr) {
         return;
     }
-    current_item->setData(static_cast<int>(VideoDataRole::output_path), path);
+    item->setData(static_cast<int>(VideoDataRole::priority), priority);
+    if (item == ui_->listWidget_files->currentItem()) {
+        QSignalBlocker blocker(ui_->spinBox_priority);
+        ui_->spinBox_priority->setValue(priority);
+    }
 }
-void MainWindow::save_result_() {
+QListWidgetItem *MainWindow::item_of_job_(int id) {
     TRACE
-    start_saving_();
+    return items_of_jobs_.value(id, nullptr);
 }
-
-int MainWindow::savefile_name_plugin_index_() {
+void MainWindow::set_job_id_(QListWidgetItem *item, const QVariant &id) {
     TRACE
-    int result = 0;
-    if (settings_->contains("savefile_name_plugin")) {
-        int raw_idx = savefile_name_plugins_().indexOf(settings_->value("savefile_name_plugin"));
-        result = qMax(raw_idx, 0);
-    }
-
-    return result;
+    unregister_job_id_(item);
+    item->setData(static_cast<int>(VideoDataRole::job_id), id);
+    register_job_id_(item);
 }
-QDir MainWindow::savefile_name_plugins_dir_() {
+void MainWindow::register_job_id_(QListWidgetItem *item) {
     TRACE
-    return QDir(QApplication::applicationDirPath() + "/plugins/savefile_name");
+    auto id = item->data(static_cast<int>(VideoDataRole::job_id));
+    if (not id.isValid()) {
+        num_unenqueued_items_++;
+        return;
+    }
+    // several items may be preparing at once, and none of them has a job yet
+    if (id.toInt() != PREPARING_JOB_ID) {
+        items_of_jobs_.insert(id.toInt(), item);
+    }
 }
-QStringList MainWindow::search_savefile_name_plugins_() {
+void MainWindow::unregister_job_id_(QListWidgetItem *item) {
     TRACE
-    return savefile_name_plugins_dir_().entryList({"*.py"}, QDir::Files);
+    auto id = item->data(static_cast<int>(VideoDataRole::job_id));
+    if (not id.isValid()) {
+        num_unenqueued_items_--;
+        return;
+    }
+    if (items_of_jobs_.value(id.toInt()) == item) {
+        items_of_jobs_.remove(id.toInt());
+    }
 }
-
-QStringList MainWindow::savefile_name_plugins_() {
+void MainWindow::show_quality_scores_(int id, concat::QualityScores scores, bool is_success) {
     TRACE
-    return QStringList{NO_PLUGIN} + search_savefile_name_plugins_();
+    const auto &job = scheduler_->job(id);
+    bool is_acceptable = is_success && quality_thresholds_.is_satisfied_by(scores);
+    auto message = is_success ? tr("quality check: %1").arg(scores.to_string()) : tr("quality check failed");
+    if (not is_acceptable) {
+        outputs_below_quality_thresholds_ << QStringLiteral("%1: %2").arg(job.output_path).arg(message);
+    }
+    if (not encode_process_.isNull()) {
+        encode_process_->append_job_output(id, QString(), QStringLiteral("\n%1\n").arg(message));
+    }
+    auto item = item_of_job_(id);
+    if (item == nullptr) {
+        return;
+    }
+    if (is_success) {
+        item->setData(static_cast<int>(VideoDataRole::quality_scores), QVariant::fromValue(scores));
+    }
+    item->setToolTip(message);
+    item->setForeground(is_acceptable ? QBrush() : QBrush(Qt::red));
 }
-
-void MainWindow::select_savefile_name_plugin_() {
+void MainWindow::report_low_quality_outputs_() {
     TRACE
-    QString plugin = NO_PLUGIN;
-    bool confirmed;
-    plugin = QInputDialog::getItem(this, tr("select plugin"), tr("Select savefile name plugin."),
-                                   savefile_name_plugins_(), savefile_name_plugin_index_(), false, &confirmed);
-    if (confirmed && settings_ != nullptr) {
-        settings_->setValue("savefile_name_plugin", plugin);
+    if (outputs_below_quality_thresholds_.isEmpty()) {
+        return;
     }
+    QMessageBox::warning(nullptr, tr("low quality outputs"),
+                         tr("following outputs are below quality thresholds.\n%1")
+                             .arg(outputs_below_quality_thresholds_.join('\n')));
+    outputs_below_quality_thresholds_.clear();
 }
-
-void MainWindow::select_default_preset_() {
+void MainWindow::show_job_output_(int id, QString stdout_text, QString stderr_text) {
+    if (not encode_process_.isNull()) {
+        encode_process_->append_job_output(id, stdout_text, stderr_text);
+    }
+    if (not scheduler_->job(id).extra_output_paths.isEmpty()) {
+        stderr_of_renditions_[id] += stderr_text;
+    }
+}
+void MainWindow::show_finished_job_(int id, bool is_success) {
     TRACE
-    QStringList presets(tr("custom"));
-    for (const auto &[key, value] : presets_.as_table()) {
-        if (key == "VERSION") {
-            continue;
-        }
-        presets << QString::fromStdString(key);
+    if (not encode_process_.isNull()) {
+        encode_process_->finish_job(id, is_success);
     }
-    bool confirmed = false;
-    auto default_preset = QInputDialog::getItem(nullptr, tr("default preset"), tr("select default preset"), presets, 0,
-                                                false, &confirmed);
-    if (confirmed) {
-        if (default_preset == tr("custom")) {
-            default_preset = "custom";
+    continue_concatenating_(id, is_success);
+    continue_staging_(id, is_success);
+    report_renditions_(id, is_success);
+    auto item = item_of_job_(id);
+    if (is_success && speed_samples_of_jobs_.contains(id)) {
+        auto [key, frames] = speed_samples_of_jobs_.value(id);
+        const auto &job = scheduler_->job(id);
+        speed_history_.record(key, job.length, frames, job.cost, scheduler_->wall_time(id),
+                              QFileInfo(job.output_path).size());
+        repredict_estimates_();
+        update_batch_estimate_();
+    }
+    speed_samples_of_jobs_.remove(id);
+    // trimmed output can't be compared with whole source
+    if (is_success && item != nullptr && ui_->actioncheck_quality->isChecked() && not trim_of_(item).has_value()) {
+        const auto &job = scheduler_->job(id);
+        auto source_video_info =
+            item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+        QSize source_resolution;
+        if (auto resolution = std::get_if<QSize>(&source_video_info.resolution)) {
+            source_resolution = *resolution;
         }
-        settings_->setValue("default_preset", default_preset);
+        quality_checker_->check(id, job.input_path, job.output_path, source_resolution, job.length,
+                                transcode_options_of_(item).crop);
     }
+    update_batch_progress_();
+    update_watch_back_pressure_();
 }
-
-void MainWindow::change_preset_(QString name) {
+void MainWindow::update_batch_progress_() {
+    if (encode_process_.isNull()) {
+        return;
+    }
+    auto total_cost = scheduler_->batch_total_cost();
+    encode_process_->set_batch_progress(total_cost > 0.0 ? scheduler_->batch_finished_cost() / total_cost : 0.0);
+}
+void MainWindow::cleanup_after_saving_() {
     TRACE
-    if (ui_->listWidget_files->count() == 0) {
+    if (not encode_process_.isNull()) {
+        encode_process_->finish_batch();
+    }
+}
+void MainWindow::start_saving_() {
+    TRACE
+    QStringList unsupported_settings;
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        auto item = ui_->listWidget_files->item(i);
+        auto output_video_info =
+            item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+        for (const auto &problem : ffmpeg_capabilities_.validate(output_video_info)) {
+            unsupported_settings << QStringLiteral("%1: %2").arg(item->text()).arg(problem);
+        }
+    }
+    if (not unsupported_settings.isEmpty()) {
+        QMessageBox::warning(nullptr, tr("unsupported settings"),
+                             tr("installed ffmpeg doesn't support following settings.\n%1")
+                                 .arg(unsupported_settings.join('\n')));
         return;
     }
-    auto current_item = ui_->listWidget_files->currentItem();
-    if (current_item == nullptr) {
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        auto item = ui_->listWidget_files->item(i);
+        QStringList output_paths{item->data(static_cast<int>(VideoDataRole::output_path)).toUrl().toLocalFile()};
+        for (const auto &rendition : renditions_of_(item)) {
+            output_paths << rendition.output_path;
+        }
+        for (const auto &output_path : output_paths) {
+            if (QFile{output_path}.exists()) {
+                QMessageBox::warning(
+                    nullptr, tr("existing file"),
+                    tr("file '%1' already exists. This software currently doesn't support overwriting file.")
+                        .arg(output_path));
+                return;
+            }
+        }
+    }
+    if (not confirm_disk_space_()) {
         return;
     }
-    auto source_video_info =
-        current_item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
-    auto current_output_info =
-        current_item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
-    auto current_preset = current_item->data(static_cast<int>(VideoDataRole::preset)).toString();
-    if (name == tr("custom")) {
-        ui_->videoInfoWidget->setEnabled(true);
-        ui_->videoInfoWidget->set_infos(current_output_info, retrieve_input_info(source_video_info));
-    } else {
-        ui_->videoInfoWidget->setEnabled(false);
-        if (current_preset == tr("custom")) {
-            current_item->setData(static_cast<int>(VideoDataRole::output_video_info),
-                                  QVariant::fromValue(ui_->videoInfoWidget->info()));
+    create_encode_process_(true);
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        set_job_id_(ui_->listWidget_files->item(i), QVariant());
+    }
+    enqueue_new_items_();
+}
+bool MainWindow::confirm_disk_space_() {
+    TRACE
+    struct Usage {
+        QString output_dir;
+        qint64 output_size = 0;
+        qint64 available = 0;
+    };
+    QHash<quint64, Usage> usages;
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        auto job = create_encode_job_(ui_->listWidget_files->item(i));
+        auto space = concat::read_disk_space(job.output_path);
+        if (not space.has_value()) {
+            continue;
         }
-        try {
-            ui_->videoInfoWidget->set_infos(
-                concat::VideoInfo::from_toml(presets_["VERSION"].as_integer(), presets_[name.toStdString()]),
-                retrieve_input_info(source_video_info));
-        } catch (std::exception &e) {
-            QMessageBox::warning(nullptr, tr("warning"),
-                                 tr("failed to load preset '%1' info: \n%2").arg(name).arg(e.what()));
+        auto &usage = usages[space->device];
+        usage.output_dir = QFileInfo(job.output_path).absolutePath();
+        usage.output_size += job.output_size;
+        usage.available = space->available - scheduler_->min_free_disk_space();
+    }
+    QStringList shortages;
+    for (const auto &usage : usages) {
+        if (usage.output_size > usage.available) {
+            shortages << tr("%1: %2 MiB of outputs, %3 MiB available")
+                             .arg(usage.output_dir)
+                             .arg(usage.output_size / MIB)
+                             .arg(qMax(usage.available, qint64(0)) / MIB);
         }
     }
-    current_item->setData(static_cast<int>(VideoDataRole::preset), name);
+    if (shortages.isEmpty()) {
+        return true;
+    }
+    auto fallback = scheduler_->overflow_dir().isEmpty()
+                        ? tr("jobs which don't fit will wait until disk space is freed.")
+                        : tr("jobs which don't fit will be written to %1.").arg(scheduler_->overflow_dir());
+    return QMessageBox::question(this, tr("not enough disk space"),
+                                 tr("estimated outputs may not fit free disk space.\n%1\n%2\ncontinue?")
+                                     .arg(shortages.join('\n'))
+                                     .arg(fallback)) == QMessageBox::Yes;
 }
-void MainWindow::register_user_video_info_(concat::VideoInfo new_value) {
+void MainWindow::continue_saving_() {
     TRACE
-    auto current_item = ui_->listWidget_files->currentItem();
-    if (current_item == nullptr) {
-        return;
+    if (encode_process_.isNull()) {
+        create_encode_process_(false);
     }
-    current_item->setData(static_cast<int>(VideoDataRole::output_video_info), QVariant::fromValue(new_value));
+    enqueue_new_items_();
 }
-void MainWindow::register_user_output_path_() {
+void MainWindow::update_max_concurrent_jobs_() {
     TRACE
-    auto new_value =
-        QUrl::fromLocalFile(QDir{ui_->lineEdit_output_dir->text()}.filePath(ui_->lineEdit_output_filename->text()));
-    auto current_item = ui_->listWidget_files->currentItem();
-    if (current_item == nullptr) {
-        return;
+    bool confirmed = false;
+    auto max_concurrent_jobs =
+        QInputDialog::getInt(this, tr("max concurrent jobs"), tr("enter number of encodes executed at the same time"),
+                             scheduler_->max_concurrent_jobs(), 1, QThread::idealThreadCount(), 1, &confirmed);
+    if (confirmed) {
+        settings_->setValue("max_concurrent_jobs", max_concurrent_jobs);
+        scheduler_->set_max_concurrent_jobs(max_concurrent_jobs);
+        update_batch_estimate_();
     }
-    current_item->setData(static_cast<int>(VideoDataRole::output_path), new_value);
 }
-void MainWindow::sort_files_() {
+void MainWindow::toggle_adapting_concurrency_(bool enabled) {
     TRACE
-    QVector<QListWidgetItem *> items;
-    while (ui_->listWidget_files->count() != 0) {
-        items.push_back(ui_->listWidget_files->takeItem(0));
+    settings_->setValue("adaptive_concurrency/enabled", enabled);
+    apply_adaptive_concurrency_();
+}
+void MainWindow::update_min_concurrent_jobs_() {
+    TRACE
+    bool confirmed = false;
+    auto min_concurrent_jobs = QInputDialog::getInt(
+        this, tr("min concurrent jobs"),
+        tr("enter number of encodes executed at the same time even while system is under heavy load"),
+        scheduler_->min_concurrent_jobs(), 1, scheduler_->max_concurrent_jobs(), 1, &confirmed);
+    if (confirmed) {
+        settings_->setValue("adaptive_concurrency/min_concurrent_jobs", min_concurrent_jobs);
+        apply_adaptive_concurrency_();
     }
-    std::sort(items.begin(), items.end(), [](QListWidgetItem *one, QListWidgetItem *the_other) {
-        auto length_role = static_cast<int>(MainWindow::VideoDataRole::length);
-        return one->data(length_role).toTime() < the_other->data(length_role).toTime();
-    });
-    for (auto item : items) {
+}
+void MainWindow::apply_adaptive_concurrency_() {
+    TRACE
+    // thresholds are rarely changed, so they are only editable in settings file
+    settings_->beginGroup("adaptive_concurrency");
+    concat::LoadThresholds thresholds;
+    thresholds.cpu_pressure = settings_->value("cpu_pressure", thresholds.cpu_pressure).toDouble();
+    thresholds.memory_pressure = settings_->value("memory_pressure", thresholds.memory_pressure).toDouble();
+    thresholds.io_pressure = settings_->value("io_pressure", thresholds.io_pressure).toDouble();
+    thresholds.load_per_cpu = settings_->value("load_per_cpu", thresholds.load_per_cpu).toDouble();
+    scheduler_->set_adaptive_concurrency(settings_->value("enabled", false).toBool(),
+                                         settings_->value("min_concurrent_jobs", 1).toInt(), thresholds);
+    settings_->endGroup();
+    update_batch_estimate_();
+}
+void MainWindow::update_min_free_disk_space_() {
+    TRACE
+    bool confirmed = false;
+    auto min_free_disk_space_mib = QInputDialog::getInt(
+        this, tr("min free disk space"),
+        tr("enter disk space in MiB which is left free after outputs of running encodes are written"),
+        static_cast<int>(scheduler_->min_free_disk_space() / MIB), 0, std::numeric_limits<int>::max(), 1024,
+        &confirmed);
+    if (confirmed) {
+        settings_->setValue("min_free_disk_space_mib", min_free_disk_space_mib);
+        scheduler_->set_min_free_disk_space(min_free_disk_space_mib * MIB);
+    }
+}
+void MainWindow::select_overflow_dir_() {
+    TRACE
+    auto overflow_dir = QFileDialog::getExistingDirectory(
+        this, tr("directory for outputs which don't fit their own disk. cancel to disable"),
+        scheduler_->overflow_dir());
+    settings_->setValue("overflow_dir", overflow_dir);
+    scheduler_->set_overflow_dir(overflow_dir);
+}
+qint64 MainWindow::default_memory_budget_mib_() {
+    TRACE
+    auto total_memory = concat::read_total_memory();
+    if (not total_memory.has_value()) {
+        return 0;
+    }
+    return static_cast<qint64>(static_cast<double>(total_memory.value() / MIB) * DEFAULT_MEMORY_BUDGET_RATIO);
+}
+void MainWindow::update_memory_budget_() {
+    TRACE
+    bool confirmed = false;
+    auto memory_budget_mib = QInputDialog::getInt(
+        this, tr("memory budget"),
+        tr("enter memory in MiB which encodes running at the same time may use in total. 0 means unlimited"),
+        static_cast<int>(scheduler_->memory_budget() / MIB), 0, std::numeric_limits<int>::max(), 1024, &confirmed);
+    if (confirmed) {
+        settings_->setValue("memory_budget_mib", memory_budget_mib);
+        scheduler_->set_memory_budget(memory_budget_mib * MIB);
+    }
+}
+void MainWindow::update_thumbnail_cache_size_() {
+    TRACE
+    bool confirmed = false;
+    auto max_size_mib = QInputDialog::getInt(this, tr("thumbnail cache size"),
+                                             tr("enter max size of thumbnail cache in MiB"),
+                                             static_cast<int>(thumbnail_cache_->max_size() / MIB), 0,
+                                             std::numeric_limits<int>::max(), 16, &confirmed);
+    if (confirmed) {
+        settings_->setValue("thumbnail_cache/max_size_mib", max_size_mib);
+        thumbnail_cache_->set_max_size(max_size_mib * MIB);
+    }
+}
+void MainWindow::start_trial_() {
+    TRACE
+    if (not trial_encoder_.isNull()) {
+        return;
+    }
+    auto items = ui_->listWidget_files->selectedItems();
+    if (items.isEmpty()) {
+        for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+            items.push_back(ui_->listWidget_files->item(i));
+        }
+    }
+    if (items.isEmpty()) {
+        return;
+    }
+    // samples run as many at once as the batch does, so that their speed reflects the same contention
+    trial_encoder_ = new concat::TrialEncoder(scheduler_->max_concurrent_jobs(), this);
+    items_of_trials_.clear();
+    for (auto i = 0; i < items.size(); i++) {
+        items_of_trials_.insert(i, items[i]);
+        trial_encoder_->add(i, create_encode_job_(items[i]));
+    }
+    auto progress = new QProgressDialog(tr("encoding excerpts of %n file(s)", nullptr, static_cast<int>(items.size())),
+                                        tr("cancel"), 0, trial_encoder_->num_samples(), this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setAttribute(Qt::WA_DeleteOnClose, true);
+    progress->setMinimumDuration(0);
+    connect(trial_encoder_, &concat::TrialEncoder::progressed, progress, &QProgressDialog::setValue);
+    connect(trial_encoder_, &concat::TrialEncoder::finished, progress, &QProgressDialog::close);
+    connect(trial_encoder_, &concat::TrialEncoder::finished, this, &MainWindow::show_trial_results_);
+    connect(progress, &QProgressDialog::canceled, trial_encoder_, [this] {
+        trial_encoder_->cancel();
+        trial_encoder_->deleteLater();
+    });
+    trial_encoder_->start();
+}
+void MainWindow::show_trial_results_(concat::TrialResults results) {
+    TRACE
+    trial_encoder_->deleteLater();
+    auto format_time = [](std::chrono::milliseconds time) {
+        return QTime::fromMSecsSinceStartOfDay(static_cast<int>(time.count())).toString(tr("H'h'mm'm'ss's'"));
+    };
+    QStringList details;
+    QList<concat::EncodeJob> jobs;
+    qint64 total_size = 0;
+    int num_failed = 0;
+    for (auto it = results.cbegin(); it != results.cend(); ++it) {
+        auto item = items_of_trials_.value(it.key());
+        if (item == nullptr || ui_->listWidget_files->row(item) < 0) {
+            continue;  // removed during trial
+        }
+        if (not it->is_success) {
+            num_failed++;
+            details << tr("%1: failed").arg(item->text());
+            continue;
+        }
+        details << tr("%1: %2 MiB, %3 kbit/s, %4")
+                       .arg(item->text())
+                       .arg(static_cast<double>(it->size) / MIB, 0, 'f', 1)
+                       .arg(it->bitrate / 1000.0, 0, 'f', 0)
+                       .arg(format_time(it->duration));
+        auto job = create_encode_job_(item);
+        job.predicted_duration = it->duration;
+        jobs.push_back(job);
+        total_size += it->size;
+    }
+    items_of_trials_.clear();
+    QMessageBox message_box(QMessageBox::Information, tr("trial result"),
+                            tr("estimated output size: %1 MiB\nestimated time: %2")
+                                .arg(static_cast<double>(total_size) / MIB, 0, 'f', 1)
+                                .arg(format_time(concat::EncodeScheduler::estimate_makespan(
+                                    jobs, scheduler_->max_concurrent_jobs()))),
+                            QMessageBox::Ok, this);
+    if (num_failed > 0) {
+        message_box.setInformativeText(tr("trial of %n file(s) failed.", nullptr, num_failed));
+    }
+    message_box.setDetailedText(details.join('\n'));
+    message_box.exec();
+}
+void MainWindow::tune_concurrency_() {
+    TRACE
+    auto item = ui_->listWidget_files->currentItem();
+    if (item == nullptr || not concurrency_tuner_.isNull()) {
+        return;
+    }
+    auto job = create_encode_job_(item);
+    if (not job.extra_output_paths.isEmpty()) {
+        QMessageBox::warning(nullptr, tr("warning"), tr("concurrency can't be tuned with file having renditions"));
+        return;
+    }
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    output_video_info.resolve_reference();
+    auto plan = concat::plan_transcode(source_video_info, output_video_info, transcode_options_of_(item));
+    if (not plan.video_is_encoded) {
+        QMessageBox::warning(nullptr, tr("warning"), tr("video of current file is copied, which uses no threads"));
+        return;
+    }
+    concurrency_tuner_ = new concat::ConcurrencyTuner(this);
+    tuning_key_ = tuning_key_of_(item);
+    auto num_candidates = static_cast<int>(concat::tuning_candidates(QThread::idealThreadCount()).size());
+    auto progress = new QProgressDialog(tr("measuring concurrent jobs and threads with %1").arg(item->text()),
+                                        tr("cancel"), 0, num_candidates, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setAttribute(Qt::WA_DeleteOnClose, true);
+    progress->setMinimumDuration(0);
+    connect(concurrency_tuner_, &concat::ConcurrencyTuner::progressed, progress, &QProgressDialog::setValue);
+    connect(concurrency_tuner_, &concat::ConcurrencyTuner::finished, progress, &QProgressDialog::close);
+    connect(concurrency_tuner_, &concat::ConcurrencyTuner::finished, this, &MainWindow::register_tuning_results_);
+    connect(progress, &QProgressDialog::canceled, concurrency_tuner_, [this] {
+        concurrency_tuner_->cancel();
+        concurrency_tuner_->deleteLater();
+    });
+    concurrency_tuner_->tune(job, plan.video_codec, QThread::idealThreadCount());
+}
+void MainWindow::register_tuning_results_(QList<concat::TuningResult> results) {
+    TRACE
+    concurrency_tuner_->deleteLater();
+    QStringList details;
+    for (const auto &result : results) {
+        auto threads = result.config.threads > 0 ? QString::number(result.config.threads) : tr("default");
+        details << (result.is_success ? tr("%1 job(s) x %2 thread(s): %3 fps")
+                                            .arg(result.config.concurrent_jobs)
+                                            .arg(threads)
+                                            .arg(result.frames_per_second, 0, 'f', 1)
+                                      : tr("%1 job(s) x %2 thread(s): failed")
+                                            .arg(result.config.concurrent_jobs)
+                                            .arg(threads));
+    }
+    auto best = concat::ConcurrencyTuner::best(results);
+    if (not best.has_value()) {
+        QMessageBox message_box(QMessageBox::Warning, tr("tuning failed"), tr("every configuration failed"),
+                                QMessageBox::Ok, this);
+        message_box.setDetailedText(details.join('\n'));
+        message_box.exec();
+        return;
+    }
+    settings_->setValue(tuning_key_ + "/concurrent_jobs", best->config.concurrent_jobs);
+    settings_->setValue(tuning_key_ + "/threads", best->config.threads);
+    QMessageBox message_box(QMessageBox::Information, tr("tuning result"),
+                            tr("%1 job(s) x %2 thread(s) is used for %3 from now on.")
+                                .arg(best->config.concurrent_jobs)
+                                .arg(best->config.threads > 0 ? QString::number(best->config.threads) : tr("default"))
+                                .arg(tuning_key_.section('/', 1)),
+                            QMessageBox::Ok, this);
+    message_box.setDetailedText(details.join('\n'));
+    message_box.exec();
+}
+QString MainWindow::tuning_key_of_(QListWidgetItem *item) {
+    TRACE
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    output_video_info.resolve_reference();
+    QSize resolution;
+    if (auto output_resolution = std::get_if<QSize>(&output_video_info.resolution)) {
+        resolution = *output_resolution;
+    } else if (auto source_resolution = std::get_if<QSize>(&source_video_info.resolution)) {
+        resolution = *source_resolution;
+    }
+    return QStringLiteral("concurrency_tuning/%1/%2")
+        .arg(item->data(static_cast<int>(VideoDataRole::preset)).toString(), concat::resolution_class(resolution));
+}
+void MainWindow::apply_tuned_threads_(QListWidgetItem *item, concat::EncodeJob &job) {
+    TRACE
+    auto key = tuning_key_of_(item);
+    // thread options are put before the last output, so jobs writing renditions are run as they are
+    if (not settings_->contains(key + "/concurrent_jobs") || not job.extra_output_paths.isEmpty()) {
+        return;
+    }
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    output_video_info.resolve_reference();
+    auto plan = concat::plan_transcode(source_video_info, output_video_info, transcode_options_of_(item));
+    if (not plan.video_is_encoded) {
+        return;
+    }
+    job.arguments =
+        concat::thread_arguments(job.arguments, plan.video_codec, settings_->value(key + "/threads").toInt());
+    job.max_concurrent_jobs = settings_->value(key + "/concurrent_jobs").toInt();
+}
+void MainWindow::select_scaling_algorithm_() {
+    TRACE
+    auto algorithms = concat::TranscodeOptions::scaling_algorithms();
+    bool confirmed = false;
+    auto algorithm = QInputDialog::getItem(
+        this, tr("scaling algorithm"), tr("select algorithm used to change resolution. earlier ones are faster"),
+        algorithms, qMax(algorithms.indexOf(transcode_options_.scaling_algorithm), 0), false, &confirmed);
+    if (confirmed) {
+        settings_->setValue("scaling_algorithm", algorithm);
+        transcode_options_.scaling_algorithm = algorithm;
+    }
+}
+void MainWindow::concatenate_files_() {
+    TRACE
+    if (ui_->listWidget_files->count() == 0 || concat_.has_value()) {
+        return;
+    }
+    auto output_path =
+        QFileDialog::getSaveFileName(this, tr("concatenated file"), read_video_dir_cache_().toLocalFile());
+    if (output_path.isEmpty()) {
+        return;
+    }
+    if (QFile::exists(output_path)) {
+        QMessageBox::warning(
+            nullptr, tr("existing file"),
+            tr("file '%1' already exists. This software currently doesn't support overwriting file.").arg(output_path));
+        return;
+    }
+    QList<concat::ConcatInput> inputs;
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        auto item = ui_->listWidget_files->item(i);
+        inputs.push_back(
+            {item->text(), item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>(),
+             item->data(static_cast<int>(VideoDataRole::source_time_base)).toString(),
+             std::chrono::milliseconds(
+                 item->data(static_cast<int>(VideoDataRole::length)).toTime().msecsSinceStartOfDay()),
+             item->data(static_cast<int>(VideoDataRole::source_format)).value<concat::StreamFormat>()});
+    }
+    // normalized parts are written next to output, so that joining them doesn't cross file systems
+    auto work_dir =
+        std::make_unique<QTemporaryDir>(QFileInfo(output_path).dir().filePath(".video_re_encoder_concat-XXXXXX"));
+    if (not work_dir->isValid()) {
+        QMessageBox::warning(nullptr, tr("warning"),
+                             tr("failed to create temporary directory: %1").arg(work_dir->errorString()));
+        return;
+    }
+    auto plan = concat::plan_concat(inputs, QDir(work_dir->path()), QFileInfo(output_path).suffix(),
+                                    transcode_options_);
+    concat_ = ConcatState{std::move(work_dir), {}, plan.parts, output_path, plan.length, plan.output_arguments};
+    if (encode_process_.isNull()) {
+        create_encode_process_(true);
+    }
+    for (const auto &job : plan.normalizations) {
+        qDebug() << __FUNCTION__ << job.arguments;
+        concat_->normalization_ids.insert(scheduler_->enqueue(job));
+    }
+    if (plan.normalizations.isEmpty()) {
+        join_concat_parts_();
+    }
+}
+void MainWindow::join_concat_parts_() {
+    TRACE
+    auto list_path = QDir(concat_->work_dir->path()).filePath("parts.ffconcat");
+    if (not concat::write_concat_list(list_path, concat_->parts)) {
+        QMessageBox::warning(nullptr, tr("warning"), tr("failed to write list of files to concatenate"));
+        concat_.reset();
+        return;
+    }
+    auto job = concat::create_concat_job(list_path, concat_->output_path, concat_->length, concat_->output_arguments);
+    qDebug() << __FUNCTION__ << job.arguments;
+    concat_->join_id = scheduler_->enqueue(job);
+}
+void MainWindow::continue_concatenating_(int id, bool is_success) {
+    TRACE
+    if (not concat_.has_value()) {
+        return;
+    }
+    if (concat_->normalization_ids.remove(id)) {
+        concat_->has_failed = concat_->has_failed || not is_success;
+        if (not concat_->normalization_ids.isEmpty()) {
+            return;
+        }
+        if (concat_->has_failed) {
+            QMessageBox::warning(nullptr, tr("concatenation failed"),
+                                 tr("failed to convert some files to the common format."));
+            concat_.reset();
+            return;
+        }
+        join_concat_parts_();
+    } else if (id == concat_->join_id) {
+        if (not is_success) {
+            QMessageBox::warning(nullptr, tr("concatenation failed"), tr("failed to concatenate files."));
+        }
+        concat_.reset();  // parts and list are removed with work directory
+    }
+}
+void MainWindow::trim_current_file_() {
+    TRACE
+    auto item = ui_->listWidget_files->currentItem();
+    if (item == nullptr) {
+        return;
+    }
+    auto length = item->data(static_cast<int>(VideoDataRole::length)).toTime();
+    auto trim = trim_of_(item);
+    auto to_time = [](std::chrono::milliseconds time) {
+        return QTime::fromMSecsSinceStartOfDay(static_cast<int>(time.count()));
+    };
+    bool confirmed = false;
+    auto start = TimeDialog::get_position(this, tr("trim"), tr("enter start of range to keep"),
+                                          trim.has_value() ? to_time(trim->start) : QTime(0, 0), length, &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    auto end = TimeDialog::get_position(this, tr("trim"), tr("enter end of range to keep"),
+                                        trim.has_value() ? to_time(trim->end) : length, length, &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    if (end <= start) {
+        QMessageBox::warning(nullptr, tr("invalid range"), tr("end of range must be after its start"));
+        return;
+    }
+    auto is_whole = start == QTime(0, 0) && end == length;
+    item->setData(static_cast<int>(VideoDataRole::trim_start), is_whole ? QVariant() : QVariant(start));
+    item->setData(static_cast<int>(VideoDataRole::trim_end), is_whole ? QVariant() : QVariant(end));
+    auto format = QStringLiteral("HH:mm:ss.zzz");
+    item->setToolTip(is_whole ? QString() : tr("trimmed to %1 - %2").arg(start.toString(format), end.toString(format)));
+    update_batch_estimate_();
+}
+void MainWindow::add_rendition_() {
+    TRACE
+    auto item = ui_->listWidget_files->currentItem();
+    if (item == nullptr) {
+        return;
+    }
+    QStringList preset_names;
+    for (const auto &[key, value] : presets_.as_table()) {
+        if (key != "VERSION") {
+            preset_names.push_back(QString::fromStdString(key));
+        }
+    }
+    if (preset_names.isEmpty()) {
+        QMessageBox::warning(nullptr, tr("warning"), tr("rendition requires a preset to encode with"));
+        return;
+    }
+    bool confirmed = false;
+    auto preset = QInputDialog::getItem(
+        this, tr("rendition"),
+        tr("select preset of another output, which is written from the same decode as the current output"),
+        preset_names, 0, false, &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    auto presets = item->data(static_cast<int>(VideoDataRole::renditions)).toStringList();
+    if (presets.contains(preset)) {
+        return;
+    }
+    presets << preset;
+    item->setData(static_cast<int>(VideoDataRole::renditions), presets);
+    item->setToolTip(tr("renditions: %1").arg(presets.join(", ")));
+    update_batch_estimate_();
+}
+void MainWindow::clear_renditions_() {
+    TRACE
+    auto item = ui_->listWidget_files->currentItem();
+    if (item == nullptr) {
+        return;
+    }
+    item->setData(static_cast<int>(VideoDataRole::renditions), QVariant());
+    item->setToolTip(QString());
+    update_batch_estimate_();
+}
+void MainWindow::detect_black_bars_() {
+    TRACE
+    auto items = ui_->listWidget_files->selectedItems();
+    if (items.isEmpty()) {
+        for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+            items.push_back(ui_->listWidget_files->item(i));
+        }
+    }
+    for (auto item : items) {
+        auto source_video_info =
+            item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+        auto source_resolution = std::get_if<QSize>(&source_video_info.resolution);
+        auto length = item->data(static_cast<int>(VideoDataRole::length)).toTime();
+        if (source_resolution == nullptr || not length.isValid()) {
+            continue;
+        }
+        // item may be removed while detecting, so that it is looked up again by its path
+        auto input_path = item->text();
+        concat::detect_crop(
+            process_runner_, input_path, std::chrono::milliseconds(length.msecsSinceStartOfDay()), *source_resolution,
+            [this, input_path](std::optional<QRect> crop) {
+                qDebug() << input_path << "crop:" << crop.value_or(QRect());
+                if (not crop.has_value()) {
+                    return;
+                }
+                for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+                    auto item = ui_->listWidget_files->item(i);
+                    if (item->text() != input_path) {
+                        continue;
+                    }
+                    item->setData(static_cast<int>(VideoDataRole::crop), crop.value());
+                    item->setData(static_cast<int>(VideoDataRole::crop_is_applied), true);
+                    if (item == ui_->listWidget_files->currentItem()) {
+                        ui_->videoInfoWidget->set_crop(crop, true);
+                    }
+                }
+                update_batch_estimate_();
+            },
+            OPENING_PRIORITY);
+    }
+}
+concat::TranscodeOptions MainWindow::transcode_options_of_(QListWidgetItem *item) {
+    TRACE
+    auto result = transcode_options_;
+    auto crop = item->data(static_cast<int>(VideoDataRole::crop)).toRect();
+    if (crop.isValid() && item->data(static_cast<int>(VideoDataRole::crop_is_applied)).toBool()) {
+        result.crop = crop;
+    }
+    return result;
+}
+QList<concat::Rendition> MainWindow::renditions_of_(QListWidgetItem *item) {
+    TRACE
+    QList<concat::Rendition> result;
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    QFileInfo output(item->data(static_cast<int>(VideoDataRole::output_path)).toUrl().toLocalFile());
+    for (const auto &preset : item->data(static_cast<int>(VideoDataRole::renditions)).toStringList()) {
+        if (presets_.as_table().count(preset.toStdString()) == 0) {
+            qWarning() << "preset of rendition" << preset << "no longer exists";
+            continue;
+        }
+        auto output_info =
+            concat::VideoInfo::from_toml(presets_["VERSION"].as_integer(), presets_[preset.toStdString()]);
+        output_info.bound_input_info(retrieve_input_info(source_video_info));
+        output_info.resolve_reference();
+        auto output_path =
+            output.dir().filePath(QStringLiteral("%1_%2.%3").arg(output.completeBaseName(), preset, output.suffix()));
+        result.push_back({output_info, output_path});
+    }
+    return result;
+}
+void MainWindow::report_renditions_(int id, bool is_success) {
+    TRACE
+    if (not stderr_of_renditions_.contains(id)) {
+        return;
+    }
+    auto stderr_text = stderr_of_renditions_.take(id);
+    if (is_success || scheduler_->state(id) == concat::EncodeScheduler::JobState::canceled) {
+        return;
+    }
+    const auto &job = scheduler_->job(id);
+    auto output_paths = QStringList{job.output_path} + job.extra_output_paths;
+    auto errors = concat::parse_output_errors(stderr_text, output_paths);
+    QStringList report;
+    for (auto i = 0; i < output_paths.size(); i++) {
+        // ffmpeg stops every output when one of them fails
+        report << QStringLiteral("%1: %2").arg(output_paths[i], errors.value(i, tr("stopped with the others")));
+    }
+    if (not encode_process_.isNull()) {
+        encode_process_->append_job_output(id, QString(), QStringLiteral("\n%1\n").arg(report.join('\n')));
+    }
+    QMessageBox::warning(nullptr, tr("renditions failed"),
+                         tr("failed to write renditions of %1.\n%2").arg(job.input_path, report.join('\n')));
+}
+std::optional<concat::Trim> MainWindow::trim_of_(QListWidgetItem *item) {
+    TRACE
+    auto start = item->data(static_cast<int>(VideoDataRole::trim_start)).toTime();
+    auto end = item->data(static_cast<int>(VideoDataRole::trim_end)).toTime();
+    if (not start.isValid() || not end.isValid()) {
+        return std::nullopt;
+    }
+    return concat::Trim{std::chrono::milliseconds(start.msecsSinceStartOfDay()),
+                        std::chrono::milliseconds(end.msecsSinceStartOfDay())};
+}
+bool MainWindow::is_smart_trimmed_(QListWidgetItem *item) {
+    TRACE
+    // renditions are cut accurately together with output by create_encode_job_()
+    if (not trim_of_(item).has_value() || not renditions_of_(item).isEmpty()) {
+        return false;
+    }
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    output_video_info.resolve_reference();
+    // encoded video is cut accurately by create_encode_job_() anyway
+    return not concat::plan_transcode(source_video_info, output_video_info, transcode_options_of_(item))
+                   .video_is_encoded;
+}
+void MainWindow::start_trimming_(QListWidgetItem *item) {
+    TRACE
+    auto key = start_staging_(item);
+    process_runner_->run(
+        "ffprobe", concat::keyframe_probe_arguments(item->text(), trim_of_(item).value()),
+        [this, key](const concat::ProcessResult &result) { plan_trimming_(key, result); }, OPENING_PRIORITY);
+}
+void MainWindow::plan_trimming_(int key, const concat::ProcessResult &result) {
+    TRACE
+    auto state = staged_jobs_.find(key);
+    if (state == staged_jobs_.end()) {
+        return;
+    }
+    auto item = state->second.item;
+    if (ui_->listWidget_files->row(item) < 0) {
+        staged_jobs_.erase(state);  // removed while probing. item is deleted, and there is nothing to report
+        return;
+    }
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    auto probe = result.is_success ? concat::parse_keyframe_probe(result.stdout_text) : std::nullopt;
+    if (not probe.has_value()) {
+        // without keyframes, the whole range is re-encoded with codec of source
+        qWarning() << "failed to probe keyframes of" << item->text() << result.stderr_text << result.error;
+        probe = concat::KeyframeProbe();
+        if (auto codec = std::get_if<QString>(&source_video_info.video_codec)) {
+            probe->codec = *codec;
+        }
+    }
+    auto output_path = item->data(static_cast<int>(VideoDataRole::output_path)).toUrl().toLocalFile();
+    // segments are written next to output, so that joining them doesn't cross file systems
+    auto work_dir =
+        std::make_unique<QTemporaryDir>(QFileInfo(output_path).dir().filePath(".video_re_encoder_trim-XXXXXX"));
+    auto list_path = QDir(work_dir->path()).filePath("segments.ffconcat");
+    auto trim = trim_of_(item).value();
+    std::optional<concat::TrimPlan> plan;
+    if (work_dir->isValid()) {
+        plan = concat::plan_trim(item->text(), source_video_info, probe.value(), trim, QDir(work_dir->path()));
+    }
+    if (not plan.has_value() || not concat::write_concat_list(list_path, plan->parts)) {
+        // item is trimmed by a single job instead, whose cuts are at keyframes
+        qWarning() << "failed to prepare segments of" << item->text() << "in" << work_dir->path();
+        ui_->statusbar->showMessage(
+            tr("failed to prepare segments of %1. it is trimmed at keyframes").arg(item->text()));
+        staged_jobs_.erase(state);
+        auto job = create_encode_job_(item);
+        apply_tuned_threads_(item, job);
+        enqueue_item_job_(item, job);
+        return;
+    }
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    output_video_info.resolve_reference();
+    auto transcode = concat::plan_transcode(source_video_info, output_video_info, transcode_options_of_(item));
+    auto priority = item->data(static_cast<int>(VideoDataRole::priority)).toInt();
+    auto &staged = state->second;
+    staged.work_dir = std::move(work_dir);
+    staged.finish = concat::create_trim_join_job(list_path, item->text(), trim, probe.value(), transcode,
+                                                 output_video_info, output_path);
+    staged.finish.priority = priority;
+    staged.failure_message = tr("failed to write segments of %1").arg(item->text());
+    if (encode_process_.isNull()) {
+        create_encode_process_(false);
+    }
+    for (auto &job : plan->segments) {
+        job.priority = priority;
+    }
+    enqueue_staged_parts_(key, plan->segments);
+}
+int MainWindow::start_staging_(QListWidgetItem *item) {
+    TRACE
+    auto key = next_staged_jobs_id_++;
+    staged_jobs_[key].item = item;
+    set_job_id_(item, PREPARING_JOB_ID);
+    return key;
+}
+void MainWindow::enqueue_staged_parts_(int key, const QList<concat::EncodeJob> &parts) {
+    TRACE
+    for (const auto &part : parts) {
+        qDebug() << __FUNCTION__ << part.arguments;
+        auto id = scheduler_->enqueue(part);
+        staged_jobs_[key].part_ids.insert(id);
+        staged_jobs_of_jobs_.insert(id, key);
+    }
+}
+void MainWindow::continue_staging_(int id, bool is_success) {
+    TRACE
+    if (not staged_jobs_of_jobs_.contains(id)) {
+        return;
+    }
+    auto state = staged_jobs_.find(staged_jobs_of_jobs_.take(id));
+    if (state == staged_jobs_.end()) {
+        return;
+    }
+    auto &staged = state->second;
+    if (not staged.part_ids.remove(id)) {
+        staged_jobs_.erase(state);  // finished. parts are removed with work directory
+        return;
+    }
+    if (not is_success && not staged.has_failed) {
+        staged.has_failed = true;
+        // item is reported as failed by the failed part, as it would be by its own job
+        if (ui_->listWidget_files->row(staged.item) >= 0) {
+            set_job_id_(staged.item, id);
+        }
+        if (not encode_process_.isNull()) {
+            encode_process_->append_job_output(id, QString(), QStringLiteral("\n%1\n").arg(staged.failure_message));
+        }
+        // the other parts are of no use without this one. canceled ones come back here, which erases the state
+        if (not staged.part_ids.isEmpty()) {
+            for (auto part_id : QSet<int>(staged.part_ids)) {
+                scheduler_->cancel(part_id);
+            }
+            return;
+        }
+    }
+    if (not staged.part_ids.isEmpty()) {
+        return;
+    }
+    if (staged.has_failed || ui_->listWidget_files->row(staged.item) < 0) {
+        staged_jobs_.erase(state);
+        return;
+    }
+    qDebug() << __FUNCTION__ << staged.finish.arguments;
+    auto finish_id = scheduler_->enqueue(staged.finish);
+    set_job_id_(staged.item, finish_id);
+    staged_jobs_of_jobs_.insert(finish_id, state->first);
+}
+bool MainWindow::is_split_(QListWidgetItem *item) {
+    TRACE
+    // trimmed outputs and renditions are planned with options of their own, which split jobs don't take
+    if (not ui_->actionsplit_audio_video->isChecked() || trim_of_(item).has_value() ||
+        not renditions_of_(item).isEmpty()) {
+        return false;
+    }
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    output_video_info.resolve_reference();
+    return concat::is_worth_splitting(
+        source_video_info, concat::plan_transcode(source_video_info, output_video_info, transcode_options_of_(item)));
+}
+void MainWindow::start_splitting_(QListWidgetItem *item, const concat::EncodeJob &job) {
+    TRACE
+    // scratch files are written next to output, so that muxing them doesn't cross file systems
+    auto work_dir =
+        std::make_unique<QTemporaryDir>(QFileInfo(job.output_path).dir().filePath(".video_re_encoder_split-XXXXXX"));
+    if (not work_dir->isValid()) {
+        // both streams are encoded by a single job instead
+        qWarning() << "failed to prepare scratch directory of" << item->text() << "in" << work_dir->path();
+        auto single_job = job;
+        apply_tuned_threads_(item, single_job);
+        enqueue_item_job_(item, single_job);
+        return;
+    }
+    auto output_video_info = item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto source_video_info = item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    output_video_info.resolve_reference();
+    auto options = transcode_options_of_(item);
+    auto transcode = concat::plan_transcode(source_video_info, output_video_info, options);
+    auto plan = concat::plan_split_encode(job, source_video_info, output_video_info, transcode, options,
+                                          QDir(work_dir->path()));
+    if (transcode.video_is_encoded) {
+        apply_tuned_threads_(item, plan.streams.first());
+    }
+    auto key = start_staging_(item);
+    auto &staged = staged_jobs_[key];
+    staged.work_dir = std::move(work_dir);
+    staged.finish = plan.mux;
+    staged.failure_message = tr("failed to write streams of %1").arg(item->text());
+    enqueue_staged_parts_(key, plan.streams);
+}
+void MainWindow::toggle_splitting_encodes_(bool enabled) {
+    TRACE
+    settings_->setValue("split_encode/enabled", enabled);
+}
+void MainWindow::toggle_serving_status_(bool enabled) {
+    TRACE
+    settings_->setValue("status_server/enabled", enabled);
+    if (not enabled) {
+        status_server_->close();
+        ui_->actionserve_status->setToolTip(QString());
+        return;
+    }
+    if (not status_server_->listen(concat::StatusServer::default_name())) {
+        QMessageBox::warning(nullptr, tr("status server"),
+                             tr("failed to listen on local socket.\n%1").arg(status_server_->error_string()));
+        QSignalBlocker blocker(ui_->actionserve_status);
+        ui_->actionserve_status->setChecked(false);
+        return;
+    }
+    qInfo() << "status is served on" << status_server_->full_server_name();
+    ui_->actionserve_status->setToolTip(status_server_->full_server_name());
+}
+void MainWindow::toggle_checking_quality_(bool enabled) {
+    TRACE
+    settings_->setValue("quality_check/enabled", enabled);
+}
+void MainWindow::update_quality_thresholds_() {
+    TRACE
+    bool confirmed = false;
+    auto min_psnr = QInputDialog::getDouble(this, tr("quality thresholds"), tr("enter minimum PSNR in dB"),
+                                            quality_thresholds_.min_psnr, 0.0, 100.0, 1, &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    auto min_ssim = QInputDialog::getDouble(this, tr("quality thresholds"), tr("enter minimum SSIM"),
+                                            quality_thresholds_.min_ssim, 0.0, 1.0, 3, &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    auto min_vmaf = QInputDialog::getDouble(this, tr("quality thresholds"),
+                                            tr("enter minimum VMAF. this is used only if ffmpeg supports libvmaf"),
+                                            quality_thresholds_.min_vmaf, 0.0, 100.0, 1, &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    quality_thresholds_ = {min_psnr, min_ssim, min_vmaf};
+    settings_->setValue("quality_check/min_psnr", min_psnr);
+    settings_->setValue("quality_check/min_ssim", min_ssim);
+    settings_->setValue("quality_check/min_vmaf", min_vmaf);
+}
+void MainWindow::update_output_infos_() {
+    TRACE
+    auto new_item = ui_->listWidget_files->currentItem();
+    if (new_item == nullptr) {
+        qDebug() << "new_item is nullptr";
+        return;
+    }
+    ui_->videoInfoWidget->set_infos(
+        new_item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>(),
+        retrieve_input_info(
+            new_item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>()));
+    change_preset_(new_item->data(static_cast<int>(VideoDataRole::preset)).toString());
+    auto crop = new_item->data(static_cast<int>(VideoDataRole::crop)).toRect();
+    ui_->videoInfoWidget->set_crop(crop.isValid() ? std::make_optional(crop) : std::nullopt,
+                                   new_item->data(static_cast<int>(VideoDataRole::crop_is_applied)).toBool());
+    auto output_path = new_item->data(static_cast<int>(VideoDataRole::output_path)).toUrl();
+    auto output_dir = QDir{output_path.toLocalFile()};
+    output_dir.cdUp();
+    ui_->lineEdit_output_dir->setText(output_dir.absolutePath());
+    ui_->lineEdit_output_filename->setText(QFileInfo{output_path.toLocalFile()}.fileName());
+    ui_->timeEdit_item_length->setTime(new_item->data(static_cast<int>(VideoDataRole::length)).toTime());
+    ui_->spinBox_priority->setValue(new_item->data(static_cast<int>(VideoDataRole::priority)).toInt());
+    update_total_length_();
+}
+void MainWindow::update_total_length_() {
+    TRACE
+    int total_length = 0;
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        total_length += ui_->listWidget_files->item(i)
+                            ->data(static_cast<int>(VideoDataRole::length))
+                            .toTime()
+                            .msecsSinceStartOfDay();
+    }
+    ui_->timeEdit->setTime(QTime::fromMSecsSinceStartOfDay(total_length));
+    update_batch_estimate_();
+}
+void MainWindow::request_visible_thumbnails_() {
+    TRACE
+    auto viewport = ui_->listWidget_files->viewport()->rect();
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        auto item = ui_->listWidget_files->item(i);
+        auto length = item->data(static_cast<int>(VideoDataRole::length));
+        // length is known after probing, so thumbnails don't compete with import
+        if (item->data(static_cast<int>(VideoDataRole::thumbnail_requested)).toBool() || not length.isValid() ||
+            not ui_->listWidget_files->visualItemRect(item).intersects(viewport)) {
+            continue;
+        }
+        item->setData(static_cast<int>(VideoDataRole::thumbnail_requested), true);
+        thumbnail_cache_->request(item->text(), std::chrono::milliseconds(length.toTime().msecsSinceStartOfDay()));
+    }
+}
+void MainWindow::show_thumbnail_(QString path, QImage image) {
+    TRACE
+    auto icon = QIcon(QPixmap::fromImage(image));
+    for (auto item : ui_->listWidget_files->findItems(path, Qt::MatchExactly)) {
+        item->setIcon(icon);
+    }
+}
+void MainWindow::update_batch_estimate_() {
+    TRACE
+    if (scheduler_ == nullptr) {
+        return;
+    }
+    QList<concat::EncodeJob> jobs;
+    jobs.reserve(ui_->listWidget_files->count());
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        auto item = ui_->listWidget_files->item(i);
+        auto estimate = item_estimates_.find(item);
+        if (estimate == item_estimates_.end()) {
+            estimate = item_estimates_.insert(item, estimate_item_(item));
+            num_estimates_without_samples_ += estimate->num_samples == 0 ? 1 : 0;
+        }
+        jobs.push_back(estimate->job);
+    }
+    if (jobs.isEmpty()) {
+        ui_->label_estimate->clear();
+        return;
+    }
+    auto makespan = concat::EncodeScheduler::estimate_makespan(jobs, scheduler_->current_max_concurrent_jobs());
+    auto text = tr("estimated time: %1")
+                    .arg(QTime::fromMSecsSinceStartOfDay(static_cast<int>(makespan.count()))
+                             .toString(tr("H'h'mm'm'ss's'")));
+    if (num_estimates_without_samples_ > 0) {
+        text += tr(" (rough, no previous encodes with same settings)");
+    }
+    ui_->label_estimate->setText(text);
+}
+MainWindow::ItemEstimate MainWindow::estimate_item_(QListWidgetItem *item) {
+    TRACE
+    auto job = create_encode_job_(item);
+    ItemEstimate result;
+    result.key = speed_history_key_(item);
+    result.job.length = job.length;
+    result.job.cost = job.cost;
+    result.job.priority = job.priority;
+    auto prediction = speed_history_.predict(result.key, job.length, job.cost);
+    result.job.predicted_duration = prediction.duration;
+    result.num_samples = prediction.num_samples;
+    return result;
+}
+void MainWindow::invalidate_estimates_(int first_row, int last_row) {
+    TRACE
+    for (auto row = first_row; row <= last_row; row++) {
+        auto estimate = item_estimates_.find(ui_->listWidget_files->item(row));
+        if (estimate == item_estimates_.end()) {
+            continue;
+        }
+        num_estimates_without_samples_ -= estimate->num_samples == 0 ? 1 : 0;
+        item_estimates_.erase(estimate);
+    }
+}
+void MainWindow::repredict_estimates_() {
+    TRACE
+    num_estimates_without_samples_ = 0;
+    for (auto &estimate : item_estimates_) {
+        auto prediction = speed_history_.predict(estimate.key, estimate.job.length, estimate.job.cost);
+        estimate.job.predicted_duration = prediction.duration;
+        estimate.num_samples = prediction.num_samples;
+        num_estimates_without_samples_ += estimate.num_samples == 0 ? 1 : 0;
+    }
+}
+void MainWindow::register_output_path_() {
+    TRACE
+    auto path =
+        QUrl::fromLocalFile(QDir{ui_->lineEdit_output_dir->text()}.filePath(ui_->lineEdit_output_filename->text()));
+    auto current_item = ui_->listWidget_files->currentItem();
+    if (current_item == nullptr) {
+        return;
+    }
+    current_item->setData(static_cast<int>(VideoDataRole::output_path), path);
+}
+void MainWindow::save_result_() {
+    TRACE
+    start_saving_();
+}
+
+int MainWindow::savefile_name_plugin_index_() {
+    TRACE
+    int result = 0;
+    if (settings_->contains("savefile_name_plugin")) {
+        int raw_idx = savefile_name_plugins_().indexOf(settings_->value("savefile_name_plugin"));
+        result = qMax(raw_idx, 0);
+    }
+
+    return result;
+}
+QDir MainWindow::savefile_name_plugins_dir_() {
+    TRACE
+    return QDir(QApplication::applicationDirPath() + "/plugins/savefile_name");
+}
+QStringList MainWindow::search_savefile_name_plugins_() {
+    TRACE
+    return savefile_name_plugins_dir_().entryList({"*.py"}, QDir::Files);
+}
+
+QStringList MainWindow::savefile_name_plugins_() {
+    TRACE
+    return QStringList{NO_PLUGIN} + search_savefile_name_plugins_();
+}
+
+void MainWindow::select_savefile_name_plugin_() {
+    TRACE
+    QString plugin = NO_PLUGIN;
+    bool confirmed;
+    plugin = QInputDialog::getItem(this, tr("select plugin"), tr("Select savefile name plugin."),
+                                   savefile_name_plugins_(), savefile_name_plugin_index_(), false, &confirmed);
+    if (confirmed && settings_ != nullptr) {
+        settings_->setValue("savefile_name_plugin", plugin);
+    }
+}
+
+void MainWindow::select_default_preset_() {
+    TRACE
+    QStringList presets(tr("custom"));
+    for (const auto &[key, value] : presets_.as_table()) {
+        if (key == "VERSION") {
+            continue;
+        }
+        presets << QString::fromStdString(key);
+    }
+    bool confirmed = false;
+    auto default_preset = QInputDialog::getItem(nullptr, tr("default preset"), tr("select default preset"), presets, 0,
+                                                false, &confirmed);
+    if (confirmed) {
+        if (default_preset == tr("custom")) {
+            default_preset = "custom";
+        }
+        settings_->setValue("default_preset", default_preset);
+    }
+}
+
+void MainWindow::change_preset_(QString name) {
+    TRACE
+    if (ui_->listWidget_files->count() == 0) {
+        return;
+    }
+    auto current_item = ui_->listWidget_files->currentItem();
+    if (current_item == nullptr) {
+        return;
+    }
+    auto source_video_info =
+        current_item->data(static_cast<int>(VideoDataRole::source_video_info)).value<concat::VideoInfo>();
+    auto current_output_info =
+        current_item->data(static_cast<int>(VideoDataRole::output_video_info)).value<concat::VideoInfo>();
+    auto current_preset = current_item->data(static_cast<int>(VideoDataRole::preset)).toString();
+    if (name == tr("custom")) {
+        ui_->videoInfoWidget->set_editable(true);
+        ui_->videoInfoWidget->set_infos(current_output_info, retrieve_input_info(source_video_info));
+    } else {
+        ui_->videoInfoWidget->set_editable(false);
+        if (current_preset == tr("custom")) {
+            current_item->setData(static_cast<int>(VideoDataRole::output_video_info),
+                                  QVariant::fromValue(ui_->videoInfoWidget->info()));
+        }
+        try {
+            auto preset_info =
+                concat::VideoInfo::from_toml(presets_["VERSION"].as_integer(), presets_[name.toStdString()]);
+            ui_->videoInfoWidget->set_infos(preset_info, retrieve_input_info(source_video_info));
+            auto problems = ffmpeg_capabilities_.validate(preset_info);
+            if (not problems.isEmpty()) {
+                QMessageBox::warning(nullptr, tr("unsupported settings"),
+                                     tr("installed ffmpeg doesn't support following settings of preset '%1'.\n%2")
+                                         .arg(name)
+                                         .arg(problems.join('\n')));
+            }
+        } catch (std::exception &e) {
+            QMessageBox::warning(nullptr, tr("warning"),
+                                 tr("failed to load preset '%1' info: \n%2").arg(name).arg(e.what()));
+        }
+    }
+    current_item->setData(static_cast<int>(VideoDataRole::preset), name);
+    update_batch_estimate_();
+}
+void MainWindow::validate_presets_() {
+    TRACE
+    for (auto &[key, value] : presets_.as_table()) {
+        if (key == "VERSION") {
+            continue;
+        }
+        try {
+            auto problems =
+                ffmpeg_capabilities_.validate(concat::VideoInfo::from_toml(presets_["VERSION"].as_integer(), value));
+            for (const auto &problem : problems) {
+                qWarning() << tr("preset '%1': %2").arg(QString::fromStdString(key)).arg(problem);
+            }
+        } catch (std::exception &e) {
+            qWarning() << tr("failed to load preset '%1' info: \n%2").arg(QString::fromStdString(key)).arg(e.what());
+        }
+    }
+}
+void MainWindow::register_user_video_info_(concat::VideoInfo new_value) {
+    TRACE
+    auto current_item = ui_->listWidget_files->currentItem();
+    if (current_item == nullptr) {
+        return;
+    }
+    current_item->setData(static_cast<int>(VideoDataRole::output_video_info), QVariant::fromValue(new_value));
+    update_batch_estimate_();
+}
+void MainWindow::register_user_priority_(int new_value) {
+    TRACE
+    auto current_item = ui_->listWidget_files->currentItem();
+    if (current_item == nullptr) {
+        return;
+    }
+    current_item->setData(static_cast<int>(VideoDataRole::priority), new_value);
+    auto job_id = current_item->data(static_cast<int>(VideoDataRole::job_id));
+    if (job_id.isValid()) {
+        scheduler_->set_priority(job_id.toInt(), new_value);
+        if (not encode_process_.isNull()) {
+            encode_process_->set_job_priority(job_id.toInt(), new_value);
+        }
+    }
+    update_batch_estimate_();
+}
+void MainWindow::register_user_crop_(bool is_applied) {
+    TRACE
+    auto current_item = ui_->listWidget_files->currentItem();
+    if (current_item == nullptr) {
+        return;
+    }
+    current_item->setData(static_cast<int>(VideoDataRole::crop_is_applied), is_applied);
+    update_batch_estimate_();
+}
+void MainWindow::register_user_output_path_() {
+    TRACE
+    auto new_value =
+        QUrl::fromLocalFile(QDir{ui_->lineEdit_output_dir->text()}.filePath(ui_->lineEdit_output_filename->text()));
+    auto current_item = ui_->listWidget_files->currentItem();
+    if (current_item == nullptr) {
+        return;
+    }
+    current_item->setData(static_cast<int>(VideoDataRole::output_path), new_value);
+}
+void MainWindow::sort_files_() {
+    TRACE
+    QVector<QPair<concat::EncodeJob, QListWidgetItem *>> items;
+    while (ui_->listWidget_files->count() != 0) {
+        auto item = ui_->listWidget_files->takeItem(0);
+        items.push_back({create_encode_job_(item), item});
+    }
+    std::stable_sort(items.begin(), items.end(), [](const auto &one, const auto &the_other) {
+        return concat::EncodeScheduler::is_started_before(one.first, the_other.first);
+    });
+    for (const auto &[job, item] : items) {
         ui_->listWidget_files->addItem(item);
     }
     ui_->listWidget_files->setCurrentRow(0);
-}
\ No newline at end of file
+}
+QList<concat::FolderWatcher::Folder> MainWindow::watch_folders_() {
+    TRACE
+    QList<concat::FolderWatcher::Folder> result;
+    auto size = settings_->beginReadArray("watch_folders");
+    for (auto i = 0; i < size; i++) {
+        settings_->setArrayIndex(i);
+        result.push_back({settings_->value("path").toString(), settings_->value("preset").toString(),
+                          settings_->value("name_filters").toStringList()});
+    }
+    settings_->endArray();
+    return result;
+}
+void MainWindow::add_watch_folder_() {
+    TRACE
+    auto dir = QFileDialog::getExistingDirectory(this, tr("watch folder"), read_video_dir_cache_().toLocalFile());
+    if (dir.isEmpty()) {
+        return;
+    }
+    QStringList presets(tr("custom"));
+    for (const auto &[key, value] : presets_.as_table()) {
+        if (key == "VERSION") {
+            continue;
+        }
+        presets << QString::fromStdString(key);
+    }
+    bool confirmed = false;
+    auto preset = QInputDialog::getItem(this, tr("watch folder"), tr("select preset applied to files in %1").arg(dir),
+                                        presets, 0, false, &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    if (preset == tr("custom")) {
+        preset = "custom";
+    }
+    auto name_filters = QInputDialog::getText(this, tr("watch folder"), tr("enter space separated file name filters"),
+                                              QLineEdit::Normal, "*.mp4 *.mkv *.mov", &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    auto folders = watch_folders_();
+    folders.push_back({dir, preset, name_filters.split(' ', Qt::SkipEmptyParts)});
+    settings_->beginWriteArray("watch_folders", folders.size());
+    for (auto i = 0; i < folders.size(); i++) {
+        settings_->setArrayIndex(i);
+        settings_->setValue("path", folders[i].path);
+        settings_->setValue("preset", folders[i].preset);
+        settings_->setValue("name_filters", folders[i].name_filters);
+    }
+    settings_->endArray();
+    if (folder_watcher_ != nullptr && ui_->actionwatch_folders->isChecked()) {
+        folder_watcher_->add_folder(folders.back());
+    }
+}
+void MainWindow::clear_watch_folders_() {
+    TRACE
+    settings_->remove("watch_folders");
+    if (folder_watcher_ != nullptr) {
+        folder_watcher_->clear();
+    }
+}
+void MainWindow::update_max_queued_jobs_of_watch_folders_() {
+    TRACE
+    bool confirmed = false;
+    auto max_queued_jobs = QInputDialog::getInt(
+        this, tr("max queued jobs"), tr("files are left in watch folders while this many jobs are waiting"),
+        settings_->value("watch_folder/max_queued_jobs", DEFAULT_MAX_QUEUED_JOBS_OF_WATCH_FOLDERS).toInt(), 1, 1000, 1,
+        &confirmed);
+    if (confirmed) {
+        settings_->setValue("watch_folder/max_queued_jobs", max_queued_jobs);
+        update_watch_back_pressure_();
+    }
+}
+void MainWindow::scan_library_() {
+    TRACE
+    if (library_scanner_->is_scanning()) {
+        return;
+    }
+    auto dir = QFileDialog::getExistingDirectory(this, tr("library to scan"), read_video_dir_cache_().toLocalFile());
+    if (dir.isEmpty()) {
+        return;
+    }
+    QStringList preset_names;
+    for (const auto &[key, value] : presets_.as_table()) {
+        if (key != "VERSION") {
+            preset_names.push_back(QString::fromStdString(key));
+        }
+    }
+    if (preset_names.isEmpty()) {
+        QMessageBox::warning(nullptr, tr("warning"), tr("library scan requires a preset to compare files with"));
+        return;
+    }
+    bool confirmed = false;
+    auto preset = QInputDialog::getItem(
+        this, tr("target preset"), tr("files which don't satisfy this preset are added"), preset_names,
+        qMax(0, preset_names.indexOf(settings_->value("default_preset").toString())), false, &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    auto name_filters = QInputDialog::getText(
+        this, tr("name filters"), tr("space separated wildcards of names of video files"), QLineEdit::Normal,
+        settings_->value("library_scan/name_filters", "*.mp4 *.mkv *.mov").toString(), &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    settings_->setValue("library_scan/name_filters", name_filters);
+    try {
+        library_scan_output_info_ =
+            concat::VideoInfo::from_toml(presets_["VERSION"].as_integer(), presets_[preset.toStdString()]);
+    } catch (std::exception &e) {
+        QMessageBox::warning(nullptr, tr("warning"),
+                             tr("failed to load preset '%1' info: \n%2").arg(preset).arg(e.what()));
+        return;
+    }
+    library_scan_preset_ = preset;
+    library_scan_known_inputs_.clear();
+    for (auto i = 0; i < ui_->listWidget_files->count(); i++) {
+        library_scan_known_inputs_.insert(ui_->listWidget_files->item(i)->text());
+    }
+    for (const auto &input_path : current_unregistered_input_paths_) {
+        library_scan_known_inputs_.insert(input_path.toLocalFile());
+    }
+    library_scan_resolution_is_maximum_ =
+        QMessageBox::question(this, tr("resolution"),
+                              tr("do files with lower resolution than the preset satisfy it?")) == QMessageBox::Yes;
+    auto progress = new QProgressDialog(tr("scanning %1").arg(dir), tr("cancel"), 0, 0, this);
+    progress->setAttribute(Qt::WA_DeleteOnClose, true);
+    progress->setMinimumDuration(0);
+    connect(library_scanner_, &concat::LibraryScanner::progressed, progress, [progress](int scanned, int found) {
+        progress->setMaximum(found);
+        progress->setValue(scanned);
+    });
+    connect(library_scanner_, &concat::LibraryScanner::finished, progress, &QProgressDialog::close);
+    connect(progress, &QProgressDialog::canceled, library_scanner_, &concat::LibraryScanner::cancel);
+    library_scanner_->scan({dir}, name_filters.split(' ', Qt::SkipEmptyParts));
+}
+void MainWindow::enqueue_noncompliant_file_(QString path, concat::ProbeResult probe_result) {
+    TRACE
+    auto output_info = library_scan_output_info_;
+    output_info.bound_input_info(retrieve_input_info(probe_result.info));
+    output_info.resolve_reference();
+    if (concat::is_compliant(probe_result.info, output_info, library_scan_resolution_is_maximum_)) {
+        return;
+    }
+    if (library_scan_known_inputs_.contains(path)) {
+        return;
+    }
+    library_scan_known_inputs_.insert(path);
+    enqueue_watched_file_(path, library_scan_preset_);
+}
+void MainWindow::update_remote_workers_() {
+    TRACE
+    bool confirmed = false;
+    auto addresses = QInputDialog::getText(
+        this, tr("remote workers"),
+        tr("comma separated host:port of videos_re_encoder_worker. inputs and outputs must be on a filesystem "
+           "shared with them"),
+        QLineEdit::Normal, settings_->value("remote_workers").toStringList().join(", "), &confirmed);
+    if (not confirmed) {
+        return;
+    }
+    QStringList workers;
+    for (const auto &address : addresses.split(',', Qt::SkipEmptyParts)) {
+        if (not address.trimmed().isEmpty()) {
+            workers.push_back(address.trimmed());
+        }
+    }
+    settings_->setValue("remote_workers", workers);
+    apply_remote_workers_();
+}
+void MainWindow::apply_remote_workers_() {
+    TRACE
+    scheduler_->clear_remote_workers();
+    for (const auto &address : settings_->value("remote_workers").toStringList()) {
+        auto worker = concat::RemoteWorker::from_address(address);
+        if (worker == nullptr) {
+            QMessageBox::warning(nullptr, tr("warning"), tr("invalid address of remote worker: %1").arg(address));
+            continue;
+        }
+        scheduler_->add_remote_worker(worker);
+    }
+}
+void MainWindow::toggle_watching_folders_(bool enabled) {
+    TRACE
+    if (folder_watcher_ == nullptr) {
+        folder_watcher_ = new concat::FolderWatcher(this);
+        connect(folder_watcher_, &concat::FolderWatcher::file_ready, this, &MainWindow::enqueue_watched_file_);
+    }
+    folder_watcher_->clear();
+    if (not enabled) {
+        return;
+    }
+    auto folders = watch_folders_();
+    if (folders.isEmpty()) {
+        QMessageBox::warning(nullptr, tr("warning"), tr("no watch folder is registered"));
+        ui_->actionwatch_folders->setChecked(false);
+        return;
+    }
+    for (const auto &folder : folders) {
+        folder_watcher_->add_folder(folder);
+    }
+    update_watch_back_pressure_();
+}
+void MainWindow::enqueue_watched_file_(QString path, QString preset) {
+    TRACE
+    auto input_path = QUrl::fromLocalFile(path);
+    bool is_opening = not current_unregistered_input_paths_.isEmpty();
+    current_unregistered_input_paths_.push_back(input_path);
+    unregistered_input_presets_.insert(input_path, preset);
+    update_watch_back_pressure_();
+    if (is_opening) {
+        return;  // picked up by register_video_info_()
+    }
+    ui_->pushButton_save->setEnabled(true);
+    ui_->pushButton_remove_item->setEnabled(true);
+    create_savefile_name_();
+}
+QString MainWindow::preset_of_(const QUrl &input_path) {
+    TRACE
+    return unregistered_input_presets_.value(input_path,
+                                             settings_->value("default_preset", tr("custom")).toString());
+}
+void MainWindow::update_watch_back_pressure_() {
+    TRACE
+    if (folder_watcher_ == nullptr) {
+        return;
+    }
+    auto num_waiting_jobs = current_unregistered_input_paths_.size() + scheduler_->num_queued() + num_unenqueued_items_;
+    auto max_queued_jobs =
+        settings_->value("watch_folder/max_queued_jobs", DEFAULT_MAX_QUEUED_JOBS_OF_WATCH_FOLDERS).toInt();
+    folder_watcher_->set_accepting(num_waiting_jobs < max_queued_jobs);
+}
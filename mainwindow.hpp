@@ -3,19 +3,46 @@
 
 #include <QAudioOutput>
 #include <QDir>
+#include <QFileInfo>
+#include <QHash>
 #include <QList>
 #include <QMainWindow>
 #include <QMap>
 #include <QMediaPlayer>
+#include <QPair>
+#include <QPointer>
+#include <QSet>
 #include <QSettings>
 #include <QTemporaryDir>
+#include <QTimer>
 #include <QUrl>
 #include <chrono>
+#include <map>
+#include <memory>
 #include <optional>
 #include <toml.hpp>
 #include <tuple>
 
+#include "concatplan.hpp"
+#include "concurrencytuning.hpp"
+#include "cropdetect.hpp"
+#include "encodescheduler.hpp"
+#include "ffmpegcapabilities.hpp"
+#include "folderwatcher.hpp"
+#include "libraryindex.hpp"
+#include "libraryscan.hpp"
+#include "processrunner.hpp"
 #include "processwidget.hpp"
+#include "qualitycheck.hpp"
+#include "remoteworker.hpp"
+#include "speedhistory.hpp"
+#include "splitencode.hpp"
+#include "statusserver.hpp"
+#include "thumbnailcache.hpp"
+#include "transcodeplan.hpp"
+#include "trialencode.hpp"
+#include "trimplan.hpp"
+#include "vfrdetect.hpp"
 #include "videoinfo.hpp"
 #include "videoinfowidget.hpp"
 
@@ -42,6 +69,33 @@ class MainWindow : public QMainWindow {
     void select_output_dir_();
     void save_result_();
     void select_savefile_name_plugin_();
+    void toggle_watching_folders_(bool enabled);
+    void add_watch_folder_();
+    void clear_watch_folders_();
+    void update_max_queued_jobs_of_watch_folders_();
+    void update_remote_workers_();
+    void scan_library_();
+    void enqueue_noncompliant_file_(QString path, concat::ProbeResult probe_result);
+    void apply_remote_workers_();
+    void update_max_concurrent_jobs_();
+    void update_memory_budget_();
+    void toggle_adapting_concurrency_(bool enabled);
+    void update_min_concurrent_jobs_();
+    void update_min_free_disk_space_();
+    void select_overflow_dir_();
+    void update_thumbnail_cache_size_();
+    void toggle_checking_quality_(bool enabled);
+    void toggle_serving_status_(bool enabled);
+    void toggle_splitting_encodes_(bool enabled);
+    void select_scaling_algorithm_();
+    void tune_concurrency_();
+    void start_trial_();
+    void concatenate_files_();
+    void trim_current_file_();
+    void add_rendition_();
+    void clear_renditions_();
+    void detect_black_bars_();
+    void update_quality_thresholds_();
 
    private:
     enum class VideoDataRole {
@@ -50,13 +104,98 @@ class MainWindow : public QMainWindow {
         output_path,                       // QUrl
         length,  // QTime(一日を超えると表示がバグるだろうがまあいいだろう)
         preset,  // QString
+        job_id,    // int(id of concat::EncodeJob. invalid until enqueued)
+        priority,  // int
+        thumbnail_requested,  // bool
+        quality_scores,       // concat::QualityScores(invalid until checked)
+        source_time_base,     // QString(time base of video stream such as "1/15360")
+        trim_start,           // QTime(invalid unless trimmed)
+        trim_end,             // QTime(invalid unless trimmed)
+        renditions,           // QStringList(presets of outputs written with output_path from one decode)
+        crop,                 // QRect(part of source without black bars. invalid until detected)
+        crop_is_applied,      // bool
+        source_format,        // concat::StreamFormat
     };
+    struct ConcatState {
+        std::unique_ptr<QTemporaryDir> work_dir;
+        QSet<int> normalization_ids;
+        QStringList parts;
+        QString output_path;
+        std::chrono::milliseconds length{0};
+        QStringList output_arguments;  // given to the join
+        int join_id = -1;
+        bool has_failed = false;
+    };
+    /**
+     * @brief jobs of an item writing parts to scratch directory, and a job finishing its output from them
+     * @details such as segments of trim and their join, or streams of split encode and their mux. if a part fails,
+     * the others are canceled and item is reported by the failed part
+     */
+    struct StagedJobs {
+        QListWidgetItem *item = nullptr;
+        std::unique_ptr<QTemporaryDir> work_dir;
+        QSet<int> part_ids;
+        concat::EncodeJob finish;  // enqueued after every part is written
+        QString failure_message;   // written to output of the part which failed first
+        bool has_failed = false;
+    };
+    /// job_id of item whose jobs are being planned, such as while keyframes of trim are probed
+    static constexpr int PREPARING_JOB_ID = -1;
     Ui::MainWindow *ui_;
-    ProcessWidget *process_ = nullptr;  // deleted on close
+    concat::ProcessRunner *process_runner_ = nullptr;  // probes, plugins and thumbnails
+    QPointer<ProcessWidget> background_process_view_;  // deleted on close
+    QPointer<ProcessWidget> encode_process_;  // deleted on close
     QSettings *settings_ = nullptr;
     toml::value presets_;
+    concat::FfmpegCapabilities ffmpeg_capabilities_;
+    concat::TranscodeOptions transcode_options_;
     QList<QUrl> current_unregistered_input_paths_;
-    int encoding_loop_current_index_ = 0;
+    QHash<QUrl, QString> unregistered_input_presets_;
+    concat::EncodeScheduler *scheduler_ = nullptr;
+    concat::SpeedHistory speed_history_;
+    concat::ThumbnailCache *thumbnail_cache_ = nullptr;
+    concat::QualityChecker *quality_checker_ = nullptr;
+    concat::StatusServer *status_server_ = nullptr;
+    concat::QualityThresholds quality_thresholds_;
+    QStringList outputs_below_quality_thresholds_;  // reported when quality checks finish
+    QPointer<concat::TrialEncoder> trial_encoder_;
+    QPointer<concat::ConcurrencyTuner> concurrency_tuner_;
+    QString tuning_key_;  // key of settings which result of running tuning is stored to
+    std::optional<ConcatState> concat_;
+    std::map<int, StagedJobs> staged_jobs_;
+    QHash<int, int> staged_jobs_of_jobs_;  // id of job -> key of staged_jobs_
+    int next_staged_jobs_id_ = 0;
+    QHash<int, QString> stderr_of_renditions_;  // id of job writing renditions -> its stderr, reported if it fails
+    concat::LibraryIndex library_index_;
+    concat::LibraryScanner *library_scanner_ = nullptr;
+    QString library_scan_preset_;
+    concat::VideoInfo library_scan_output_info_;  // parsed from library_scan_preset_ when scan starts
+    QSet<QString> library_scan_known_inputs_;     // inputs in list or queued, so that they aren't added again
+    bool library_scan_resolution_is_maximum_ = false;
+    QMap<int, QListWidgetItem *> items_of_trials_;
+    QTimer thumbnail_timer_;  // thumbnails are requested after scrolling or updating list settles
+    static constexpr int THUMBNAIL_REQUEST_DELAY_MSEC = 100;
+    static constexpr int DEFAULT_THUMBNAIL_CACHE_SIZE_MIB = 64;
+    /// key and number of frames of running jobs, recorded to speed_history_ when they finish
+    QHash<int, QPair<concat::SpeedHistory::Key, double>> speed_samples_of_jobs_;
+    /// part of job of item which estimate of batch uses, cached so that an edit doesn't plan every item again
+    struct ItemEstimate {
+        concat::EncodeJob job;  // only length, cost, priority and predicted_duration are set
+        concat::SpeedHistory::Key key;
+        int num_samples = 0;
+    };
+    QHash<QListWidgetItem *, ItemEstimate> item_estimates_;  // dropped when item is changed or removed
+    int num_estimates_without_samples_ = 0;                  // items of item_estimates_ predicted only from cost
+    QHash<int, QListWidgetItem *> items_of_jobs_;            // id of job -> item of the list whose job_id it is
+    int num_unenqueued_items_ = 0;                           // items of the list without job_id
+    concat::FolderWatcher *folder_watcher_ = nullptr;
+    static constexpr int DEFAULT_MAX_QUEUED_JOBS_OF_WATCH_FOLDERS = 4;
+    static constexpr int MAX_BACKGROUND_PROCESSES = 2;
+    static constexpr int OPENING_PRIORITY = 1;  // before thumbnails
+    static constexpr qint64 MIB = 1024 * 1024;
+    /// part of physical memory which encodes may use by default. the rest is left for OS and other programs
+    static constexpr double DEFAULT_MEMORY_BUDGET_RATIO = 0.8;
+    static constexpr qint64 DEFAULT_MIN_FREE_DISK_SPACE_MIB = 1024;
     static constexpr auto NO_PLUGIN = "do not use any plugins";
 #ifdef _WIN32
     static constexpr auto PYTHON = "py";
@@ -71,29 +210,98 @@ class MainWindow : public QMainWindow {
 
     void update_output_infos_();
     void update_total_length_();
+    void update_batch_estimate_();
+    ItemEstimate estimate_item_(QListWidgetItem *item);
+    void invalidate_estimates_(int first_row, int last_row);
+    /// predict cached estimates again after speed history is updated
+    void repredict_estimates_();
+    void request_visible_thumbnails_();
+    void show_thumbnail_(QString path, QImage image);
 
     void register_user_video_info_(concat::VideoInfo new_value);
     void register_user_output_path_();
+    void register_user_priority_(int new_value);
+    void register_user_crop_(bool is_applied);
 
     void sort_files_();
 
     void change_preset_(QString name);
+    void validate_presets_();
     void select_default_preset_();
 
     void register_output_path_();
 
+    QList<concat::FolderWatcher::Folder> watch_folders_();
+    void enqueue_watched_file_(QString path, QString preset);
+    QString preset_of_(const QUrl &input_path);
+    void update_watch_back_pressure_();
+
     // steps for opening file
     void create_savefile_name_();
-    void register_savefile_name_();
+    void register_savefile_name_(const QString &default_savefile_name);
     void start_opening_();
     void probe_for_video_info_();
-    void register_video_info_();
+    /// decide whether source is vfr from timestamps of a few windows, instead of frame rates in its header
+    void sample_frame_intervals_(const QFileInfo &file, const concat::ProbeResult &probe_result);
+    void register_video_info_(const concat::ProbeResult &probe_result);
+    void abort_opening_video_(const QString &title, const QString &message);
+    /// called after the last queued file is registered or aborted
+    void finish_opening_();
+    void show_background_processes_();
     // end steps
 
     // steps for creating and saving result
     void start_saving_();
-    void re_encode_video_();
-    void check_loop_state_();
+    void continue_saving_();
+    /// warn if estimated outputs exceed free space of their filesystems. returns whether to continue
+    bool confirm_disk_space_();
+    void create_encode_process_(bool is_modal);
+    concat::EncodeJob create_encode_job_(QListWidgetItem *item);
+    concat::SpeedHistory::Key speed_history_key_(QListWidgetItem *item);
+    void enqueue_new_items_();
+    /// enqueue job writing output of item, and keep sample of speed history for it
+    void enqueue_item_job_(QListWidgetItem *item, const concat::EncodeJob &job);
+    void show_started_job_(int id);
+    void show_job_output_(int id, QString stdout_text, QString stderr_text);
+    void show_paused_job_(int id);
+    void show_resumed_job_(int id);
+    void show_requeued_job_(int id);
+    void register_redirected_output_(int id, QString output_path);
+    void reprioritize_job_(int id, int priority);
+    QListWidgetItem *item_of_job_(int id);
+    /// set job_id of item in the list, keeping items_of_jobs_ and num_unenqueued_items_ up to date
+    void set_job_id_(QListWidgetItem *item, const QVariant &id);
+    void register_job_id_(QListWidgetItem *item);
+    void unregister_job_id_(QListWidgetItem *item);
+    void show_quality_scores_(int id, concat::QualityScores scores, bool is_success);
+    void report_low_quality_outputs_();
+    void show_trial_results_(concat::TrialResults results);
+    void register_tuning_results_(QList<concat::TuningResult> results);
+    /// key of settings of tuned concurrency, which is kept per preset and resolution class of output
+    QString tuning_key_of_(QListWidgetItem *item);
+    void apply_tuned_threads_(QListWidgetItem *item, concat::EncodeJob &job);
+    void join_concat_parts_();
+    void continue_concatenating_(int id, bool is_success);
+    std::optional<concat::Trim> trim_of_(QListWidgetItem *item);
+    /// whether item is trimmed and its video is copied, so that only GOPs around cuts are re-encoded
+    bool is_smart_trimmed_(QListWidgetItem *item);
+    void start_trimming_(QListWidgetItem *item);
+    void plan_trimming_(int key, const concat::ProcessResult &result);
+    /// register staged jobs of item, which is marked as preparing until its finishing job is enqueued
+    int start_staging_(QListWidgetItem *item);
+    void enqueue_staged_parts_(int key, const QList<concat::EncodeJob> &parts);
+    void continue_staging_(int id, bool is_success);
+    /// whether item is encoded by split jobs, which is when it's enabled and audio is encoded
+    bool is_split_(QListWidgetItem *item);
+    void start_splitting_(QListWidgetItem *item, const concat::EncodeJob &job);
+    QList<concat::Rendition> renditions_of_(QListWidgetItem *item);
+    /// transcode_options_ with crop of item if it is applied
+    concat::TranscodeOptions transcode_options_of_(QListWidgetItem *item);
+    void report_renditions_(int id, bool is_success);
+    qint64 default_memory_budget_mib_();
+    void apply_adaptive_concurrency_();
+    void show_finished_job_(int id, bool is_success);
+    void update_batch_progress_();
     void cleanup_after_saving_();
     // end steps
 };
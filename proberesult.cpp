@@ -0,0 +1,128 @@
+#include "proberesult.hpp"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <ciso646>
+
+namespace concat {
+namespace {
+QString tr(const char *text) { return QCoreApplication::translate("ProbeResult", text); }
+std::optional<double> parse_fraction(const QString &text) {
+    static const QRegularExpression fraction_pattern(R"((\d+)/(\d+))");
+    auto match = fraction_pattern.match(text);
+    bool ok1 = false, ok2 = false;
+    auto numerator = match.captured(1).toInt(&ok1);
+    auto denominator = match.captured(2).toInt(&ok2);
+    if (not(ok1 && ok2)) {
+        return std::nullopt;
+    }
+    return static_cast<double>(numerator) / denominator;
+}
+}  // namespace
+QJsonObject ProbeResult::to_json() const {
+    auto resolution = std::get<QSize>(info.resolution);
+    QJsonObject result{{"width", resolution.width()},
+                       {"height", resolution.height()},
+                       {"framerate", std::get<double>(info.framerate)},
+                       {"is_vfr", info.is_vfr},
+                       {"video_codec", std::get<QString>(info.video_codec)},
+                       {"audio_codec", std::get<QString>(info.audio_codec)},
+                       {"length_msec", static_cast<qint64>(length.count())},
+                       {"time_base", time_base},
+                       {"pix_fmt", format.pix_fmt},
+                       {"profile", format.profile},
+                       {"sample_rate", format.sample_rate},
+                       {"channels", format.channels}};
+    if (vfr_confidence.has_value()) {
+        result.insert("vfr_confidence", vfr_confidence.value());
+    }
+    return result;
+}
+std::optional<ProbeResult> ProbeResult::from_json(const QJsonObject &json) {
+    // entries written before format was probed are dropped, so that their files are probed again
+    if (not(json["width"].isDouble() && json["height"].isDouble() && json["framerate"].isDouble() &&
+            json["video_codec"].isString() && json["audio_codec"].isString() && json["pix_fmt"].isString() &&
+            json["sample_rate"].isDouble())) {
+        return std::nullopt;
+    }
+    ProbeResult result;
+    result.info = VideoInfo::create_input_info();
+    result.info.resolution = QSize(json["width"].toInt(), json["height"].toInt());
+    result.info.framerate = json["framerate"].toDouble();
+    result.info.is_vfr = json["is_vfr"].toBool();
+    result.info.video_codec = json["video_codec"].toString();
+    result.info.audio_codec = json["audio_codec"].toString();
+    result.length = std::chrono::milliseconds(json["length_msec"].toInteger());
+    result.time_base = json["time_base"].toString();
+    result.format.pix_fmt = json["pix_fmt"].toString();
+    result.format.profile = json["profile"].toString();
+    result.format.sample_rate = json["sample_rate"].toInt();
+    result.format.channels = json["channels"].toInt();
+    if (json["vfr_confidence"].isDouble()) {
+        result.vfr_confidence = json["vfr_confidence"].toDouble();
+    }
+    return result;
+}
+QStringList probe_arguments(const QString &path) {
+    return {"-hide_banner", "-show_streams", "-show_format", "-of", "json", "-v", "quiet", path};
+}
+std::optional<ProbeResult> parse_probe_result(const QString &text, QString &error) {
+    QJsonParseError err;
+    auto prove_result = QJsonDocument::fromJson(text.toUtf8(), &err);
+    if (prove_result.isNull()) {
+        error = tr("failed to parse result of ffprobe\nerror message:%1").arg(err.errorString());
+        return std::nullopt;
+    }
+    auto duration_str = prove_result.object()["format"].toObject()["duration"].toString();
+    bool ok;
+    double duration = duration_str.toDouble(&ok);
+    if (not ok) {
+        error = tr("failed to parse duration [%1]").arg(duration_str);
+        return std::nullopt;
+    }
+    ProbeResult result;
+    result.length = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(duration));
+    result.info = VideoInfo::create_input_info();
+    bool video_found = false, audio_found = false;
+    for (auto stream_value : prove_result.object()["streams"].toArray()) {
+        auto stream = stream_value.toObject();
+        if (stream["codec_type"] == "video") {
+            video_found = true;
+            result.info.video_codec = stream["codec_name"].toString();
+            result.info.resolution = QSize(stream["width"].toInt(), stream["height"].toInt());
+            auto framerate = parse_fraction(stream["r_frame_rate"].toString());
+            if (not framerate.has_value()) {
+                error = tr("failed to parse frame rate [%1]").arg(stream["r_frame_rate"].toString());
+                return std::nullopt;
+            }
+            result.info.framerate = framerate.value();
+            auto avg_framerate = parse_fraction(stream["avg_frame_rate"].toString());
+            if (not avg_framerate.has_value()) {
+                error = tr("failed to parse frame rate [%1]").arg(stream["avg_frame_rate"].toString());
+                return std::nullopt;
+            }
+            // only a guess, which misses many recordings of phones and screens. see detect_vfr()
+            result.info.is_vfr = framerate.value() != avg_framerate.value();
+            result.time_base = stream["time_base"].toString();
+            result.format.pix_fmt = stream["pix_fmt"].toString();
+            result.format.profile = stream["profile"].toString();
+        } else if (stream["codec_type"] == "audio") {
+            audio_found = true;
+            result.info.audio_codec = stream["codec_name"].toString();
+            result.format.sample_rate = stream["sample_rate"].toString().toInt();  // ffprobe writes it as string
+            result.format.channels = stream["channels"].toInt();
+        }
+    }
+    if (not video_found) {
+        error = tr("video stream was not found");
+        return std::nullopt;
+    }
+    if (not audio_found) {
+        error = tr("audio stream was not found");
+        return std::nullopt;
+    }
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,65 @@
+#ifndef VIDEO_RE_ENCODER_PROBERESULT
+#define VIDEO_RE_ENCODER_PROBERESULT
+
+#include <QJsonObject>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <ciso646>
+#include <chrono>
+#include <optional>
+
+#include "videoinfo.hpp"
+
+namespace concat {
+/**
+ * @brief details of streams which must match for them to be joined by stream copy, besides those in VideoInfo
+ */
+struct StreamFormat {
+    /// of video stream, such as "yuv420p"
+    QString pix_fmt;
+    /// of video stream as reported by ffprobe, such as "High"
+    QString profile;
+    /// of audio stream
+    int sample_rate = 0;
+    /// of audio stream
+    int channels = 0;
+    bool operator==(const StreamFormat &other) const {
+        return pix_fmt == other.pix_fmt && profile == other.profile && sample_rate == other.sample_rate &&
+               channels == other.channels;
+    }
+    bool operator!=(const StreamFormat &other) const { return not(*this == other); }
+};
+/**
+ * @brief what is known about a source file from ffprobe
+ */
+struct ProbeResult {
+    /// info of source, whose references are resolved
+    VideoInfo info;
+    std::chrono::milliseconds length{0};
+    /// time base of video stream, such as "1/15360"
+    QString time_base;
+    /// confidence of is_vfr decided from sampled timestamps. std::nullopt means it's guessed from frame rates. see
+    /// detect_vfr()
+    std::optional<double> vfr_confidence;
+    StreamFormat format;
+
+    QJsonObject to_json() const;
+    static std::optional<ProbeResult> from_json(const QJsonObject &json);
+};
+/**
+ * @brief arguments of ffprobe whose output is parsed by parse_probe_result()
+ */
+QStringList probe_arguments(const QString &path);
+/**
+ * @brief parse json written by ffprobe
+ *
+ * @param text stdout of ffprobe run with probe_arguments()
+ * @param error human readable reason of failure
+ * @return std::nullopt if text is malformed, or video or audio stream is missing
+ */
+std::optional<ProbeResult> parse_probe_result(const QString &text, QString &error);
+}  // namespace concat
+Q_DECLARE_METATYPE(concat::StreamFormat);
+
+#endif
@@ -0,0 +1,125 @@
+#include "processrunner.hpp"
+
+#include <QMetaObject>
+#include <QtDebug>
+#include <algorithm>
+#include <ciso646>
+
+namespace concat {
+ProcessRunner::ProcessRunner(int max_processes, QObject *parent)
+    : QObject(parent), max_processes_(qMax(1, max_processes)) {}
+ProcessRunner::~ProcessRunner() {
+    for (auto it = running_.cbegin(); it != running_.cend(); ++it) {
+        it.key()->disconnect(this);
+        it.key()->kill();
+        it.key()->waitForFinished();
+    }
+}
+int ProcessRunner::run(const QString &program, const QStringList &arguments, Callback on_finished, int priority) {
+    auto id = next_id_++;
+    // keep order of commands with the same priority
+    auto position = std::find_if(queue_.begin(), queue_.end(),
+                                 [priority](const Command &command) { return command.priority < priority; });
+    queue_.insert(position, {id, program, arguments, std::move(on_finished), priority});
+    // started from event loop, so that callback is never called before caller knows id
+    QMetaObject::invokeMethod(this, &ProcessRunner::start_next_, Qt::QueuedConnection);
+    return id;
+}
+void ProcessRunner::cancel(int id) {
+    auto queued = std::find_if(queue_.begin(), queue_.end(), [id](const Command &command) { return command.id == id; });
+    // callers wait for callback of every command they run, so canceled ones are finished as failed
+    ProcessResult result;
+    result.error = QStringLiteral("canceled");
+    if (queued != queue_.end()) {
+        auto command = *queued;
+        queue_.erase(queued);
+        if (command.on_finished) {
+            command.on_finished(result);
+        }
+        return;
+    }
+    for (auto it = running_.begin(); it != running_.end(); ++it) {
+        if (it->command.id == id) {
+            auto process = it.key();
+            auto running = *it;
+            running_.erase(it);
+            process->kill();
+            process->waitForFinished();
+            idle_processes_.push_back(process);
+            result.stdout_text = QString::fromUtf8(running.stdout_bytes);
+            result.stderr_text = QString::fromUtf8(running.stderr_bytes);
+            if (running.command.on_finished) {
+                running.command.on_finished(result);
+            }
+            emit finished(id, false);
+            start_next_();
+            return;
+        }
+    }
+}
+void ProcessRunner::set_max_processes(int max_processes) {
+    max_processes_ = qMax(1, max_processes);
+    start_next_();
+}
+QProcess *ProcessRunner::take_idle_process_() {
+    if (not idle_processes_.isEmpty()) {
+        return idle_processes_.takeLast();
+    }
+    auto process = new QProcess(this);
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, process] { read_output_(process); });
+    connect(process, &QProcess::readyReadStandardError, this, [this, process] { read_output_(process); });
+    connect(process, &QProcess::finished, this, [this, process](int, QProcess::ExitStatus exit_status) {
+        finish_(process, exit_status == QProcess::CrashExit);
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            finish_(process, true);
+        }
+    });
+    return process;
+}
+void ProcessRunner::start_next_() {
+    while (not queue_.isEmpty() && running_.size() < max_processes_) {
+        auto command = queue_.takeFirst();
+        auto process = take_idle_process_();
+        running_.insert(process, {command, {}, {}});
+        emit started(command.id, command.program, command.arguments);
+        process->start(command.program, command.arguments);
+    }
+}
+void ProcessRunner::read_output_(QProcess *process) {
+    // drained even for canceled command, so that output doesn't leak into the next command run by the process
+    auto stdout_bytes = process->readAllStandardOutput();
+    auto stderr_bytes = process->readAllStandardError();
+    auto running = running_.find(process);
+    if (running == running_.end()) {
+        return;
+    }
+    running->stdout_bytes += stdout_bytes;
+    running->stderr_bytes += stderr_bytes;
+    emit output(running->command.id, QString::fromUtf8(stdout_bytes), QString::fromUtf8(stderr_bytes));
+}
+void ProcessRunner::finish_(QProcess *process, bool has_crashed) {
+    read_output_(process);
+    if (not running_.contains(process)) {
+        return;
+    }
+    auto running = running_.take(process);
+    ProcessResult result;
+    result.exit_code = has_crashed ? -1 : process->exitCode();
+    result.is_success = not has_crashed && result.exit_code == 0;
+    // decoded at once, so that multibyte characters split between reads are not broken
+    result.stdout_text = QString::fromUtf8(running.stdout_bytes);
+    result.stderr_text = QString::fromUtf8(running.stderr_bytes);
+    if (has_crashed) {
+        result.error = process->errorString();
+        qWarning() << running.command.program << running.command.arguments << result.error;
+    }
+    idle_processes_.push_back(process);
+    if (running.command.on_finished) {
+        running.command.on_finished(result);
+    }
+    emit finished(running.command.id, result.is_success);
+    start_next_();
+}
+}  // namespace concat
@@ -0,0 +1,87 @@
+#ifndef VIDEO_RE_ENCODER_PROCESSRUNNER
+#define VIDEO_RE_ENCODER_PROCESSRUNNER
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+namespace concat {
+struct ProcessResult {
+    /// process exited normally with exit code 0
+    bool is_success = false;
+    int exit_code = -1;
+    QString stdout_text;
+    QString stderr_text;
+    /// error message of QProcess when process failed to start or crashed
+    QString error;
+};
+/**
+ * @brief run short-lived background commands such as ffprobe, plugins and thumbnail generation without gui.
+ * @details a fixed number of QProcess objects are kept and reused for queued commands, so that no thread or widget is
+ * created per command. commands with higher priority are started first. progress can be shown by connecting signals
+ * to ProcessWidget::add_job() and its friends.
+ */
+class ProcessRunner : public QObject {
+    Q_OBJECT
+
+   public:
+    using Callback = std::function<void(const ProcessResult &)>;
+    explicit ProcessRunner(int max_processes = 2, QObject *parent = nullptr);
+    ~ProcessRunner();
+    /**
+     * @brief queue command. it is started from event loop even if a process is available.
+     *
+     * @param program
+     * @param arguments
+     * @param on_finished called with result before finished() is emitted
+     * @param priority commands with higher priority start first. commands with the same priority start in order
+     * @return int id of command
+     */
+    int run(const QString &program, const QStringList &arguments, Callback on_finished = {}, int priority = 0);
+    /**
+     * @brief forget queued command or kill running one. its callback is called with failed result whose error is
+     * "canceled", and finished() is emitted if it was started.
+     */
+    void cancel(int id);
+    void set_max_processes(int max_processes);
+    int max_processes() const { return max_processes_; }
+    int num_queued() const { return queue_.size(); }
+    int num_running() const { return running_.size(); }
+
+   signals:
+    void started(int id, QString program, QStringList arguments);
+    void output(int id, QString stdout_text, QString stderr_text);
+    void finished(int id, bool is_success);
+
+   private:
+    struct Command {
+        int id;
+        QString program;
+        QStringList arguments;
+        Callback on_finished;
+        int priority;
+    };
+    struct Running {
+        Command command;
+        QByteArray stdout_bytes;
+        QByteArray stderr_bytes;
+    };
+    int max_processes_;
+    int next_id_ = 0;
+    QList<Command> queue_;
+    QHash<QProcess *, Running> running_;
+    QList<QProcess *> idle_processes_;
+
+    QProcess *take_idle_process_();
+    void start_next_();
+    void read_output_(QProcess *process);
+    void finish_(QProcess *process, bool has_crashed);
+};
+}  // namespace concat
+
+#endif
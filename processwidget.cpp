@@ -2,9 +2,12 @@
 
 #include <QMessageBox>
 #include <QProcess>
+#include <QSignalBlocker>
 #include <QTextEdit>
 #include <QTextStream>
 #include <QTime>
+#include <algorithm>
+#include <tuple>
 
 #include "ui_processwidget.h"
 
@@ -12,20 +15,29 @@ namespace {
 constexpr char TIME_FORMAT[] = "H'h'mm'm'ss's'";
 }
 
-ProcessWidget::ProcessWidget(bool close_on_final, QTime batch_total_length, QWidget *parent, Qt::WindowFlags flags)
+ProcessWidget::ProcessWidget(bool close_on_final, bool shows_batch_progress, QWidget *parent, Qt::WindowFlags flags)
     : QWidget(parent, flags),
       ui_(new Ui::ProcessWidget),
       close_on_final_(close_on_final),
-      batch_total_length_(batch_total_length) {
+      shows_batch_progress_(shows_batch_progress) {
     ui_->setupUi(this);
     ui_->label_status->setText(tr("Executing nothing."));
-    ui_->progressBar_batch->setMaximum(batch_total_length.msecsSinceStartOfDay());
-    ui_->label_batch_progress->setText(
-        tr("%1/%2 finished").arg("0h00m00s").arg(batch_total_length.toString(TIME_FORMAT)));
-    if (not batch_total_length.isValid()) {
+    ui_->progressBar_batch->setMaximum(BATCH_PROGRESS_RESOLUTION);
+    ui_->progressBar_batch->setValue(0);
+    ui_->label_batch_progress->setText(tr("%1% finished").arg(0.0, 0, 'f', 1));
+    batch_progress_params_ = ProgressParams(0, BATCH_PROGRESS_RESOLUTION);
+    if (not shows_batch_progress) {
         ui_->label_batch_progress->hide();
         ui_->progressBar_batch->hide();
     }
+    ui_->label_job_priority->hide();
+    ui_->spinBox_job_priority->hide();
+    ui_->pushButton_pause->hide();
+    connect(ui_->pushButton_close, &QPushButton::clicked, this, &ProcessWidget::do_close_);
+    connect(ui_->pushButton_kill, &QPushButton::clicked, this, &ProcessWidget::kill_process_);
+    connect(ui_->pushButton_pause, &QPushButton::clicked, this, &ProcessWidget::toggle_pausing_job_);
+    connect(ui_->spinBox_job_priority, &QSpinBox::valueChanged, this, &ProcessWidget::request_priority_change_);
+    connect(ui_->tab_stdout_commands, &QTabWidget::currentChanged, this, &ProcessWidget::show_job_of_tab_);
     thread_.start();
 }
 
@@ -36,7 +48,7 @@ ProcessWidget::~ProcessWidget() {
 }
 
 void ProcessWidget::start(const QString &command, const QStringList &arguments, bool is_final,
-                          ProcessWidget::ProgressParams progress_params, QTime length) {
+                          ProcessWidget::ProgressParams progress_params) {
     if (process_ != nullptr) {
         process_->deleteLater();
     }
@@ -50,8 +62,6 @@ void ProcessWidget::start(const QString &command, const QStringList &arguments,
     connect(process_, &QProcess::errorOccurred, this, &ProcessWidget::show_error_);
     connect(process_, &QProcess::finished, this, &ProcessWidget::update_label_on_finish_);
     connect(this, &ProcessWidget::sigkill, process_, &QProcess::close, Qt::BlockingQueuedConnection);
-    connect(ui_->pushButton_close, &QPushButton::clicked, this, &ProcessWidget::do_close_);
-    connect(ui_->pushButton_kill, &QPushButton::clicked, this, &ProcessWidget::kill_process_);
     if (is_final) {
         if (close_on_final_) {
             connect(process_, &QProcess::finished, this, &ProcessWidget::do_close_);
@@ -60,74 +70,103 @@ void ProcessWidget::start(const QString &command, const QStringList &arguments,
         }
     }
 
-    auto arguments_content = new QWidget;
-    auto arguments_layout = new QGridLayout(arguments_content);
-    auto arguments_textedit = new QTextEdit(arguments_content);
-    arguments_textedit->setReadOnly(true);
-    arguments_textedit->setLineWrapMode(QTextEdit::NoWrap);
-    arguments_textedit->setWordWrapMode(QTextOption::NoWrap);
-    QString arguments_quoted;
-    QTextStream arguments_stream(&arguments_quoted);
-    for (const auto &argument : arguments) {
-        if (argument.contains(" ")) {
-            arguments_stream << QStringLiteral(R"("%1")").arg(argument);
-        } else {
-            arguments_stream << argument;
-        }
-        arguments_stream << " ";
-    }
-    arguments_textedit->append(arguments_quoted);
-    arguments_layout->addWidget(arguments_textedit);
-    auto current_arguments_tab_idx = ui_->tab_arguments_commands->addTab(arguments_content, command);
-    ui_->tab_arguments_commands->setCurrentIndex(current_arguments_tab_idx);
-
-    auto stdout_content = new QWidget;
-    auto stdout_layout = new QGridLayout(stdout_content);
-    auto stdout_textedit = new QTextEdit(stdout_content);
-    stdout_textedit->setReadOnly(true);
-    stdout_layout->addWidget(stdout_textedit);
-    current_stdout_tab_idx_ = ui_->tab_stdout_commands->addTab(stdout_content, command);
-    ui_->tab_stdout_commands->setCurrentIndex(current_stdout_tab_idx_);
-
-    auto stderr_content = new QWidget;
-    auto stderr_layout = new QGridLayout(stderr_content);
-    auto stderr_textedit = new QTextEdit(stdout_content);
-    stderr_textedit->setReadOnly(true);
-    stderr_layout->addWidget(stderr_textedit);
-    current_stderr_tab_idx_ = ui_->tab_stderr_commands->addTab(stderr_content, command);
-    ui_->tab_stderr_commands->setCurrentIndex(current_stderr_tab_idx_);
+    std::tie(current_stdout_tab_idx_, current_stderr_tab_idx_) = add_tabs_(command, arguments);
 
     current_progress_params_ = progress_params;
-    if (current_progress_params_.is_active()) {
-        ui_->progressBar->show();
-        ui_->progressBar->setEnabled(true);
-        ui_->progressBar->setMinimum(current_progress_params_.min);
-        ui_->progressBar->setMaximum(current_progress_params_.max);
-        ui_->progressBar->reset();
-        ui_->label_remaining->show();
-        ui_->label_remaining->setEnabled(true);
-        ui_->label_progress->show();
-        ui_->label_progress->setEnabled(true);
-    } else {
-        ui_->progressBar->hide();
-        ui_->label_remaining->hide();
-        ui_->label_progress->hide();
-    }
+    show_progress_params_(current_progress_params_);
 
     ui_->label_status->setText(tr("Starting %1").arg(command));
     disable_closing_();
 
-    length_finished_processes_ = QTime::fromMSecsSinceStartOfDay(length_finished_processes_.msecsSinceStartOfDay() +
-                                                                 length.msecsSinceStartOfDay());
-
     emit start_process(command, arguments, QIODeviceBase::ReadWrite);
 }
+void ProcessWidget::add_job(int id, const QString &command, const QStringList &arguments,
+                            ProgressParams progress_params) {
+    auto [stdout_tab_idx, stderr_tab_idx] = add_tabs_(command, arguments);
+    jobs_.insert(id, {stdout_tab_idx, stderr_tab_idx, progress_params});
+    jobs_[id].command = command;
+    job_of_stdout_tab_.insert(stdout_tab_idx, id);
+    show_job_of_tab_(stdout_tab_idx);
+    disable_closing_();
+    if (shows_batch_progress_) {
+        ui_->label_batch_progress->show();
+        ui_->progressBar_batch->show();
+    }
+    ui_->label_job_priority->show();
+    ui_->spinBox_job_priority->show();
+    ui_->pushButton_pause->show();
+    auto num_running = std::count_if(jobs_.cbegin(), jobs_.cend(), [](const JobView &view) { return view.is_running; });
+    ui_->label_status->setText(tr("Executing %n job(s)", nullptr, static_cast<int>(num_running)));
+}
+void ProcessWidget::append_job_output(int id, const QString &stdout_text, const QString &stderr_text) {
+    auto job = jobs_.find(id);
+    if (job == jobs_.end()) {
+        return;
+    }
+    if (not stdout_text.isEmpty()) {
+        append_text_(stdout_textedit_of_(job->stdout_tab_idx), stdout_text);
+    }
+    if (not stderr_text.isEmpty()) {
+        append_text_(stderr_textedit_of_(job->stderr_tab_idx), stderr_text);
+    }
+    if (not job->progress_params.is_active()) {
+        return;
+    }
+    int new_value = job->progress_params.calc_progress(stdout_text, stderr_text);
+    if (job->progress_params.min <= new_value && new_value <= job->progress_params.max) {
+        job->progress = new_value;
+        if (ui_->tab_stdout_commands->currentIndex() == job->stdout_tab_idx) {
+            show_progress_(job->progress_params, new_value);
+        }
+    }
+}
+void ProcessWidget::finish_job(int id, bool is_success) {
+    auto job = jobs_.find(id);
+    if (job == jobs_.end()) {
+        return;
+    }
+    job->is_running = false;
+    job->is_paused = false;
+    ui_->tab_stdout_commands->setTabText(job->stdout_tab_idx, job->command);
+    if (ui_->tab_stdout_commands->currentIndex() == job->stdout_tab_idx) {
+        show_job_controls_(*job);
+    }
+    auto num_running = std::count_if(jobs_.cbegin(), jobs_.cend(), [](const JobView &view) { return view.is_running; });
+    ui_->label_status->setText(is_success ? tr("A job has finished. Executing %n job(s)", nullptr,
+                                               static_cast<int>(num_running))
+                                          : tr("A job has failed. Executing %n job(s)", nullptr,
+                                               static_cast<int>(num_running)));
+}
+void ProcessWidget::finish_batch() {
+    ui_->label_status->setText(tr("Every job has finished."));
+    enable_closing_();
+}
 QString ProcessWidget::get_stdout(int index) {
     return stdout_textedit_of_(index < 0 ? current_stdout_tab_idx_ : index)->toPlainText();
 }
 QString ProcessWidget::get_stderr(int index) {
     return stderr_textedit_of_(index < 0 ? current_stderr_tab_idx_ : index)->toPlainText();
 }
+void ProcessWidget::set_batch_progress(double ratio) {
+    auto new_value = static_cast<int>(qBound(0.0, ratio, 1.0) * BATCH_PROGRESS_RESOLUTION);
+    if (new_value == ui_->progressBar_batch->value()) {
+        return;
+    }
+    if (new_value < ui_->progressBar_batch->value()) {  // new batch has started
+        batch_progress_params_ = ProgressParams(0, BATCH_PROGRESS_RESOLUTION);
+    }
+    ui_->progressBar_batch->setValue(new_value);
+    auto text = tr("%1% finished").arg(100.0 * new_value / BATCH_PROGRESS_RESOLUTION, 0, 'f', 1);
+    using Clock = ProcessWidget::ProgressParams::Clock;
+    using std::chrono::duration_cast, std::chrono::milliseconds;
+    auto estimated = batch_progress_params_.estimate_remaining(new_value, Clock::now());
+    if (estimated.has_value()) {
+        text += tr(", about %1 remaining")
+                    .arg(QTime::fromMSecsSinceStartOfDay(duration_cast<milliseconds>(estimated.value()).count())
+                             .toString(TIME_FORMAT));
+    }
+    ui_->label_batch_progress->setText(text);
+}
 void ProcessWidget::clear_stdout(int index) {
     stdout_textedit_of_(index < 0 ? current_stdout_tab_idx_ : index)->clear();
 }
@@ -138,10 +177,6 @@ void ProcessWidget::update_label_on_start_() {
     ui_->label_status->setText(tr("Executing %1 (pid=%2)").arg(process_->program()).arg(process_->processId()));
 }
 void ProcessWidget::update_label_on_finish_(int exit_code, QProcess::ExitStatus exit_status) {
-    ui_->progressBar_batch->setValue(length_finished_processes_.msecsSinceStartOfDay());
-    ui_->label_batch_progress->setText(tr("%1/%2 finished")
-                                           .arg(length_finished_processes_.toString(TIME_FORMAT))
-                                           .arg(batch_total_length_.toString(TIME_FORMAT)));
     switch (exit_status) {
         case QProcess::NormalExit:
             ui_->label_status->setText(
@@ -177,28 +212,79 @@ QString ProcessWidget::program() { return process_->program(); }
 QStringList ProcessWidget::arguments() { return process_->arguments(); };
 void ProcessWidget::update_stdout_() {
     process_->setReadChannel(QProcess::StandardOutput);
-    auto textedit = stdout_textedit_of_(current_stdout_tab_idx_);
-    auto cursor = textedit->textCursor();
-    textedit->moveCursor(QTextCursor::End);
     auto new_text = QString::fromUtf8(process_->readAll());  // NOTE: from utf8!!!
-    textedit->insertPlainText(new_text);
-    textedit->setTextCursor(cursor);
+    append_text_(stdout_textedit_of_(current_stdout_tab_idx_), new_text);
     update_progress_(new_text, QStringLiteral(""));
 }
 void ProcessWidget::update_stderr_() {
     process_->setReadChannel(QProcess::StandardError);
-    auto textedit = stderr_textedit_of_(current_stderr_tab_idx_);
+    auto new_text = QString::fromUtf8(process_->readAll());  // NOTE: from utf8!!!
+    append_text_(stderr_textedit_of_(current_stderr_tab_idx_), new_text);
+    update_progress_(QStringLiteral(""), new_text);
+}
+void ProcessWidget::append_text_(QTextEdit *textedit, const QString &text) {
     auto cursor = textedit->textCursor();
     textedit->moveCursor(QTextCursor::End);
-    auto new_text = QString::fromUtf8(process_->readAll());  // NOTE: from utf8!!!
-    textedit->insertPlainText(new_text);
+    textedit->insertPlainText(text);
     textedit->setTextCursor(cursor);
-    update_progress_(QStringLiteral(""), new_text);
 }
 void ProcessWidget::kill_process_() {
+    auto job = job_of_stdout_tab_.find(ui_->tab_stdout_commands->currentIndex());
+    if (job != job_of_stdout_tab_.end()) {
+        emit cancel_requested(job.value());
+        return;
+    }
     enable_closing_();
     emit sigkill();  // this call blocks
 }
+void ProcessWidget::toggle_pausing_job_() {
+    auto id = job_of_stdout_tab_.find(ui_->tab_stdout_commands->currentIndex());
+    if (id == job_of_stdout_tab_.end()) {
+        return;
+    }
+    if (jobs_[id.value()].is_paused) {
+        emit resume_requested(id.value());
+    } else {
+        emit pause_requested(id.value());
+    }
+}
+void ProcessWidget::request_priority_change_(int priority) {
+    auto id = job_of_stdout_tab_.find(ui_->tab_stdout_commands->currentIndex());
+    if (id == job_of_stdout_tab_.end()) {
+        return;
+    }
+    jobs_[id.value()].priority = priority;
+    emit priority_change_requested(id.value(), priority);
+}
+void ProcessWidget::set_job_paused(int id, bool is_paused) {
+    auto job = jobs_.find(id);
+    if (job == jobs_.end()) {
+        return;
+    }
+    job->is_paused = is_paused;
+    ui_->tab_stdout_commands->setTabText(job->stdout_tab_idx, is_paused ? tr("%1 (paused)").arg(job->command)
+                                                                         : job->command);
+    if (ui_->tab_stdout_commands->currentIndex() == job->stdout_tab_idx) {
+        show_job_controls_(*job);
+    }
+}
+void ProcessWidget::set_job_priority(int id, int priority) {
+    auto job = jobs_.find(id);
+    if (job == jobs_.end()) {
+        return;
+    }
+    job->priority = priority;
+    if (ui_->tab_stdout_commands->currentIndex() == job->stdout_tab_idx) {
+        show_job_controls_(*job);
+    }
+}
+void ProcessWidget::show_job_controls_(const JobView &view) {
+    QSignalBlocker blocker(ui_->spinBox_job_priority);
+    ui_->spinBox_job_priority->setValue(view.priority);
+    ui_->spinBox_job_priority->setEnabled(view.is_running);
+    ui_->pushButton_pause->setText(view.is_paused ? tr("Resume") : tr("Pause"));
+    ui_->pushButton_pause->setEnabled(view.is_running);
+}
 void ProcessWidget::enable_closing_() {
     ui_->pushButton_close->setEnabled(true);
     ui_->pushButton_kill->setEnabled(false);
@@ -239,18 +325,90 @@ void ProcessWidget::update_progress_(QStringView stdout_text, QStringView stderr
     if (current_progress_params_.is_active()) {
         int new_value = current_progress_params_.calc_progress(stdout_text, stderr_text);
         if (current_progress_params_.min <= new_value && new_value <= current_progress_params_.max) {
-            ui_->progressBar->setValue(new_value);
-            using Clock = ProcessWidget::ProgressParams::Clock;
-            using std::chrono::duration_cast, std::chrono::milliseconds;
-            auto maybe_estimated = current_progress_params_.estimate_remaining(new_value, Clock::now());
-            if (not maybe_estimated.has_value()) {
-                return;
-            }
-            auto estimated = maybe_estimated.value();
-            ui_->label_remaining->setText(
-                QTime::fromMSecsSinceStartOfDay(duration_cast<milliseconds>(estimated).count())
-                    .toString(tr("hh'h'mm'm'ss's'")));
-            ui_->label_progress->setText(current_progress_params_.format_progress(new_value));
+            show_progress_(current_progress_params_, new_value);
         }
     }
 }
+void ProcessWidget::show_progress_(ProgressParams &progress_params, int new_value) {
+    ui_->progressBar->setValue(new_value);
+    using Clock = ProcessWidget::ProgressParams::Clock;
+    using std::chrono::duration_cast, std::chrono::milliseconds;
+    auto maybe_estimated = progress_params.estimate_remaining(new_value, Clock::now());
+    if (not maybe_estimated.has_value()) {
+        return;
+    }
+    auto estimated = maybe_estimated.value();
+    ui_->label_remaining->setText(QTime::fromMSecsSinceStartOfDay(duration_cast<milliseconds>(estimated).count())
+                                      .toString(tr("hh'h'mm'm'ss's'")));
+    ui_->label_progress->setText(progress_params.format_progress(new_value));
+}
+void ProcessWidget::show_job_of_tab_(int stdout_tab_idx) {
+    auto id = job_of_stdout_tab_.find(stdout_tab_idx);
+    if (id == job_of_stdout_tab_.end()) {
+        return;
+    }
+    auto &job = jobs_[id.value()];
+    show_progress_params_(job.progress_params);
+    if (job.progress >= 0) {
+        ui_->progressBar->setValue(job.progress);
+        ui_->label_progress->setText(job.progress_params.format_progress(job.progress));
+    }
+    show_job_controls_(job);
+}
+std::pair<int, int> ProcessWidget::add_tabs_(const QString &command, const QStringList &arguments) {
+    auto arguments_content = new QWidget;
+    auto arguments_layout = new QGridLayout(arguments_content);
+    auto arguments_textedit = new QTextEdit(arguments_content);
+    arguments_textedit->setReadOnly(true);
+    arguments_textedit->setLineWrapMode(QTextEdit::NoWrap);
+    arguments_textedit->setWordWrapMode(QTextOption::NoWrap);
+    QString arguments_quoted;
+    QTextStream arguments_stream(&arguments_quoted);
+    for (const auto &argument : arguments) {
+        if (argument.contains(" ")) {
+            arguments_stream << QStringLiteral(R"("%1")").arg(argument);
+        } else {
+            arguments_stream << argument;
+        }
+        arguments_stream << " ";
+    }
+    arguments_textedit->append(arguments_quoted);
+    arguments_layout->addWidget(arguments_textedit);
+    auto arguments_tab_idx = ui_->tab_arguments_commands->addTab(arguments_content, command);
+    ui_->tab_arguments_commands->setCurrentIndex(arguments_tab_idx);
+
+    auto stdout_content = new QWidget;
+    auto stdout_layout = new QGridLayout(stdout_content);
+    auto stdout_textedit = new QTextEdit(stdout_content);
+    stdout_textedit->setReadOnly(true);
+    stdout_layout->addWidget(stdout_textedit);
+    auto stdout_tab_idx = ui_->tab_stdout_commands->addTab(stdout_content, command);
+
+    auto stderr_content = new QWidget;
+    auto stderr_layout = new QGridLayout(stderr_content);
+    auto stderr_textedit = new QTextEdit(stdout_content);
+    stderr_textedit->setReadOnly(true);
+    stderr_layout->addWidget(stderr_textedit);
+    auto stderr_tab_idx = ui_->tab_stderr_commands->addTab(stderr_content, command);
+    ui_->tab_stderr_commands->setCurrentIndex(stderr_tab_idx);
+
+    ui_->tab_stdout_commands->setCurrentIndex(stdout_tab_idx);
+    return {stdout_tab_idx, stderr_tab_idx};
+}
+void ProcessWidget::show_progress_params_(ProgressParams &progress_params) {
+    if (progress_params.is_active()) {
+        ui_->progressBar->show();
+        ui_->progressBar->setEnabled(true);
+        ui_->progressBar->setMinimum(progress_params.min);
+        ui_->progressBar->setMaximum(progress_params.max);
+        ui_->progressBar->reset();
+        ui_->label_remaining->show();
+        ui_->label_remaining->setEnabled(true);
+        ui_->label_progress->show();
+        ui_->label_progress->setEnabled(true);
+    } else {
+        ui_->progressBar->hide();
+        ui_->label_remaining->hide();
+        ui_->label_progress->hide();
+    }
+}
@@ -1,6 +1,7 @@
 #ifndef PROCESSWIDGET_HPP
 #define PROCESSWIDGET_HPP
 
+#include <QMap>
 #include <QProcess>
 #include <QString>
 #include <QStringLiteral>
@@ -13,6 +14,7 @@
 #include <list>
 #include <numeric>
 #include <optional>
+#include <utility>
 
 namespace Ui {
 class ProcessWidget;
@@ -24,7 +26,7 @@ class ProcessWidget : public QWidget {
     Q_OBJECT
 
    public:
-    explicit ProcessWidget(bool close_on_final = false, QTime batch_total_length = QTime{}, QWidget *parent = nullptr,
+    explicit ProcessWidget(bool close_on_final = false, bool shows_batch_progress = false, QWidget *parent = nullptr,
                            Qt::WindowFlags flags = Qt::WindowFlags());
     ~ProcessWidget();
     class ProgressParams {
@@ -101,7 +103,7 @@ class ProcessWidget : public QWidget {
      * @param progress_params parameters for progress bar
      */
     void start(const QString &command, const QStringList &arguments, bool is_final = true,
-               ProgressParams progress_params = ProgressParams(), QTime length = QTime());
+               ProgressParams progress_params = ProgressParams());
     /**
      * @brief if QProcess::waitForStarted() returned false, show error message
      *
@@ -130,6 +132,36 @@ class ProcessWidget : public QWidget {
      * @return QString content of stderr textarea
      */
     QString get_stderr(int index = -1);
+    /**
+     * @brief show job run by someone else. its output is given by append_job_output().
+     *
+     * @param id id of job, which is given back by cancel_requested()
+     * @param command
+     * @param arguments
+     * @param progress_params parameters for progress bar
+     */
+    void add_job(int id, const QString &command, const QStringList &arguments,
+                 ProgressParams progress_params = ProgressParams());
+    void append_job_output(int id, const QString &stdout_text, const QString &stderr_text);
+    void finish_job(int id, bool is_success);
+    /**
+     * @brief show that job is paused or resumed, by user or by preemption
+     */
+    void set_job_paused(int id, bool is_paused);
+    /**
+     * @brief show priority of job. this doesn't emit priority_change_requested().
+     */
+    void set_job_priority(int id, int priority);
+    /**
+     * @brief enable close button after every job has finished
+     */
+    void finish_batch();
+    /**
+     * @brief update batch progress bar
+     *
+     * @param ratio finished part of batch, weighted by cost of each job. between 0 and 1
+     */
+    void set_batch_progress(double ratio);
     void clear_stdout(int index = -1);
     void clear_stderr(int index = -1);
     QString program();
@@ -137,6 +169,14 @@ class ProcessWidget : public QWidget {
 
    signals:
     void finished(bool is_success);
+    /// kill button is pressed while job added by add_job() is shown
+    void cancel_requested(int id);
+    /// pause button is pressed while running job added by add_job() is shown
+    void pause_requested(int id);
+    /// resume button is pressed while paused job added by add_job() is shown
+    void resume_requested(int id);
+    /// priority is edited while job added by add_job() is shown
+    void priority_change_requested(int id, int priority);
 
    private:
     Ui::ProcessWidget *ui_;
@@ -146,8 +186,21 @@ class ProcessWidget : public QWidget {
     int current_stderr_tab_idx_ = -1;
     ProgressParams current_progress_params_;
     bool close_on_final_;
-    QTime batch_total_length_;
-    QTime length_finished_processes_ = QTime::fromMSecsSinceStartOfDay(0);
+    bool shows_batch_progress_;
+    static constexpr int BATCH_PROGRESS_RESOLUTION = 10000;
+    ProgressParams batch_progress_params_;
+    struct JobView {
+        int stdout_tab_idx;
+        int stderr_tab_idx;
+        ProgressParams progress_params;
+        int progress = -1;
+        bool is_running = true;
+        bool is_paused = false;
+        int priority = 0;
+        QString command;
+    };
+    QMap<int, JobView> jobs_;
+    QMap<int, int> job_of_stdout_tab_;
    signals:
     void start_process(const QString &command, const QStringList &arguments, QIODeviceBase::OpenMode);
     void sigkill();
@@ -157,15 +210,23 @@ class ProcessWidget : public QWidget {
     void update_stdout_();
     void update_stderr_();
     void kill_process_();
+    void toggle_pausing_job_();
+    void request_priority_change_(int priority);
     void enable_closing_();
     void disable_closing_();
     void do_close_();
     void show_error_(QProcess::ProcessError error);
+    void show_job_of_tab_(int stdout_tab_idx);
+    void show_job_controls_(const JobView &view);
 
    private:
+    std::pair<int, int> add_tabs_(const QString &command, const QStringList &arguments);
+    void show_progress_params_(ProgressParams &progress_params);
+    void append_text_(QTextEdit *textedit, const QString &text);
     QTextEdit *stdout_textedit_of_(int idx);
     QTextEdit *stderr_textedit_of_(int idx);
     void update_progress_(QStringView stdout_text, QStringView stderr_text);
+    void show_progress_(ProgressParams &progress_params, int new_value);
 };
 
 #endif  // PROCESSWIDGET_HPP
@@ -0,0 +1,98 @@
+#include "procfs.hpp"
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QString>
+#include <ciso646>
+
+namespace concat {
+namespace {
+constexpr qint64 KIB = 1024;
+/// find line such as "VmRSS:     1234 kB" and return its value in bytes
+std::optional<qint64> read_kib_field(const QString &path, const QString &field) {
+    QFile file(path);
+    if (not file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return std::nullopt;
+    }
+    static const QRegularExpression pattern(R"(^(\w+):\s+(\d+) kB$)");
+    while (not file.atEnd()) {
+        auto match = pattern.match(QString::fromLatin1(file.readLine()).trimmed());
+        if (match.hasMatch() && match.captured(1) == field) {
+            return match.captured(2).toLongLong() * KIB;
+        }
+    }
+    return std::nullopt;
+}
+/// find line such as "oom_kill 3" and return its value
+std::optional<qint64> read_count_field(const QString &path, const QString &field) {
+    QFile file(path);
+    if (not file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return std::nullopt;
+    }
+    while (not file.atEnd()) {
+        auto line = QString::fromLatin1(file.readLine()).trimmed();
+        if (line.section(' ', 0, 0) != field) {
+            continue;
+        }
+        bool ok = false;
+        auto value = line.section(' ', 1, 1).toLongLong(&ok);
+        return ok ? std::make_optional(value) : std::nullopt;
+    }
+    return std::nullopt;
+}
+}  // namespace
+std::optional<qint64> read_total_memory() { return read_kib_field("/proc/meminfo", "MemTotal"); }
+std::optional<qint64> read_resident_memory(qint64 pid) {
+    return read_kib_field(QStringLiteral("/proc/%1/status").arg(pid), "VmRSS");
+}
+std::optional<Pressure> read_pressure(const QString &resource) {
+    QFile file(QStringLiteral("/proc/pressure/%1").arg(resource));
+    if (not file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return std::nullopt;
+    }
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    static const QRegularExpression pattern(R"(^(some|full) avg10=(\d+(?:\.\d+)?) )");
+    Pressure result;
+    bool found = false;
+    while (not file.atEnd()) {
+        auto match = pattern.match(QString::fromLatin1(file.readLine()));
+        if (not match.hasMatch()) {
+            continue;
+        }
+        found = true;
+        (match.captured(1) == "some" ? result.some : result.full) = match.captured(2).toDouble();
+    }
+    if (not found) {
+        return std::nullopt;
+    }
+    return result;
+}
+std::optional<qint64> read_oom_kill_count() {
+    QFile cgroup("/proc/self/cgroup");
+    if (cgroup.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        // cgroup v2 has only one line such as "0::/user.slice/user-1000.slice/session-2.scope"
+        auto line = QString::fromLatin1(cgroup.readLine()).trimmed();
+        if (line.startsWith("0::")) {
+            auto events_path = QStringLiteral("/sys/fs/cgroup%1/memory.events").arg(line.mid(3));
+            auto count = read_count_field(events_path, "oom_kill");
+            if (count.has_value()) {
+                return count;
+            }
+        }
+    }
+    return read_count_field("/proc/vmstat", "oom_kill");
+}
+std::optional<double> read_load_average() {
+    QFile file("/proc/loadavg");
+    if (not file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return std::nullopt;
+    }
+    // 0.52 0.58 0.59 1/467 12345
+    bool ok = false;
+    auto load = QString::fromLatin1(file.readLine()).section(' ', 0, 0).toDouble(&ok);
+    if (not ok) {
+        return std::nullopt;
+    }
+    return load;
+}
+}  // namespace concat
@@ -0,0 +1,53 @@
+#ifndef VIDEO_RE_ENCODER_PROCFS
+#define VIDEO_RE_ENCODER_PROCFS
+
+#include <QString>
+#include <QtGlobal>
+#include <optional>
+
+namespace concat {
+/**
+ * @brief size of physical memory in bytes, read from /proc/meminfo
+ *
+ * @return std::nullopt if it is not available, e.g. on other than linux
+ */
+std::optional<qint64> read_total_memory();
+/**
+ * @brief resident set size of process in bytes, read from /proc/<pid>/status
+ *
+ * @return std::nullopt if it is not available, e.g. process has already exited or on other than linux
+ */
+std::optional<qint64> read_resident_memory(qint64 pid);
+/**
+ * @brief pressure stall information of a resource, in percent of time averaged over the last 10 seconds
+ */
+struct Pressure {
+    /// some tasks were stalled
+    double some = 0.0;
+    /// every non-idle task was stalled. always 0 for cpu on older kernels
+    double full = 0.0;
+};
+/**
+ * @brief pressure of resource read from /proc/pressure/<resource>
+ *
+ * @param resource "cpu", "memory" or "io"
+ * @return std::nullopt if it is not available, e.g. kernel is built without PSI or on other than linux
+ */
+std::optional<Pressure> read_pressure(const QString &resource);
+/**
+ * @brief number of processes killed by the OOM killer so far
+ * @details oom_kill of memory.events of the cgroup this process belongs to is read, which counts kills under both
+ * the limit of the cgroup and lack of system memory. /proc/vmstat is read instead if cgroup v2 is not used.
+ *
+ * @return std::nullopt if it is not available, e.g. on kernels older than 4.13 or on other than linux
+ */
+std::optional<qint64> read_oom_kill_count();
+/**
+ * @brief 1 minute load average read from /proc/loadavg
+ *
+ * @return std::nullopt if it is not available, e.g. on other than linux
+ */
+std::optional<double> read_load_average();
+}  // namespace concat
+
+#endif
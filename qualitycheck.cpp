@@ -0,0 +1,165 @@
+#include "qualitycheck.hpp"
+
+#include <QRegularExpression>
+#include <QStringList>
+#include <QThread>
+#include <QtDebug>
+#include <ciso646>
+#include <limits>
+
+namespace concat {
+namespace {
+std::optional<double> lower(std::optional<double> one, std::optional<double> the_other) {
+    if (not one.has_value()) {
+        return the_other;
+    }
+    if (not the_other.has_value()) {
+        return one;
+    }
+    return qMin(one.value(), the_other.value());
+}
+std::optional<double> last_match(const QRegularExpression &pattern, QStringView text) {
+    std::optional<double> result = std::nullopt;
+    for (const auto &match : pattern.globalMatch(text)) {
+        bool ok = false;
+        auto value = match.captured(1).toDouble(&ok);
+        if (ok) {
+            result = value;
+        }
+    }
+    return result;
+}
+}  // namespace
+QualityScores QualityScores::worst(const QualityScores &other) const {
+    return {lower(psnr, other.psnr), lower(ssim, other.ssim), lower(vmaf, other.vmaf)};
+}
+QString QualityScores::to_string() const {
+    QStringList result;
+    if (psnr.has_value()) {
+        result << QStringLiteral("PSNR %1 dB").arg(psnr.value(), 0, 'f', 2);
+    }
+    if (ssim.has_value()) {
+        result << QStringLiteral("SSIM %1").arg(ssim.value(), 0, 'f', 4);
+    }
+    if (vmaf.has_value()) {
+        result << QStringLiteral("VMAF %1").arg(vmaf.value(), 0, 'f', 2);
+    }
+    return result.join(", ");
+}
+bool QualityThresholds::is_satisfied_by(const QualityScores &scores) const {
+    return scores.psnr.value_or(min_psnr) >= min_psnr && scores.ssim.value_or(min_ssim) >= min_ssim &&
+           scores.vmaf.value_or(min_vmaf) >= min_vmaf;
+}
+QualityScores parse_quality_scores(QStringView stderr_text) {
+    // [Parsed_psnr_2 @ 0x...] PSNR y:40.1 u:44.2 v:45.0 average:41.3 min:38.0 max:45.1
+    static const QRegularExpression psnr_pattern(R"(PSNR [^\n]*average:(inf|[\d.]+))");
+    // [Parsed_ssim_3 @ 0x...] SSIM Y:0.98 (17.0) U:0.99 (20.0) V:0.99 (20.1) All:0.985 (18.2)
+    static const QRegularExpression ssim_pattern(R"(SSIM [^\n]*All:([\d.]+))");
+    // [Parsed_libvmaf_4 @ 0x...] VMAF score: 93.1
+    static const QRegularExpression vmaf_pattern(R"(VMAF score[:=]\s*([\d.]+))");
+    auto psnr = last_match(psnr_pattern, stderr_text);
+    if (not psnr.has_value() && stderr_text.contains(QStringLiteral("average:inf"))) {
+        psnr = std::numeric_limits<double>::infinity();  // identical frames
+    }
+    return {psnr, last_match(ssim_pattern, stderr_text), last_match(vmaf_pattern, stderr_text)};
+}
+QualityChecker::QualityChecker(bool uses_vmaf, QObject *parent)
+    : QObject(parent), uses_vmaf_(uses_vmaf), max_processes_(qMax(QThread::idealThreadCount() / 2, 1)) {}
+QualityChecker::~QualityChecker() {
+    for (auto it = running_.cbegin(); it != running_.cend(); ++it) {
+        it.key()->disconnect(this);
+        it.key()->kill();
+        it.key()->waitForFinished();
+    }
+}
+void QualityChecker::check(int id, const QString &source_path, const QString &output_path, QSize source_resolution,
+                           std::chrono::milliseconds length, std::optional<QRect> crop) {
+    auto windows = spread_windows(length, NUM_WINDOWS, WINDOW_DURATION);
+    checks_.insert(id, {static_cast<int>(windows.size())});
+    for (const auto &window : windows) {
+        pending_.push_back({id, source_path, output_path, source_resolution, crop, window});
+    }
+    start_next_();
+}
+void QualityChecker::set_max_processes(int max_processes) {
+    max_processes_ = qMax(max_processes, 1);
+    start_next_();
+}
+QStringList QualityChecker::arguments_of_(const Window &window) const {
+    // psnr and ssim take main (distorted) input first and reference second, and so does libvmaf since ffmpeg 5
+    QString distorted = "[0:v:0]";
+    QString reference = "[1:v:0]";
+    auto resolution = window.source_resolution;
+    // cropped output is compared with the same part of source, without black bars which were removed
+    if (window.crop.has_value() && window.crop->isValid()) {
+        reference += QStringLiteral("crop=%1:%2:%3:%4,")
+                         .arg(window.crop->width())
+                         .arg(window.crop->height())
+                         .arg(window.crop->x())
+                         .arg(window.crop->y());
+        resolution = window.crop->size();
+    }
+    if (resolution.isValid()) {
+        distorted += QStringLiteral("scale=%1:%2:flags=bicubic,").arg(resolution.width()).arg(resolution.height());
+    }
+    distorted += "settb=AVTB,setpts=PTS-STARTPTS";
+    reference += "settb=AVTB,setpts=PTS-STARTPTS";
+    auto num_metrics = uses_vmaf_ ? 3 : 2;
+    auto filter = QStringLiteral("%1,split=%3[d0][d1]%4;%2,split=%3[r0][r1]%5;[d0][r0]psnr;[d1][r1]ssim")
+                      .arg(distorted)
+                      .arg(reference)
+                      .arg(num_metrics)
+                      .arg(uses_vmaf_ ? "[d2]" : "")
+                      .arg(uses_vmaf_ ? "[r2]" : "");
+    if (uses_vmaf_) {
+        filter += ";[d2][r2]libvmaf";
+    }
+    QStringList arguments{"-hide_banner", "-nostdin"};
+    arguments << window.window.input_args() << "-i" << window.output_path;
+    arguments << window.window.input_args() << "-i" << window.source_path;
+    arguments << "-lavfi" << filter << "-an" << "-f" << "null" << "-";
+    return arguments;
+}
+void QualityChecker::start_next_() {
+    while (not pending_.isEmpty() && running_.size() < max_processes_) {
+        auto window = pending_.takeFirst();
+        auto process = new QProcess(this);
+        running_.insert(process, window.id);
+        connect(process, &QProcess::finished, this, [this, process](int exit_code, QProcess::ExitStatus exit_status) {
+            finish_(process, exit_status == QProcess::NormalExit && exit_code == 0);
+        });
+        connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                finish_(process, false);
+            }
+        });
+        process->start("ffmpeg", arguments_of_(window));
+    }
+}
+void QualityChecker::finish_(QProcess *process, bool is_success) {
+    if (not running_.contains(process)) {
+        return;
+    }
+    auto id = running_.take(process);
+    auto &check = checks_[id];
+    auto stderr_text = QString::fromUtf8(process->readAllStandardError());
+    process->deleteLater();
+    auto scores = parse_quality_scores(stderr_text);
+    if (is_success && (scores.psnr.has_value() || scores.ssim.has_value())) {
+        check.scores = check.has_scores ? check.scores.worst(scores) : scores;
+        check.has_scores = true;
+    } else {
+        qWarning() << "failed to compare window of job" << id << stderr_text.right(1000);
+        check.is_success = false;
+    }
+    check.num_remaining_windows--;
+    if (check.num_remaining_windows <= 0) {
+        auto finished = checks_.take(id);
+        emit checked(id, finished.scores, finished.is_success && finished.has_scores);
+    }
+    start_next_();
+    if (is_idle()) {
+        emit idle();
+    }
+}
+}  // namespace concat
@@ -0,0 +1,101 @@
+#ifndef VIDEO_RE_ENCODER_QUALITYCHECK
+#define VIDEO_RE_ENCODER_QUALITYCHECK
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QProcess>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QStringView>
+#include <chrono>
+#include <optional>
+
+#include "samplewindows.hpp"
+
+namespace concat {
+/**
+ * @brief objective quality of output relative to source. scores which were not measured are std::nullopt.
+ */
+struct QualityScores {
+    std::optional<double> psnr;  // average of all planes, in dB
+    std::optional<double> ssim;  // "All" value, between 0 and 1
+    std::optional<double> vmaf;  // between 0 and 100
+    /**
+     * @brief take the lower of each score
+     */
+    QualityScores worst(const QualityScores &other) const;
+    QString to_string() const;
+};
+struct QualityThresholds {
+    double min_psnr = 30.0;
+    double min_ssim = 0.9;
+    double min_vmaf = 70.0;
+    bool is_satisfied_by(const QualityScores &scores) const;
+};
+/**
+ * @brief retrieve summary printed by psnr, ssim and libvmaf filters at the end of ffmpeg run
+ */
+QualityScores parse_quality_scores(QStringView stderr_text);
+
+/**
+ * @brief compare sampled windows of output with source using psnr, ssim and optionally libvmaf filters.
+ * @details windows of all requested checks share a pool of processes, so windows of a check run in parallel.
+ * scores of a check are the worst ones among its windows, as broken output is often broken only in a part.
+ */
+class QualityChecker : public QObject {
+    Q_OBJECT
+
+   public:
+    static constexpr int NUM_WINDOWS = 4;
+    static constexpr std::chrono::seconds WINDOW_DURATION{5};
+    explicit QualityChecker(bool uses_vmaf, QObject *parent = nullptr);
+    ~QualityChecker();
+    /**
+     * @brief start checking output. checked() is emitted with id when every window is compared.
+     *
+     * @param source_resolution output is scaled to this resolution before comparison. empty means no scaling
+     * @param crop part of source kept in output. source is cropped to it, and output is scaled to its size instead
+     */
+    void check(int id, const QString &source_path, const QString &output_path, QSize source_resolution,
+               std::chrono::milliseconds length, std::optional<QRect> crop = std::nullopt);
+    void set_max_processes(int max_processes);
+    bool is_idle() const { return pending_.isEmpty() && running_.isEmpty(); }
+
+   signals:
+    void checked(int id, QualityScores scores, bool is_success);
+    /// emitted when every requested check has finished
+    void idle();
+
+   private:
+    struct Window {
+        int id;
+        QString source_path;
+        QString output_path;
+        QSize source_resolution;
+        std::optional<QRect> crop;
+        SampleWindow window;
+    };
+    struct Check {
+        int num_remaining_windows = 0;
+        QualityScores scores;
+        bool has_scores = false;
+        bool is_success = true;
+    };
+    bool uses_vmaf_;
+    int max_processes_;
+    QList<Window> pending_;
+    QHash<QProcess *, int> running_;
+    QHash<int, Check> checks_;
+
+    QStringList arguments_of_(const Window &window) const;
+    void start_next_();
+    void finish_(QProcess *process, bool is_success);
+};
+}  // namespace concat
+
+Q_DECLARE_METATYPE(concat::QualityScores);
+
+#endif
@@ -0,0 +1,92 @@
+#include "remoteworker.hpp"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QtDebug>
+#include <ciso646>
+
+#include "workerprotocol.hpp"
+
+namespace concat {
+RemoteWorker::RemoteWorker(const QString &host, quint16 port, QObject *parent)
+    : QObject(parent), host_(host), port_(port) {
+    reconnect_timer_.setInterval(RECONNECT_INTERVAL_MSEC);
+    reconnect_timer_.setSingleShot(true);
+    connect(&reconnect_timer_, &QTimer::timeout, this, &RemoteWorker::connect_);
+    connect(&socket_, &QTcpSocket::readyRead, this, &RemoteWorker::receive_);
+    connect(&socket_, &QTcpSocket::disconnected, this, &RemoteWorker::drop_);
+    connect(&socket_, &QTcpSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+        qWarning() << "connection to worker" << name() << "failed:" << socket_.errorString();
+        drop_();
+    });
+    connect_();
+}
+RemoteWorker *RemoteWorker::from_address(const QString &address, QObject *parent) {
+    auto separator = address.lastIndexOf(':');
+    if (separator < 0) {
+        return new RemoteWorker(address.trimmed(), DEFAULT_WORKER_PORT, parent);
+    }
+    bool ok = false;
+    auto port = address.mid(separator + 1).toUShort(&ok);
+    if (not ok) {
+        return nullptr;
+    }
+    return new RemoteWorker(address.left(separator).trimmed(), port, parent);
+}
+void RemoteWorker::start(int id, const EncodeJob &job) {
+    running_.insert(id);
+    socket_.write(encode_worker_message({{"type", "job"},
+                                         {"id", id},
+                                         {"arguments", QJsonArray::fromStringList(job.arguments)},
+                                         {"input_path", job.input_path},
+                                         {"output_path", job.output_path}}));
+}
+void RemoteWorker::cancel(int id) {
+    if (running_.contains(id)) {
+        socket_.write(encode_worker_message({{"type", "cancel"}, {"id", id}}));
+    }
+}
+void RemoteWorker::connect_() {
+    if (socket_.state() == QAbstractSocket::UnconnectedState) {
+        socket_.connectToHost(host_, port_);
+    }
+}
+void RemoteWorker::receive_() {
+    for (const auto &message : read_worker_messages(&socket_)) {
+        auto type = message["type"].toString();
+        auto id = message["id"].toInt();
+        if (type == "hello") {
+            if (message["version"].toInt() != WORKER_PROTOCOL_VERSION) {
+                qWarning() << "worker" << name() << "speaks unsupported protocol version" << message["version"];
+                socket_.disconnectFromHost();
+                return;
+            }
+            num_slots_ = message["slots"].toInt();
+            is_ready_ = true;
+            qInfo() << "worker" << name() << "on" << message["host"].toString() << "has" << num_slots_ << "slots";
+            emit ready();
+        } else if (type == "output") {
+            emit job_output(id, message["stdout"].toString(), message["stderr"].toString());
+        } else if (type == "finished") {
+            if (not running_.remove(id)) {
+                continue;
+            }
+            if (not message["error"].toString().isEmpty()) {
+                emit job_output(id, QString(), QStringLiteral("\n%1: %2\n").arg(name(), message["error"].toString()));
+            }
+            emit job_finished(id, message["success"].toBool());
+        }
+    }
+}
+void RemoteWorker::drop_() {
+    is_ready_ = false;
+    if (not running_.isEmpty()) {
+        auto ids = running_.values();
+        running_.clear();
+        emit jobs_lost(ids);
+    }
+    if (not reconnect_timer_.isActive()) {
+        reconnect_timer_.start();
+    }
+}
+}  // namespace concat
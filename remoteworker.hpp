@@ -0,0 +1,64 @@
+#ifndef VIDEO_RE_ENCODER_REMOTEWORKER
+#define VIDEO_RE_ENCODER_REMOTEWORKER
+
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "encodescheduler.hpp"
+
+namespace concat {
+/**
+ * @brief connection to a worker daemon (videos_re_encoder_worker), which runs jobs given by EncodeScheduler
+ * @details connection is retried periodically while it is lost. see workerprotocol.hpp for messages.
+ */
+class RemoteWorker : public QObject {
+    Q_OBJECT
+
+   public:
+    RemoteWorker(const QString &host, quint16 port, QObject *parent = nullptr);
+    /**
+     * @brief parse "host" or "host:port"
+     */
+    static RemoteWorker *from_address(const QString &address, QObject *parent = nullptr);
+    QString name() const { return QStringLiteral("%1:%2").arg(host_).arg(port_); }
+    /**
+     * @brief number of jobs worker runs at the same time. 0 until connected
+     */
+    int num_slots() const { return is_ready_ ? num_slots_ : 0; }
+    int num_running() const { return static_cast<int>(running_.size()); }
+    bool has_free_slot() const { return num_running() < num_slots(); }
+    /**
+     * @brief send job. only arguments and paths are sent, and worker runs its own ffmpeg.
+     */
+    void start(int id, const EncodeJob &job);
+    void cancel(int id);
+
+   signals:
+    void job_output(int id, QString stdout_text, QString stderr_text);
+    void job_finished(int id, bool is_success);
+    /// connection is lost. jobs which were running are not going to be finished
+    void jobs_lost(QList<int> ids);
+    /// worker became ready to accept jobs
+    void ready();
+
+   private:
+    static constexpr int RECONNECT_INTERVAL_MSEC = 10000;
+    QString host_;
+    quint16 port_;
+    QTcpSocket socket_;
+    QTimer reconnect_timer_;
+    int num_slots_ = 0;
+    bool is_ready_ = false;
+    QSet<int> running_;
+
+    void connect_();
+    void receive_();
+    void drop_();
+};
+}  // namespace concat
+
+#endif
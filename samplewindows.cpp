@@ -0,0 +1,28 @@
+#include "samplewindows.hpp"
+
+#include <QString>
+
+namespace concat {
+namespace {
+QString to_seconds(std::chrono::milliseconds time) {
+    return QString::number(std::chrono::duration<double>(time).count(), 'f', 3);
+}
+}  // namespace
+QStringList SampleWindow::input_args() const { return {"-ss", to_seconds(start), "-t", to_seconds(duration)}; }
+QList<SampleWindow> spread_windows(std::chrono::milliseconds length, int num_windows,
+                                   std::chrono::milliseconds window_duration) {
+    if (length.count() <= 0) {
+        return {{std::chrono::milliseconds(0), window_duration}};
+    }
+    num_windows = qMax(num_windows, 1);
+    if (length <= window_duration * num_windows) {
+        return {{std::chrono::milliseconds(0), length}};
+    }
+    QList<SampleWindow> result;
+    auto part = length / num_windows;
+    for (auto i = 0; i < num_windows; i++) {
+        result.push_back({part * i + (part - window_duration) / 2, window_duration});
+    }
+    return result;
+}
+}  // namespace concat
@@ -0,0 +1,29 @@
+#ifndef VIDEO_RE_ENCODER_SAMPLEWINDOWS
+#define VIDEO_RE_ENCODER_SAMPLEWINDOWS
+
+#include <QList>
+#include <QStringList>
+#include <chrono>
+
+namespace concat {
+struct SampleWindow {
+    std::chrono::milliseconds start;
+    std::chrono::milliseconds duration;
+    /**
+     * @brief ffmpeg input options which select this window of the following input by input seeking
+     */
+    QStringList input_args() const;
+};
+/**
+ * @brief windows spread evenly across a video, each in the middle of its own equal part
+ * @details if video is shorter than windows in total, a single window covering whole video is returned.
+ *
+ * @param length length of video. 0 means unknown, and a window from the beginning is returned
+ * @param num_windows
+ * @param window_duration
+ */
+QList<SampleWindow> spread_windows(std::chrono::milliseconds length, int num_windows,
+                                   std::chrono::milliseconds window_duration);
+}  // namespace concat
+
+#endif
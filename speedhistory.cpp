@@ -0,0 +1,127 @@
+#include "speedhistory.hpp"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QtDebug>
+#include <ciso646>
+
+namespace concat {
+namespace {
+QJsonObject to_json(int num_samples, double value) {
+    return {{"num_samples", num_samples}, {"value", value}};
+}
+}  // namespace
+QString SpeedHistory::Key::to_string() const {
+    return QStringList{QStringLiteral("%1x%2").arg(source_resolution.width()).arg(source_resolution.height()),
+                       source_codec, target_codec, preset, host}
+        .join('|');
+}
+void SpeedHistory::Stats::add(double sample) {
+    num_samples++;
+    auto weight = 1.0 / qMin(num_samples, MAX_AVERAGED_SAMPLES);
+    value += (sample - value) * weight;
+}
+SpeedHistory::SpeedHistory(const QString &path) : path_(path) { load_(); }
+void SpeedHistory::record(const Key &key, std::chrono::milliseconds length, double frames, double cost,
+                          std::chrono::milliseconds wall_time, qint64 output_size) {
+    if (wall_time.count() <= 0 || length.count() <= 0) {
+        return;
+    }
+    auto wall_seconds = std::chrono::duration<double>(wall_time).count();
+    auto seconds = std::chrono::duration<double>(length).count();
+    auto &speed = speeds_[key.to_string()];
+    speed.realtime_factor.add(seconds / wall_seconds);
+    speed.frames_per_second.add(frames / wall_seconds);
+    if (output_size > 0) {
+        speed.output_bitrate.add(static_cast<double>(output_size) * 8.0 / seconds);
+    }
+    if (cost > 0.0) {
+        seconds_per_cost_of_host_[key.host].add(wall_seconds / cost);
+    }
+    save_();
+}
+SpeedHistory::Prediction SpeedHistory::predict(const Key &key, std::chrono::milliseconds length, double cost) const {
+    using std::chrono::duration_cast, std::chrono::milliseconds, std::chrono::duration;
+    auto speed = speeds_.find(key.to_string());
+    if (speed != speeds_.end() && speed->realtime_factor.value > 0.0) {
+        return {duration_cast<milliseconds>(duration<double>(length) / speed->realtime_factor.value),
+                speed->realtime_factor.num_samples};
+    }
+    auto seconds_per_cost = seconds_per_cost_of_host_.find(key.host);
+    if (seconds_per_cost != seconds_per_cost_of_host_.end()) {
+        return {duration_cast<milliseconds>(duration<double>(cost * seconds_per_cost->value)),
+                seconds_per_cost->num_samples};
+    }
+    return {duration_cast<milliseconds>(duration<double>(cost)), 0};
+}
+std::optional<double> SpeedHistory::frames_per_second(const Key &key) const {
+    auto speed = speeds_.find(key.to_string());
+    if (speed == speeds_.end()) {
+        return std::nullopt;
+    }
+    return speed->frames_per_second.value;
+}
+std::optional<double> SpeedHistory::output_bitrate(const Key &key) const {
+    auto speed = speeds_.find(key.to_string());
+    if (speed == speeds_.end() || speed->output_bitrate.num_samples == 0) {
+        return std::nullopt;
+    }
+    return speed->output_bitrate.value;
+}
+void SpeedHistory::load_() {
+    if (path_.isEmpty() || not QFile::exists(path_)) {
+        return;
+    }
+    QFile file(path_);
+    if (not file.open(QIODevice::ReadOnly)) {
+        qWarning() << "failed to open" << path_;
+        return;
+    }
+    QJsonParseError err;
+    auto document = QJsonDocument::fromJson(file.readAll(), &err);
+    if (document.isNull() || document["VERSION"].toInt() != VERSION) {
+        qWarning() << "failed to parse" << path_ << err.errorString();
+        return;
+    }
+    auto from_json = [](const QJsonValue &value) {
+        return Stats{value["num_samples"].toInt(), value["value"].toDouble()};
+    };
+    auto speeds = document["speeds"].toObject();
+    for (auto it = speeds.constBegin(); it != speeds.constEnd(); ++it) {
+        speeds_.insert(it.key(), {from_json(it.value()["realtime_factor"]), from_json(it.value()["fps"]),
+                                  from_json(it.value()["bitrate"])});
+    }
+    auto hosts = document["seconds_per_cost"].toObject();
+    for (auto it = hosts.constBegin(); it != hosts.constEnd(); ++it) {
+        seconds_per_cost_of_host_.insert(it.key(), from_json(it.value()));
+    }
+}
+void SpeedHistory::save_() const {
+    if (path_.isEmpty()) {
+        return;
+    }
+    QJsonObject speeds;
+    for (auto it = speeds_.constBegin(); it != speeds_.constEnd(); ++it) {
+        const auto &speed = it.value();
+        speeds.insert(it.key(), QJsonObject{{"realtime_factor", to_json(speed.realtime_factor.num_samples,
+                                                                        speed.realtime_factor.value)},
+                                            {"fps", to_json(speed.frames_per_second.num_samples,
+                                                            speed.frames_per_second.value)},
+                                            {"bitrate", to_json(speed.output_bitrate.num_samples,
+                                                                speed.output_bitrate.value)}});
+    }
+    QJsonObject hosts;
+    for (auto it = seconds_per_cost_of_host_.constBegin(); it != seconds_per_cost_of_host_.constEnd(); ++it) {
+        hosts.insert(it.key(), to_json(it->num_samples, it->value));
+    }
+    QFile file(path_);
+    if (not file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "failed to write" << path_;
+        return;
+    }
+    file.write(
+        QJsonDocument(QJsonObject{{"VERSION", VERSION}, {"speeds", speeds}, {"seconds_per_cost", hosts}}).toJson());
+}
+}  // namespace concat
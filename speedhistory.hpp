@@ -0,0 +1,80 @@
+#ifndef VIDEO_RE_ENCODER_SPEEDHISTORY
+#define VIDEO_RE_ENCODER_SPEEDHISTORY
+
+#include <QHash>
+#include <QSize>
+#include <QString>
+#include <chrono>
+#include <optional>
+
+namespace concat {
+/**
+ * @brief encode speed observed in finished jobs, used to predict duration of jobs before they start
+ */
+class SpeedHistory {
+   public:
+    static constexpr int VERSION = 1;
+    struct Key {
+        QSize source_resolution;
+        QString source_codec;
+        QString target_codec;
+        QString preset;
+        QString host;
+        QString to_string() const;
+    };
+    struct Prediction {
+        std::chrono::milliseconds duration;
+        /// number of finished jobs prediction is based on. 0 means prediction is made only from estimated cost
+        int num_samples;
+    };
+    /**
+     * @brief load history from path. empty history is created if path doesn't exist.
+     */
+    explicit SpeedHistory(const QString &path = QString());
+    /**
+     * @brief record finished job and save history to file
+     *
+     * @param key
+     * @param length length of source
+     * @param frames number of encoded frames
+     * @param cost estimated cost of job. see estimate_cost()
+     * @param wall_time time taken to encode
+     * @param output_size size of output in bytes. 0 means unknown
+     */
+    void record(const Key &key, std::chrono::milliseconds length, double frames, double cost,
+                std::chrono::milliseconds wall_time, qint64 output_size = 0);
+    /**
+     * @brief predict time taken to encode
+     * @details speed of jobs with the same key is used if any. otherwise cost is converted to time with the ratio
+     * observed on the same host.
+     */
+    Prediction predict(const Key &key, std::chrono::milliseconds length, double cost) const;
+    std::optional<double> frames_per_second(const Key &key) const;
+    /**
+     * @brief bitrate of whole output in bits per second, which reflects CRF and other settings of preset in key
+     */
+    std::optional<double> output_bitrate(const Key &key) const;
+
+   private:
+    struct Stats {
+        int num_samples = 0;
+        double value = 0.0;
+        /// exponential moving average which equals to simple average while there are few samples
+        void add(double sample);
+    };
+    struct Speed {
+        Stats realtime_factor;
+        Stats frames_per_second;
+        Stats output_bitrate;
+    };
+    static constexpr int MAX_AVERAGED_SAMPLES = 10;
+    QString path_;
+    QHash<QString, Speed> speeds_;
+    QHash<QString, Stats> seconds_per_cost_of_host_;
+
+    void load_();
+    void save_() const;
+};
+}  // namespace concat
+
+#endif
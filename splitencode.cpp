@@ -0,0 +1,67 @@
+#include "splitencode.hpp"
+
+#include <ciso646>
+#include <variant>
+
+#include "encodecost.hpp"
+
+namespace concat {
+bool is_worth_splitting(const VideoInfo &source_info, const TranscodePlan &plan) {
+    auto source_audio_codec = std::get_if<QString>(&source_info.audio_codec);
+    return plan.audio_is_encoded && source_audio_codec != nullptr && not source_audio_codec->isEmpty();
+}
+SplitPlan plan_split_encode(const EncodeJob &job, const VideoInfo &source_info, const VideoInfo &output_info,
+                            const TranscodePlan &plan, const TranscodeOptions &options, const QDir &work_dir) {
+    SplitPlan result;
+    EncodeJob stream;
+    stream.program = job.program;
+    stream.input_path = job.input_path;
+    stream.length = job.length;
+    stream.priority = job.priority;
+    // matroska takes any codec, and keeps timestamps which raw elementary streams would lose
+    auto video_path = work_dir.filePath("video.mkv");
+    auto audio_path = work_dir.filePath("audio.mka");
+
+    auto audio_info = VideoInfo();
+    audio_info.audio_codec = output_info.audio_codec;
+    auto audio = stream;
+    auto audio_plan = plan;
+    audio_plan.video_codec = "copy";
+    audio_plan.video_filters.clear();
+    audio_plan.fps_mode.clear();
+    audio.arguments = audio_plan.arguments(job.input_path, output_info)
+                      << "-copyts" << "-vn" << "-sn" << "-dn" << "-n" << audio_path;
+    audio.output_path = audio_path;
+    // video is copied, so options such as crop don't apply
+    audio.cost = estimate_cost(source_info, audio_info, job.length);
+    audio.memory = estimate_memory(source_info, audio_info);
+
+    result.mux = stream;
+    result.mux.arguments << "-copyts";
+    if (plan.video_is_encoded) {
+        auto video_info = output_info;
+        video_info.audio_codec = VideoInfo().audio_codec;
+        auto video = stream;
+        video.arguments = plan.arguments(job.input_path, output_info)
+                          << "-copyts" << "-an" << "-sn" << "-dn" << "-n" << video_path;
+        video.output_path = video_path;
+        video.cost = estimate_cost(source_info, video_info, job.length, options);
+        video.memory = job.memory;
+        video.predicted_duration = job.predicted_duration;
+        video.max_concurrent_jobs = job.max_concurrent_jobs;
+        result.streams << video;
+        result.mux.arguments << "-i" << video_path;
+    } else {
+        result.mux.arguments << output_info.input_file_args << "-i" << job.input_path;
+    }
+    result.streams << audio;
+    result.mux.arguments << "-i" << audio_path << "-map" << "0:v:0" << "-map" << "1:a:0" << "-c" << "copy";
+    // output starts at zero as one written by a single process does, even if source has nonzero start time
+    result.mux.arguments << "-avoid_negative_ts" << "make_zero";
+    result.mux.arguments << "-n" << job.output_path;
+    result.mux.output_path = job.output_path;
+    result.mux.cost = estimate_cost(VideoInfo(), VideoInfo(), job.length);  // stream copy
+    result.mux.output_size = job.output_size;
+    return result;
+}
+}  // namespace concat
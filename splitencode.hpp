@@ -0,0 +1,50 @@
+#ifndef VIDEO_RE_ENCODER_SPLITENCODE
+#define VIDEO_RE_ENCODER_SPLITENCODE
+
+#include <QDir>
+#include <QList>
+#include <QString>
+
+#include "encodescheduler.hpp"
+#include "transcodeplan.hpp"
+#include "videoinfo.hpp"
+
+namespace concat {
+/**
+ * @brief encode whose audio and video are written by separate processes and muxed afterwards
+ * @details in one process, a heavy audio encoder such as loudness normalized opus runs in a single thread beside the
+ * video encoder and can limit speed of the whole encode. split encode writes each stream to scratch file of its own
+ * by concurrent jobs, then stream-copies them into output.
+ * every job keeps timestamps of source by -copyts, so that streams written separately stay in sync when muxed. the mux
+ * shifts them to start at zero.
+ * copied video is not written to scratch at all, and the mux takes it from source.
+ */
+struct SplitPlan {
+    /// jobs writing streams to scratch files. they can run concurrently. encoded video comes first
+    QList<EncodeJob> streams;
+    /// job muxing scratch files into output, which is enqueued after every stream is written
+    EncodeJob mux;
+};
+/**
+ * @brief whether splitting job pays off, which is when source has audio and it is encoded
+ *
+ * @param source_info info of input
+ * @param plan plan of job encoding both streams
+ */
+bool is_worth_splitting(const VideoInfo &source_info, const TranscodePlan &plan);
+/**
+ * @brief split job writing one output into jobs of each stream and one muxing them
+ *
+ * @param job job encoding both streams, such as one created for a file of the list. its estimates are shared between
+ * jobs of the plan. its thread options are not kept, so threads are tuned on the video job of the plan
+ * @param source_info info of input
+ * @param output_info info of output, whose input_file_args and encoding_args are given to every encoding job
+ * @param plan plan of job
+ * @param options options of transcode which plan was made with
+ * @param work_dir directory where scratch files are written
+ */
+SplitPlan plan_split_encode(const EncodeJob &job, const VideoInfo &source_info, const VideoInfo &output_info,
+                            const TranscodePlan &plan, const TranscodeOptions &options, const QDir &work_dir);
+}  // namespace concat
+
+#endif
@@ -0,0 +1,163 @@
+#include "statusserver.hpp"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QLocalSocket>
+#include <QtDebug>
+#include <ciso646>
+
+#include "encodescheduler.hpp"
+#include "procfs.hpp"
+#include "workerprotocol.hpp"
+
+namespace concat {
+namespace {
+QString state_name(EncodeScheduler::JobState state) {
+    switch (state) {
+        case EncodeScheduler::JobState::queued:
+            return "queued";
+        case EncodeScheduler::JobState::running:
+            return "running";
+        case EncodeScheduler::JobState::paused:
+            return "paused";
+        case EncodeScheduler::JobState::finished:
+            return "finished";
+        case EncodeScheduler::JobState::failed:
+            return "failed";
+        case EncodeScheduler::JobState::canceled:
+            return "canceled";
+    }
+    return QString();
+}
+QJsonObject error(const QString &message) { return {{"type", "error"}, {"error", message}}; }
+}  // namespace
+StatusServer::StatusServer(EncodeScheduler *scheduler, QObject *parent) : QObject(parent), scheduler_(scheduler) {
+    server_.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&server_, &QLocalServer::newConnection, this, &StatusServer::accept_);
+}
+StatusServer::~StatusServer() { close(); }
+bool StatusServer::listen(const QString &name) {
+    close();
+    QLocalServer::removeServer(name);
+    return server_.listen(name);
+}
+void StatusServer::close() {
+    if (server_.isListening()) {
+        server_.close();
+    }
+}
+QString StatusServer::default_name() {
+    return QStringLiteral("videos_re_encoder-%1").arg(QCoreApplication::applicationPid());
+}
+void StatusServer::accept_() {
+    while (server_.hasPendingConnections()) {
+        auto client = server_.nextPendingConnection();
+        connect(client, &QLocalSocket::readyRead, this, [this, client] { receive_(client); });
+        connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+    }
+}
+void StatusServer::receive_(QLocalSocket *client) {
+    for (const auto &message : read_worker_messages(client)) {
+        client->write(encode_worker_message(handle_(message)));
+    }
+}
+QJsonObject StatusServer::handle_(const QJsonObject &message) {
+    if (scheduler_.isNull()) {
+        return error(tr("scheduler is gone"));
+    }
+    auto type = message["type"].toString();
+    if (type == "status") {
+        return status();
+    }
+    auto id = message["id"].toInt(-1);
+    if (not scheduler_->contains(id)) {
+        return error(tr("no job with id %1").arg(id));
+    }
+    if (type == "pause") {
+        if (not EncodeScheduler::can_pause()) {
+            return error(tr("jobs can't be paused on this platform"));
+        }
+        emit pause_requested(id);
+    } else if (type == "resume") {
+        emit resume_requested(id);
+    } else if (type == "cancel") {
+        emit cancel_requested(id);
+    } else if (type == "priority") {
+        if (not message["priority"].isDouble()) {
+            return error(tr("priority is missing"));
+        }
+        emit priority_change_requested(id, message["priority"].toInt());
+    } else {
+        return error(tr("unknown request %1").arg(type));
+    }
+    return {{"type", "ok"}};
+}
+QJsonObject StatusServer::status() const {
+    QJsonObject result{{"type", "status"},
+                       {"version", STATUS_PROTOCOL_VERSION},
+                       {"pid", QCoreApplication::applicationPid()}};
+    if (scheduler_.isNull()) {
+        return result;
+    }
+    QJsonArray jobs;
+    for (auto id : scheduler_->job_ids()) {
+        jobs.push_back(job_status_(id));
+    }
+    result.insert("jobs", jobs);
+    result.insert("queued", scheduler_->num_queued());
+    result.insert("held", scheduler_->num_held());
+    result.insert("running", scheduler_->num_running());
+    result.insert("paused", scheduler_->num_paused());
+    result.insert("max_concurrent_jobs", scheduler_->current_max_concurrent_jobs());
+    auto total_cost = scheduler_->batch_total_cost();
+    result.insert("batch_progress", total_cost > 0.0 ? scheduler_->batch_finished_cost() / total_cost : 0.0);
+    QJsonObject resources{{"memory_budget", scheduler_->memory_budget()},
+                          {"reserved_memory", scheduler_->reserved_memory()}};
+    for (const auto &resource : {QStringLiteral("cpu"), QStringLiteral("memory"), QStringLiteral("io")}) {
+        auto pressure = read_pressure(resource);
+        if (pressure.has_value()) {
+            resources.insert(resource + "_pressure", pressure->some);
+        }
+    }
+    auto load_average = read_load_average();
+    if (load_average.has_value()) {
+        resources.insert("load_average", load_average.value());
+    }
+    result.insert("resources", resources);
+    return result;
+}
+QJsonObject StatusServer::job_status_(int id) const {
+    const auto &job = scheduler_->job(id);
+    auto state = scheduler_->state(id);
+    auto processed = scheduler_->processed_length(id);
+    auto elapsed = scheduler_->elapsed_time(id);
+    QJsonObject result{{"id", id},
+                       {"state", state_name(state)},
+                       {"held", scheduler_->is_held(id)},
+                       {"remote", state == EncodeScheduler::JobState::running && scheduler_->is_remote(id)},
+                       {"input", job.input_path},
+                       {"output", job.output_path},
+                       {"priority", job.priority},
+                       {"length_ms", static_cast<qint64>(job.length.count())},
+                       {"processed_ms", static_cast<qint64>(processed.count())},
+                       {"elapsed_ms", static_cast<qint64>(elapsed.count())},
+                       {"estimated_memory", job.memory},
+                       {"peak_resident_memory", scheduler_->resident_memory(id)}};
+    if (job.length.count() > 0) {
+        result.insert("progress", qMin(1.0, static_cast<double>(processed.count()) / job.length.count()));
+    }
+    // speed is relative to playback, as ffmpeg reports it
+    if (processed.count() > 0 && elapsed.count() > 0) {
+        auto speed = static_cast<double>(processed.count()) / elapsed.count();
+        result.insert("speed", speed);
+        if (state == EncodeScheduler::JobState::running || state == EncodeScheduler::JobState::paused) {
+            auto remaining = qMax<qint64>(job.length.count() - processed.count(), 0);
+            result.insert("eta_ms", static_cast<qint64>(remaining / speed));
+        }
+    }
+    if (job.predicted_duration.count() > 0) {
+        result.insert("predicted_ms", static_cast<qint64>(job.predicted_duration.count()));
+    }
+    return result;
+}
+}  // namespace concat
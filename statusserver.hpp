@@ -0,0 +1,80 @@
+#ifndef VIDEO_RE_ENCODER_STATUSSERVER
+#define VIDEO_RE_ENCODER_STATUSSERVER
+
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+class QLocalSocket;
+
+/**
+ * @file
+ * @brief local endpoint which tools poll and steer running batch through
+ * @details messages are framed like those of workerprotocol.hpp: each one is a compact json object terminated by a
+ * newline, and a field "type" tells kind of message. every request is answered by one message.
+ *
+ * client to server:
+ * - `{"type": "status"}`
+ * - `{"type": "pause", "id": 3}`, `{"type": "resume", "id": 3}` and `{"type": "cancel", "id": 3}`
+ * - `{"type": "priority", "id": 3, "priority": 2}`
+ *
+ * server to client:
+ * - `{"type": "status", "version": 1, "pid": ..., "jobs": [...], "queued": 2, ...}` see StatusServer::status()
+ * - `{"type": "ok"}` command is accepted
+ * - `{"type": "error", "error": "..."}`
+ */
+namespace concat {
+class EncodeScheduler;
+constexpr int STATUS_PROTOCOL_VERSION = 1;
+/**
+ * @brief serve state of EncodeScheduler as json over local socket, and accept commands to its jobs
+ * @details on unix the socket is created in temporary directory and is accessible only by the user, so that it
+ * doesn't need authentication. commands are emitted as signals named after those of ProcessWidget, so that they are
+ * handled in the same way as buttons of it.
+ */
+class StatusServer : public QObject {
+    Q_OBJECT
+
+   public:
+    explicit StatusServer(EncodeScheduler *scheduler, QObject *parent = nullptr);
+    ~StatusServer();
+    /**
+     * @brief listen on name. stale socket left by crashed process is removed.
+     */
+    bool listen(const QString &name);
+    void close();
+    bool is_listening() const { return server_.isListening(); }
+    QString error_string() const { return server_.errorString(); }
+    /**
+     * @brief path of socket, which clients connect to
+     */
+    QString full_server_name() const { return server_.fullServerName(); }
+    /**
+     * @brief queue state, progress, speed and eta of each job, and resource usage
+     */
+    QJsonObject status() const;
+    /**
+     * @brief default name of socket, which is unique per process so that several batches can be served at once
+     */
+    static QString default_name();
+
+   signals:
+    void cancel_requested(int id);
+    void pause_requested(int id);
+    void resume_requested(int id);
+    void priority_change_requested(int id, int priority);
+
+   private:
+    QPointer<EncodeScheduler> scheduler_;
+    QLocalServer server_;
+
+    void accept_();
+    void receive_(QLocalSocket *client);
+    QJsonObject handle_(const QJsonObject &message);
+    QJsonObject job_status_(int id) const;
+};
+}  // namespace concat
+
+#endif
@@ -0,0 +1,129 @@
+#include "thumbnailcache.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QtDebug>
+#include <algorithm>
+#include <ciso646>
+#include <numeric>
+#include <utility>
+
+namespace concat {
+ThumbnailCache::ThumbnailCache(const QString &dir, qint64 max_size, ProcessRunner *runner, QObject *parent)
+    : QObject(parent), dir_(dir), max_size_(max_size), runner_(runner) {
+    if (not QDir().mkpath(dir_.absolutePath())) {
+        qWarning() << "failed to create thumbnail cache directory" << dir_.absolutePath();
+    }
+}
+ThumbnailCache::~ThumbnailCache() {
+    // callbacks of canceled commands are called from cancel(). they must neither start pending ones nor touch running_
+    pending_.clear();
+    auto running = std::exchange(running_, {});
+    for (auto it = running.cbegin(); not runner_.isNull() && it != running.cend(); ++it) {
+        runner_->cancel(it.key());
+    }
+}
+void ThumbnailCache::request(const QString &path, std::chrono::milliseconds length) {
+    auto cache_path = cache_path_of_(path);
+    if (QFile::exists(cache_path)) {
+        QImage image(cache_path);
+        if (not image.isNull()) {
+            QFile file(cache_path);
+            if (file.open(QIODevice::ReadWrite)) {
+                file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);  // for LRU
+            }
+            emit thumbnail_ready(path, image);
+            return;
+        }
+    }
+    bool is_requested = std::any_of(pending_.cbegin(), pending_.cend(),
+                                    [&path](const Request &pending) { return pending.path == path; }) ||
+                        running_.values().contains(path);
+    if (is_requested) {
+        return;
+    }
+    pending_.push_back({path, length});
+    start_next_();
+}
+void ThumbnailCache::cancel_pending() { pending_.clear(); }
+void ThumbnailCache::set_max_size(qint64 max_size) {
+    max_size_ = max_size;
+    evict_();
+}
+QString ThumbnailCache::cache_path_of_(const QString &path) const {
+    // contents of file at the same path may change, so size and mtime are part of key
+    QFileInfo info(path);
+    auto key = QStringLiteral("%1|%2|%3")
+                   .arg(info.absoluteFilePath())
+                   .arg(info.size())
+                   .arg(info.lastModified().toMSecsSinceEpoch());
+    auto hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return dir_.filePath(QString::fromLatin1(hash) + ".jpg");
+}
+void ThumbnailCache::start_next_() {
+    while (not pending_.isEmpty() && running_.size() < MAX_CONCURRENT_PROCESSES) {
+        auto request = pending_.takeFirst();
+        auto seconds = std::chrono::duration<double>(request.length).count();
+        auto num_thumbnails = seconds > 0.0 ? NUM_THUMBNAILS : 1;
+        QStringList arguments{"-hide_banner", "-nostdin", "-loglevel", "error"};
+        QString filter;
+        for (auto i = 0; i < num_thumbnails; i++) {
+            // input seeking jumps to a keyframe, and only keyframes are decoded after it
+            auto position = seconds * (i + 0.5) / num_thumbnails;
+            arguments << "-skip_frame" << "nokey" << "-ss" << QString::number(position, 'f', 3) << "-i" << request.path;
+            filter += QStringLiteral("[%1:v:0]scale=-2:%2,setsar=1[t%1];").arg(i).arg(THUMBNAIL_HEIGHT);
+        }
+        for (auto i = 0; i < num_thumbnails; i++) {
+            filter += QStringLiteral("[t%1]").arg(i);
+        }
+        filter += num_thumbnails > 1 ? QStringLiteral("hstack=inputs=%1").arg(num_thumbnails) : QStringLiteral("null");
+        arguments << "-filter_complex" << filter << "-frames:v" << "1" << "-q:v" << QString::number(THUMBNAIL_QUALITY)
+                  << "-y" << cache_path_of_(request.path);
+        auto id = runner_->run(
+            "ffmpeg", arguments, [this, path = request.path](const ProcessResult &result) { finish_(path, result); },
+            RUNNER_PRIORITY);
+        running_.insert(id, request.path);
+    }
+}
+void ThumbnailCache::finish_(const QString &path, const ProcessResult &result) {
+    running_.remove(running_.key(path));
+    auto cache_path = cache_path_of_(path);
+    if (result.is_success) {
+        QImage image(cache_path);
+        if (not image.isNull()) {
+            emit thumbnail_ready(path, image);
+        }
+        if (total_size_.has_value()) {
+            *total_size_ += QFileInfo(cache_path).size();
+        }
+        evict_();
+    } else {
+        qWarning() << "failed to generate thumbnails of" << path << result.stderr_text << result.error;
+        QFile::remove(cache_path);
+    }
+    start_next_();
+}
+void ThumbnailCache::evict_() {
+    if (total_size_.has_value() && total_size_.value() <= max_size_) {
+        return;
+    }
+    auto entries = dir_.entryInfoList({"*.jpg"}, QDir::Files, QDir::Time | QDir::Reversed);  // oldest first
+    auto total_size = std::accumulate(entries.cbegin(), entries.cend(), qint64(0),
+                                      [](qint64 sum, const QFileInfo &entry) { return sum + entry.size(); });
+    if (total_size > max_size_) {
+        auto target_size = static_cast<qint64>(static_cast<double>(max_size_) * EVICTION_TARGET_RATIO);
+        for (const auto &entry : entries) {
+            if (total_size <= target_size) {
+                break;
+            }
+            if (QFile::remove(entry.absoluteFilePath())) {
+                total_size -= entry.size();
+            }
+        }
+    }
+    total_size_ = total_size;
+}
+}  // namespace concat
@@ -0,0 +1,75 @@
+#ifndef VIDEO_RE_ENCODER_THUMBNAILCACHE
+#define VIDEO_RE_ENCODER_THUMBNAILCACHE
+
+#include <QDir>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <chrono>
+#include <optional>
+
+#include "processrunner.hpp"
+
+namespace concat {
+/**
+ * @brief generate strips of thumbnails of videos in background and keep them in a size-bounded directory.
+ * @details only keyframes are decoded (`-skip_frame nokey`) at a few positions seeked by input seeking, so that
+ * generating a strip is cheap even for long or high resolution videos. least recently used strips are removed when
+ * total size of cache exceeds its limit, down to EVICTION_TARGET_RATIO of it so that the directory is listed only
+ * once in a while. commands are run by shared ProcessRunner with low priority, so that probing of
+ * imported files is not delayed by thumbnails.
+ */
+class ThumbnailCache : public QObject {
+    Q_OBJECT
+
+   public:
+    static constexpr int NUM_THUMBNAILS = 4;
+    static constexpr int THUMBNAIL_HEIGHT = 54;
+    ThumbnailCache(const QString &dir, qint64 max_size, ProcessRunner *runner, QObject *parent = nullptr);
+    ~ThumbnailCache();
+    /**
+     * @brief request strip of video. thumbnail_ready() is emitted when it is ready, immediately if it is cached.
+     *
+     * @param path path of video
+     * @param length length of video, used to spread thumbnails. 0 means unknown
+     */
+    void request(const QString &path, std::chrono::milliseconds length);
+    /**
+     * @brief forget requests which are not started yet
+     */
+    void cancel_pending();
+    void set_max_size(qint64 max_size);
+    qint64 max_size() const { return max_size_; }
+
+   signals:
+    void thumbnail_ready(QString path, QImage image);
+
+   private:
+    struct Request {
+        QString path;
+        std::chrono::milliseconds length;
+    };
+    static constexpr int MAX_CONCURRENT_PROCESSES = 1;  // keep import and encodes fast
+    static constexpr int THUMBNAIL_QUALITY = 5;         // -q:v of mjpeg. 2 is the best
+    static constexpr int RUNNER_PRIORITY = -1;
+    static constexpr double EVICTION_TARGET_RATIO = 0.9;
+    QDir dir_;
+    qint64 max_size_;
+    QPointer<ProcessRunner> runner_;
+    QList<Request> pending_;
+    /// id of command of runner -> path of video
+    QHash<int, QString> running_;
+    /// running total of size of strips, counted by listing directory when it's needed first
+    std::optional<qint64> total_size_;
+
+    QString cache_path_of_(const QString &path) const;
+    void start_next_();
+    void finish_(const QString &path, const ProcessResult &result);
+    void evict_();
+};
+}  // namespace concat
+
+#endif
@@ -25,4 +25,18 @@ QTime TimeDialog::get_time(QWidget *parent, const QString &title, const QString
             break;
     }
     return result;
-}
\ No newline at end of file
+}
+QTime TimeDialog::get_position(QWidget *parent, const QString &title, const QString &label, const QTime position,
+                               const QTime length, bool *ok) {
+    TimeDialog dialog(parent);
+    dialog.setWindowTitle(title);
+    dialog.ui_->label->setText(label);
+    dialog.ui_->timeEdit->setDisplayFormat("HH:mm:ss.zzz");
+    dialog.ui_->timeEdit->setTimeRange(QTime(0, 0), length);
+    dialog.ui_->timeEdit->setTime(position);
+    auto is_accepted = dialog.exec() == QDialog::Accepted;
+    if (ok != nullptr) {
+        *ok = is_accepted;
+    }
+    return is_accepted ? dialog.ui_->timeEdit->time() : QTime();
+}
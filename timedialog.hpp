@@ -18,6 +18,13 @@ class TimeDialog : public QDialog {
     static QTime get_time(QWidget *parent, const QString &title, const QString &label, const QTime time,
                           bool *ok = nullptr, Qt::WindowFlags flags = Qt::WindowFlags(),
                           Qt::InputMethodHints input_method_hints = Qt::ImhNone);
+    /**
+     * @brief pick a position in video, down to milliseconds
+     *
+     * @param length length of video, which is the maximum position
+     */
+    static QTime get_position(QWidget *parent, const QString &title, const QString &label, const QTime position,
+                              const QTime length, bool *ok = nullptr);
 
    private:
     Ui::TimeDialog *ui_;
@@ -0,0 +1,166 @@
+#include "transcodeplan.hpp"
+
+#include <ciso646>
+#include <cmath>
+#include <optional>
+
+namespace concat {
+namespace {
+constexpr double FRAMERATE_TOLERANCE = 0.001;
+template <class T>
+std::optional<T> value_of(const RangedVariant<T> &value) {
+    if (std::holds_alternative<T>(value)) {
+        return std::get<T>(value);
+    }
+    return std::nullopt;
+}
+std::optional<QString> value_of(const SelectableVariant<QString> &value) {
+    if (std::holds_alternative<QString>(value)) {
+        return std::get<QString>(value);
+    }
+    return std::nullopt;
+}
+}  // namespace
+QStringList TranscodeOptions::scaling_algorithms() {
+    // from fastest to highest quality roughly
+    return {"fast_bilinear", "neighbor", "area", "bilinear", "bicubic", "spline", "lanczos"};
+}
+QStringList TranscodePlan::arguments(const QString &input, const VideoInfo &output_info) const {
+    QStringList result;
+    result << output_info.input_file_args << "-i" << input;
+    if (not video_filters.isEmpty()) {
+        result << "-vf" << video_filters.join(',');
+    }
+    result << "-c:a" << audio_codec << "-c:v" << video_codec;
+    if (not fps_mode.isEmpty()) {
+        result << "-fps_mode" << fps_mode;
+    }
+    result << output_info.encoding_args;
+    return result;
+}
+TranscodePlan plan_transcode(const VideoInfo &source_info, const VideoInfo &output_info,
+                             const TranscodeOptions &options) {
+    TranscodePlan plan;
+    auto source_audio_codec = value_of(source_info.audio_codec);
+    auto output_audio_codec = value_of(output_info.audio_codec);
+    if (output_audio_codec.has_value() && output_audio_codec != source_audio_codec) {
+        plan.audio_is_encoded = true;
+        plan.audio_codec = output_audio_codec.value();
+    }
+
+    auto source_resolution = value_of(source_info.resolution);
+    auto output_resolution = value_of(output_info.resolution);
+    QString crop;
+    if (options.crop.has_value() && options.crop->isValid() && options.crop->size() != source_resolution) {
+        crop = QStringLiteral("crop=%1:%2:%3:%4")
+                   .arg(options.crop->width())
+                   .arg(options.crop->height())
+                   .arg(options.crop->x())
+                   .arg(options.crop->y());
+        // output keeping resolution of source keeps that of cropped picture instead of stretching it back
+        if (output_resolution == source_resolution) {
+            output_resolution = options.crop->size();
+        }
+        source_resolution = options.crop->size();
+    }
+    QString scale;
+    if (output_resolution.has_value() && output_resolution != source_resolution) {
+        scale = QStringLiteral("scale=%1:%2:flags=%3")
+                    .arg(output_resolution->width())
+                    .arg(output_resolution->height())
+                    .arg(options.scaling_algorithm);
+        if (not crop.isEmpty()) {
+            // cropped picture has its own aspect ratio, which is fitted into output
+            scale += QStringLiteral(":force_original_aspect_ratio=decrease:force_divisible_by=2");
+        }
+    }
+    auto source_framerate = value_of(source_info.framerate);
+    auto output_framerate = value_of(output_info.framerate);
+    bool framerate_changed = output_framerate.has_value() && output_framerate.value() > 0.0 &&
+                             (not source_framerate.has_value() ||
+                              std::abs(output_framerate.value() - source_framerate.value()) > FRAMERATE_TOLERANCE);
+    auto source_video_codec = value_of(source_info.video_codec);
+    auto output_video_codec = value_of(output_info.video_codec);
+    bool codec_changed = output_video_codec.has_value() && output_video_codec != source_video_codec;
+    // making vfr source cfr alone doesn't make video encoded, as it would turn every remux of such source into encode
+    if (not codec_changed && crop.isEmpty() && scale.isEmpty() && not framerate_changed) {
+        return plan;
+    }
+    plan.video_is_encoded = true;
+    plan.video_codec = output_video_codec.value_or(source_video_codec.value_or(QString()));
+    if (plan.video_codec.isEmpty()) {
+        plan.video_codec = "libx264";  // codec of source is unknown
+    }
+    QString fps;
+    if (not output_info.is_vfr && (framerate_changed || source_info.is_vfr)) {
+        auto framerate = framerate_changed ? output_framerate : source_framerate;
+        if (framerate.has_value() && framerate.value() > 0.0) {
+            fps = QStringLiteral("fps=%1").arg(framerate.value(), 0, 'g', 10);
+        }
+    }
+    if (output_info.is_vfr) {
+        plan.fps_mode = "passthrough";  // keep timestamps of source as they are
+    } else if (source_info.is_vfr) {
+        plan.fps_mode = "cfr";
+    }
+    // dropping frames before scaling, or scaling before duplicating frames, keeps number of scaled frames small
+    bool drops_frames = output_framerate.has_value() && source_framerate.has_value() &&
+                        output_framerate.value() < source_framerate.value();
+    // cropping first keeps the other filters from processing black bars
+    for (const auto &filter : drops_frames ? QStringList{crop, fps, scale} : QStringList{crop, scale, fps}) {
+        if (not filter.isEmpty()) {
+            plan.video_filters << filter;
+        }
+    }
+    return plan;
+}
+QStringList rendition_arguments(const QString &input, const VideoInfo &source_info,
+                                const QList<Rendition> &renditions, const TranscodeOptions &options) {
+    QStringList result;
+    if (renditions.isEmpty()) {
+        return result;
+    }
+    result << renditions.first().output_info.input_file_args << "-i" << input;
+    result << "-n";  // never overwrite, as ffmpeg would wait for answer from stdin
+    QList<TranscodePlan> plans;
+    QList<int> encoded;
+    for (const auto &rendition : renditions) {
+        plans.push_back(plan_transcode(source_info, rendition.output_info, options));
+        if (plans.last().video_is_encoded) {
+            encoded.push_back(static_cast<int>(plans.size()) - 1);
+        }
+    }
+    // decoded frames are shared by split, so that source is decoded only once however many renditions there are
+    QStringList graph;
+    bool is_split = encoded.size() > 1;
+    if (is_split) {
+        QString labels;
+        for (auto i = 0; i < encoded.size(); i++) {
+            labels += QStringLiteral("[s%1]").arg(i);
+        }
+        graph << QStringLiteral("[0:v:0]split=%1%2").arg(encoded.size()).arg(labels);
+    }
+    for (auto i = 0; i < encoded.size(); i++) {
+        const auto &filters = plans[encoded[i]].video_filters;
+        graph << QStringLiteral("%1%2[v%3]")
+                     .arg(is_split ? QStringLiteral("[s%1]").arg(i) : QStringLiteral("[0:v:0]"))
+                     .arg(filters.isEmpty() ? QStringLiteral("null") : filters.join(','))
+                     .arg(encoded[i]);
+    }
+    if (not graph.isEmpty()) {
+        result << "-filter_complex" << graph.join(';');
+    }
+    for (auto i = 0; i < renditions.size(); i++) {
+        const auto &plan = plans[i];
+        const auto &output_info = renditions[i].output_info;
+        result << "-map" << (plan.video_is_encoded ? QStringLiteral("[v%1]").arg(i) : QStringLiteral("0:v:0"));
+        result << "-map" << "0:a:0?";
+        result << "-c:a" << plan.audio_codec << "-c:v" << plan.video_codec;
+        if (not plan.fps_mode.isEmpty()) {
+            result << "-fps_mode" << plan.fps_mode;
+        }
+        result << output_info.encoding_args << renditions[i].output_path;
+    }
+    return result;
+}
+}  // namespace concat
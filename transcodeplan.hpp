@@ -0,0 +1,79 @@
+#ifndef VIDEO_RE_ENCODER_TRANSCODEPLAN
+#define VIDEO_RE_ENCODER_TRANSCODEPLAN
+
+#include <QRect>
+#include <QString>
+#include <QStringList>
+#include <optional>
+
+#include "videoinfo.hpp"
+
+namespace concat {
+/**
+ * @brief choices of user which don't belong to VideoInfo
+ */
+struct TranscodeOptions {
+    /// flags of swscale used by scale filter
+    QString scaling_algorithm = "bicubic";
+    /// part of source kept, such as one without black bars found by detect_crop(). std::nullopt keeps whole frame
+    std::optional<QRect> crop;
+    static QStringList scaling_algorithms();
+};
+/**
+ * @brief what ffmpeg has to do to turn source into output
+ * @details a stream is decoded and filtered only if its target requires it. otherwise it's copied.
+ */
+struct TranscodePlan {
+    bool video_is_encoded = false;
+    bool audio_is_encoded = false;
+    /// encoder, or "copy"
+    QString video_codec = "copy";
+    /// encoder, or "copy"
+    QString audio_codec = "copy";
+    /// filters applied to video in order. empty unless video is encoded
+    QStringList video_filters;
+    /// -fps_mode of output. empty means default of muxer
+    QString fps_mode;
+
+    /**
+     * @brief arguments of ffmpeg except output path and its options such as -n
+     *
+     * @param input path of input
+     * @param output_info info of output, whose input_file_args and encoding_args are used
+     */
+    QStringList arguments(const QString &input, const VideoInfo &output_info) const;
+};
+/**
+ * @brief plan minimal work to turn source into output
+ *
+ * @param source_info info of input file
+ * @param output_info info of output file. references must be resolved
+ * @param options
+ */
+TranscodePlan plan_transcode(const VideoInfo &source_info, const VideoInfo &output_info,
+                             const TranscodeOptions &options = TranscodeOptions());
+/**
+ * @brief one of outputs written from the same source by rendition_arguments()
+ */
+struct Rendition {
+    /// info of output. references must be resolved
+    VideoInfo output_info;
+    QString output_path;
+};
+/**
+ * @brief arguments of ffmpeg which writes every rendition in one run, including output paths and -n
+ * @details source is decoded once and its video is split by filter graph to filters and encoder of each rendition.
+ * renditions whose video is copied take it from input directly. index of output in messages of ffmpeg, such as
+ * "out#1", is index of rendition.
+ *
+ * @param input path of input
+ * @param source_info info of input file
+ * @param renditions outputs. input_file_args of the first one is used, and those of the others are ignored
+ * @param options
+ */
+QStringList rendition_arguments(const QString &input, const VideoInfo &source_info,
+                                const QList<Rendition> &renditions,
+                                const TranscodeOptions &options = TranscodeOptions());
+}  // namespace concat
+
+#endif
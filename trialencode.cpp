@@ -0,0 +1,145 @@
+#include "trialencode.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtDebug>
+#include <ciso646>
+
+namespace concat {
+namespace {
+/// seconds of ffmpeg time duration, such as "90.5" or "00:01:30.5"
+std::chrono::milliseconds parse_time(const QString &text) {
+    double seconds = 0.0;
+    for (const auto &part : text.split(':')) {
+        seconds = seconds * 60.0 + part.toDouble();
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(seconds));
+}
+}  // namespace
+TrialEncoder::TrialEncoder(int max_processes, QObject *parent)
+    : QObject(parent), max_processes_(qMax(max_processes, 1)) {}
+TrialEncoder::~TrialEncoder() { cancel(); }
+void TrialEncoder::add(int id, const EncodeJob &job) {
+    auto input = job.arguments.indexOf("-i");
+    if (input < 0 || job.arguments.size() < 2 || not dir_.isValid()) {
+        results_.insert(id, {0, 0.0, std::chrono::milliseconds(0), false});
+        return;
+    }
+    // range selected by input seeking of job, such as trim, is replaced by windows taken from inside it
+    auto arguments = job.arguments;
+    std::chrono::milliseconds start{0};
+    for (auto i = input - 2; i >= 0; i--) {
+        if (arguments[i] == "-ss" || arguments[i] == "-to" || arguments[i] == "-t") {
+            if (arguments[i] == "-ss") {
+                start = parse_time(arguments[i + 1]);
+            }
+            arguments.remove(i, 2);
+            input -= 2;
+        }
+    }
+    auto windows = spread_windows(job.length, NUM_SAMPLES, SAMPLE_DURATION);
+    trials_.insert(id, {job.length, static_cast<int>(windows.size())});
+    auto output_paths = QStringList{job.output_path} + job.extra_output_paths;
+    for (auto i = 0; i < windows.size(); i++) {
+        auto window = windows[i];
+        window.start += start;
+        auto sample = Sample{id, job.program, arguments, {}, window};
+        // every output, such as renditions, is written to scratch directory, where -n is harmless
+        for (auto j = 0; j < output_paths.size(); j++) {
+            auto output_path = dir_.filePath(
+                QStringLiteral("%1_%2_%3.%4").arg(id).arg(i).arg(j).arg(QFileInfo(output_paths[j]).suffix()));
+            auto index = sample.arguments.lastIndexOf(output_paths[j]);
+            if (index >= 0) {
+                sample.arguments[index] = output_path;
+            }
+            sample.output_paths << output_path;
+        }
+        auto input_args = window.input_args();
+        for (auto j = 0; j < input_args.size(); j++) {
+            sample.arguments.insert(input + j, input_args[j]);
+        }
+        pending_.push_back(sample);
+        num_samples_++;
+    }
+}
+void TrialEncoder::start() {
+    if (pending_.isEmpty() && running_.isEmpty()) {
+        emit finished(results_);
+        return;
+    }
+    start_next_();
+}
+void TrialEncoder::cancel() {
+    pending_.clear();
+    for (auto it = running_.cbegin(); it != running_.cend(); ++it) {
+        it.key()->disconnect(this);
+        it.key()->kill();
+        it.key()->waitForFinished();
+        it.key()->deleteLater();
+    }
+    running_.clear();
+    trials_.clear();
+    results_.clear();
+}
+void TrialEncoder::start_next_() {
+    while (not pending_.isEmpty() && running_.size() < max_processes_) {
+        auto sample = pending_.takeFirst();
+        auto process = new QProcess(this);
+        connect(process, &QProcess::finished, this, [this, process](int exit_code, QProcess::ExitStatus exit_status) {
+            finish_(process, exit_status == QProcess::NormalExit && exit_code == 0);
+        });
+        connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                finish_(process, false);
+            }
+        });
+        QElapsedTimer timer;
+        timer.start();
+        running_.insert(process, {sample, timer});
+        process->start(sample.program, sample.arguments);
+    }
+}
+void TrialEncoder::finish_(QProcess *process, bool is_success) {
+    if (not running_.contains(process)) {
+        return;
+    }
+    auto [sample, timer] = running_.take(process);
+    auto &trial = trials_[sample.id];
+    if (is_success) {
+        for (const auto &output_path : sample.output_paths) {
+            trial.sample_size += QFileInfo(output_path).size();
+        }
+        trial.sample_length += sample.window.duration;
+        trial.sample_wall_time += std::chrono::milliseconds(timer.elapsed());
+    } else {
+        qWarning() << "trial encode failed" << sample.arguments << process->readAllStandardError().right(1000);
+        trial.is_success = false;
+    }
+    for (const auto &output_path : sample.output_paths) {
+        QFile::remove(output_path);
+    }
+    process->deleteLater();
+    num_finished_samples_++;
+    emit progressed(num_finished_samples_, num_samples_);
+    trial.num_remaining_samples--;
+    if (trial.num_remaining_samples <= 0) {
+        auto finished_trial = trials_.take(sample.id);
+        TrialResult result;
+        result.is_success = finished_trial.is_success && finished_trial.sample_length.count() > 0;
+        if (result.is_success) {
+            auto ratio = std::chrono::duration<double>(finished_trial.length).count() /
+                         std::chrono::duration<double>(finished_trial.sample_length).count();
+            result.size = static_cast<qint64>(static_cast<double>(finished_trial.sample_size) * ratio);
+            result.bitrate = static_cast<double>(finished_trial.sample_size) * 8.0 /
+                             std::chrono::duration<double>(finished_trial.sample_length).count();
+            result.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::duration<double, std::milli>(finished_trial.sample_wall_time) * ratio);
+        }
+        results_.insert(sample.id, result);
+    }
+    start_next_();
+    if (pending_.isEmpty() && running_.isEmpty()) {
+        emit finished(results_);
+    }
+}
+}  // namespace concat
@@ -0,0 +1,93 @@
+#ifndef VIDEO_RE_ENCODER_TRIALENCODE
+#define VIDEO_RE_ENCODER_TRIALENCODE
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPair>
+#include <QProcess>
+#include <QString>
+#include <QTemporaryDir>
+#include <chrono>
+
+#include "encodescheduler.hpp"
+#include "samplewindows.hpp"
+
+namespace concat {
+/**
+ * @brief output of a job extrapolated from encoding short excerpts of its input
+ */
+struct TrialResult {
+    qint64 size = 0;                        // bytes
+    double bitrate = 0.0;                   // bits per second
+    std::chrono::milliseconds duration{0};  // wall time
+    bool is_success = true;
+};
+using TrialResults = QMap<int, TrialResult>;
+/**
+ * @brief encode a few excerpts of each job with its own arguments, and extrapolate its output size and wall time.
+ * @details excerpts are selected by input seeking, so encoding them takes time proportional to their length.
+ * they are taken from inside the range which job selects by input seeking, such as trim. every output of job,
+ * including renditions, is written to scratch directory.
+ * excerpts of all jobs share a pool of processes.
+ */
+class TrialEncoder : public QObject {
+    Q_OBJECT
+
+   public:
+    static constexpr int NUM_SAMPLES = 3;
+    static constexpr std::chrono::seconds SAMPLE_DURATION{10};
+    explicit TrialEncoder(int max_processes, QObject *parent = nullptr);
+    ~TrialEncoder();
+    /**
+     * @brief add trial of job. trials are started by start().
+     */
+    void add(int id, const EncodeJob &job);
+    /**
+     * @brief start added trials. finished() is emitted after every trial finishes.
+     */
+    void start();
+    /**
+     * @brief stop every trial. finished() is not emitted.
+     */
+    void cancel();
+    int num_samples() const { return num_samples_; }
+    int num_finished_samples() const { return num_finished_samples_; }
+
+   signals:
+    void progressed(int num_finished_samples, int num_samples);
+    void finished(TrialResults results);
+
+   private:
+    struct Sample {
+        int id;
+        QString program;
+        QStringList arguments;
+        QStringList output_paths;
+        SampleWindow window;
+    };
+    struct Trial {
+        std::chrono::milliseconds length{0};
+        int num_remaining_samples = 0;
+        qint64 sample_size = 0;
+        std::chrono::milliseconds sample_length{0};
+        std::chrono::milliseconds sample_wall_time{0};
+        bool is_success = true;
+    };
+    int max_processes_;
+    QTemporaryDir dir_;
+    QList<Sample> pending_;
+    QHash<QProcess *, QPair<Sample, QElapsedTimer>> running_;
+    QHash<int, Trial> trials_;
+    TrialResults results_;
+    int num_samples_ = 0;
+    int num_finished_samples_ = 0;
+
+    void start_next_();
+    void finish_(QProcess *process, bool is_success);
+};
+}  // namespace concat
+
+#endif
@@ -0,0 +1,189 @@
+#include "trimplan.hpp"
+
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <ciso646>
+
+#include "encodecost.hpp"
+
+namespace concat {
+namespace {
+/// keyframes are searched within this range from cut points. longer GOPs are re-encoded as a whole
+constexpr double KEYFRAME_SEARCH_SECONDS = 30.0;
+/// less than a frame. absorbs rounding of pts printed by ffprobe
+constexpr double TIME_TOLERANCE_SECONDS = 0.001;
+QString format_seconds(double seconds) { return QString::number(seconds, 'f', 6); }
+double to_seconds(std::chrono::milliseconds time) { return std::chrono::duration<double>(time).count(); }
+std::chrono::milliseconds to_milliseconds(double seconds) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(seconds));
+}
+/// quality of re-encoded segments, which is higher than usual as they are mixed with copied video
+QStringList quality_arguments(const QString &encoder) {
+    static const QHash<QString, QStringList> arguments{
+        {"libx264", {"-crf", "16"}},
+        {"libx265", {"-crf", "18"}},
+        {"libvpx-vp9", {"-crf", "20", "-b:v", "0"}},
+        {"libsvtav1", {"-crf", "22"}},
+    };
+    return arguments.value(encoder);
+}
+}  // namespace
+QStringList trim_input_arguments(const Trim &trim) {
+    return {"-ss", format_seconds(to_seconds(trim.start)), "-to", format_seconds(to_seconds(trim.end))};
+}
+QStringList keyframe_probe_arguments(const QString &path, const Trim &trim) {
+    auto start = to_seconds(trim.start);
+    auto end = to_seconds(trim.end);
+    auto intervals = QStringLiteral("%1%+%2,%3%%4")
+                         .arg(format_seconds(start))
+                         .arg(format_seconds(KEYFRAME_SEARCH_SECONDS))
+                         .arg(format_seconds(qMax(0.0, end - KEYFRAME_SEARCH_SECONDS)))
+                         .arg(format_seconds(end));
+    return {"-hide_banner",
+            "-v",
+            "quiet",
+            "-select_streams",
+            "v:0",
+            "-show_entries",
+            "stream=codec_name,profile,pix_fmt,time_base:packet=pts_time,flags",
+            "-read_intervals",
+            intervals,
+            "-of",
+            "json",
+            path};
+}
+std::optional<KeyframeProbe> parse_keyframe_probe(const QString &text) {
+    auto document = QJsonDocument::fromJson(text.toUtf8());
+    auto streams = document["streams"].toArray();
+    if (document.isNull() || streams.isEmpty()) {
+        return std::nullopt;
+    }
+    auto stream = streams.first().toObject();
+    KeyframeProbe result{stream["codec_name"].toString(), stream["profile"].toString(), stream["pix_fmt"].toString(),
+                         stream["time_base"].toString(), {}};
+    for (const auto &packet_value : document["packets"].toArray()) {
+        auto packet = packet_value.toObject();
+        bool ok = false;
+        auto pts_time = packet["pts_time"].toString().toDouble(&ok);
+        if (ok && packet["flags"].toString().startsWith('K')) {
+            result.keyframes.push_back(pts_time);
+        }
+    }
+    // intervals may overlap
+    std::sort(result.keyframes.begin(), result.keyframes.end());
+    result.keyframes.erase(std::unique(result.keyframes.begin(), result.keyframes.end()), result.keyframes.end());
+    return result;
+}
+QString segment_suffix(const QString &codec) {
+    return QStringList{"h264", "hevc", "mpeg2video"}.contains(codec) ? "ts" : "mkv";
+}
+std::optional<QString> profile_of(const QString &encoder, const QString &profile) {
+    auto name = profile.toLower().remove(' ').remove(':');
+    static const QStringList x264_profiles{"baseline", "main", "high", "high10", "high422", "high444"};
+    if (encoder == "libx264" && x264_profiles.contains(name)) {
+        return name;
+    }
+    if (encoder == "libx265" && QStringList{"main", "main10"}.contains(name)) {
+        return name;
+    }
+    return std::nullopt;
+}
+QString encoder_of_codec(const QString &codec) {
+    static const QHash<QString, QString> encoders{
+        {"h264", "libx264"}, {"hevc", "libx265"}, {"vp8", "libvpx"}, {"vp9", "libvpx-vp9"}, {"av1", "libsvtav1"},
+    };
+    return encoders.value(codec, codec);  // such as mpeg4 and mpeg2video, whose encoders are named after codec
+}
+TrimPlan plan_trim(const QString &input, const VideoInfo &source_info, const KeyframeProbe &probe, const Trim &trim,
+                   const QDir &work_dir) {
+    auto start = to_seconds(trim.start);
+    auto end = to_seconds(trim.end);
+    auto first = std::find_if(probe.keyframes.cbegin(), probe.keyframes.cend(),
+                              [start](double keyframe) { return keyframe >= start - TIME_TOLERANCE_SECONDS; });
+    auto last = std::find_if(probe.keyframes.crbegin(), probe.keyframes.crend(),
+                             [end](double keyframe) { return keyframe <= end + TIME_TOLERANCE_SECONDS; });
+    struct Segment {
+        double start;
+        double end;
+        bool is_copied;
+    };
+    QList<Segment> segments;
+    if (first != probe.keyframes.cend() && last != probe.keyframes.crend() && *first < *last) {
+        if (*first - start > TIME_TOLERANCE_SECONDS) {
+            segments.push_back({start, *first, false});
+        }
+        segments.push_back({*first, *last, true});
+        if (end - *last > TIME_TOLERANCE_SECONDS) {
+            segments.push_back({*last, end, false});
+        }
+    } else {
+        segments.push_back({start, end, false});
+    }
+
+    auto encoder = encoder_of_codec(probe.codec);
+    auto target_info = source_info;
+    target_info.video_codec = encoder;
+    target_info.encoding_args = quality_arguments(encoder);
+    TrimPlan plan;
+    for (qsizetype i = 0; i < segments.size(); i++) {
+        const auto &segment = segments[i];
+        auto output_path = work_dir.filePath(QStringLiteral("%1.%2").arg(i).arg(segment_suffix(probe.codec)));
+        // copied segment starts at keyframe, which seeking lands on as long as it is not before the keyframe
+        auto seek = segment.is_copied ? segment.start + TIME_TOLERANCE_SECONDS : segment.start;
+        QStringList arguments{"-ss", format_seconds(seek), "-to", format_seconds(segment.end), "-i", input,
+                              "-map", "0:v:0", "-an", "-sn", "-dn"};
+        auto length = to_milliseconds(segment.end - segment.start);
+        EncodeJob job;
+        if (segment.is_copied) {
+            arguments << "-c:v" << "copy" << "-avoid_negative_ts" << "make_zero";
+            job.cost = estimate_cost(VideoInfo(), VideoInfo(), length);  // stream copy
+        } else {
+            arguments << "-c:v" << encoder << target_info.encoding_args;
+            if (not probe.pix_fmt.isEmpty()) {
+                arguments << "-pix_fmt" << probe.pix_fmt;
+            }
+            auto profile = profile_of(encoder, probe.profile);
+            if (profile.has_value()) {
+                arguments << "-profile:v" << profile.value();
+            }
+            job.cost = estimate_cost(source_info, target_info, length);
+            job.memory = estimate_memory(source_info, target_info);
+        }
+        job.program = "ffmpeg";
+        job.arguments = arguments << "-n" << output_path;
+        job.input_path = input;
+        job.output_path = output_path;
+        job.length = length;
+        plan.segments << job;
+        plan.parts << output_path;
+    }
+    return plan;
+}
+EncodeJob create_trim_join_job(const QString &list_path, const QString &input, const Trim &trim,
+                               const KeyframeProbe &probe, const TranscodePlan &transcode,
+                               const VideoInfo &output_info, const QString &output_path) {
+    EncodeJob job;
+    job.program = "ffmpeg";
+    job.arguments = QStringList{"-f", "concat", "-safe", "0", "-i", list_path}
+                    << trim_input_arguments(trim) << "-i" << input << "-map" << "0:v:0" << "-map" << "1:a:0?"
+                    << "-c:v" << "copy" << "-c:a" << transcode.audio_codec;
+    if (transcode.audio_is_encoded) {
+        job.arguments << output_info.encoding_args;
+    }
+    auto time_base = probe.time_base.split('/');
+    auto is_mp4 = QStringList{"mp4", "mov", "m4v"}.contains(QFileInfo(output_path).suffix().toLower());
+    if (is_mp4 && time_base.size() == 2 && time_base[0] == "1") {
+        job.arguments << "-video_track_timescale" << time_base[1];
+    }
+    job.arguments << "-n" << output_path;
+    job.input_path = input;
+    job.output_path = output_path;
+    job.length = trim.length();
+    job.cost = estimate_cost(VideoInfo(), VideoInfo(), trim.length());  // stream copy, unless audio is encoded
+    return job;
+}
+}  // namespace concat
@@ -0,0 +1,99 @@
+#ifndef VIDEO_RE_ENCODER_TRIMPLAN
+#define VIDEO_RE_ENCODER_TRIMPLAN
+
+#include <QDir>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <chrono>
+#include <optional>
+
+#include "encodescheduler.hpp"
+#include "transcodeplan.hpp"
+#include "videoinfo.hpp"
+
+namespace concat {
+/**
+ * @brief range of input written to output
+ */
+struct Trim {
+    std::chrono::milliseconds start{0};
+    std::chrono::milliseconds end{0};
+    std::chrono::milliseconds length() const { return end - start; }
+};
+/**
+ * @brief input options which make ffmpeg read only trimmed range. cuts are frame accurate when video is encoded.
+ */
+QStringList trim_input_arguments(const Trim &trim);
+/**
+ * @brief video stream of source and its keyframes around cut points
+ */
+struct KeyframeProbe {
+    QString codec;
+    QString profile;
+    QString pix_fmt;
+    /// such as "1/15360"
+    QString time_base;
+    /// pts of keyframes in seconds in ascending order. only ones near cut points are listed
+    QList<double> keyframes;
+};
+/**
+ * @brief arguments of ffprobe listing keyframes near cut points. only short intervals around them are read.
+ */
+QStringList keyframe_probe_arguments(const QString &path, const Trim &trim);
+std::optional<KeyframeProbe> parse_keyframe_probe(const QString &text);
+/**
+ * @brief how video is trimmed without re-encoding it as a whole
+ * @details video between the first and the last keyframe inside trimmed range is copied, and only partial GOPs
+ * before and after them are re-encoded with the codec of source. the whole range is re-encoded if it contains no
+ * complete GOP. GOPs of source are assumed to be closed.
+ */
+struct TrimPlan {
+    /// jobs writing segments of video. they can run concurrently
+    QList<EncodeJob> segments;
+    /// files joined in order, which are outputs of segments
+    QStringList parts;
+};
+/**
+ * @brief encoder writing codec, such as "libx264" for "h264"
+ */
+QString encoder_of_codec(const QString &codec);
+/**
+ * @brief profile option of encoder matching profile reported by ffprobe, such as "high10" for "High 10"
+ *
+ * @return std::nullopt if encoder doesn't take such profile
+ */
+std::optional<QString> profile_of(const QString &encoder, const QString &profile);
+/**
+ * @brief suffix of parts encoded separately and joined by stream copy, such as segments of trim
+ * @details encoders keep parameter sets in-band in mpegts, so that parts whose parameter sets differ can be joined
+ */
+QString segment_suffix(const QString &codec);
+/**
+ * @brief plan smart rendering of trimmed video
+ *
+ * @param input path of input
+ * @param source_info info of input, whose references are resolved
+ * @param probe
+ * @param trim
+ * @param work_dir directory where segments are written
+ */
+TrimPlan plan_trim(const QString &input, const VideoInfo &source_info, const KeyframeProbe &probe, const Trim &trim,
+                   const QDir &work_dir);
+/**
+ * @brief job joining segments of video with audio of trimmed range of input
+ *
+ * @param list_path list of segments written by write_concat_list()
+ * @param input path of input
+ * @param trim
+ * @param probe
+ * @param transcode plan of whole input, whose video is copied
+ * @param output_info info of output, whose encoding_args are used if audio is encoded
+ * @param output_path
+ */
+EncodeJob create_trim_join_job(const QString &list_path, const QString &input, const Trim &trim,
+                               const KeyframeProbe &probe, const TranscodePlan &transcode,
+                               const VideoInfo &output_info, const QString &output_path);
+}  // namespace concat
+
+#endif
@@ -0,0 +1,119 @@
+#include "vfrdetect.hpp"
+
+#include <QRegularExpression>
+#include <QtDebug>
+#include <algorithm>
+#include <ciso646>
+#include <cmath>
+#include <memory>
+
+namespace concat {
+namespace {
+constexpr int NUM_WINDOWS = 3;
+constexpr std::chrono::seconds WINDOW_DURATION{5};
+/// ratio of irregular intervals above which video is vfr. a few odd intervals occur around edits of cfr videos
+constexpr double IRREGULAR_RATIO_THRESHOLD = 0.02;
+/// intervals needed for full confidence, which is about 3 seconds of 30 fps video
+constexpr int CONFIDENT_NUM_INTERVALS = 90;
+/// error allowed when time base is unknown, in seconds
+constexpr double DEFAULT_TOLERANCE = 0.0005;
+QString format_seconds(std::chrono::milliseconds time) {
+    return QString::number(std::chrono::duration<double>(time).count(), 'f', 3);
+}
+double tolerance_of(const QString &time_base) {
+    static const QRegularExpression fraction_pattern(R"(^(\d+)/(\d+)$)");
+    auto match = fraction_pattern.match(time_base);
+    auto numerator = match.captured(1).toDouble();
+    auto denominator = match.captured(2).toDouble();
+    if (not match.hasMatch() || numerator <= 0.0 || denominator <= 0.0) {
+        return DEFAULT_TOLERANCE;
+    }
+    // each of two timestamps is rounded by up to a tick
+    return qMax(DEFAULT_TOLERANCE, 1.5 * numerator / denominator);
+}
+}  // namespace
+QStringList vfr_probe_arguments(const QString &path, const SampleWindow &window) {
+    return {"-hide_banner",
+            "-v",
+            "quiet",
+            "-select_streams",
+            "v:0",
+            "-show_entries",
+            "packet=pts_time",
+            "-read_intervals",
+            QStringLiteral("%1%+%2").arg(format_seconds(window.start), format_seconds(window.duration)),
+            "-of",
+            "csv=print_section=0",
+            path};
+}
+QList<double> parse_packet_times(const QString &text) {
+    QList<double> result;
+    for (const auto &line : text.split('\n', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        auto pts_time = line.trimmed().remove(',').toDouble(&ok);
+        if (ok) {
+            result.push_back(pts_time);
+        }
+    }
+    return result;
+}
+VfrEstimate estimate_vfr(const QList<QList<double>> &windows, const QString &time_base) {
+    QList<double> intervals;
+    for (auto times : windows) {
+        std::sort(times.begin(), times.end());
+        for (auto i = 1; i < times.size(); i++) {
+            if (times[i] > times[i - 1]) {
+                intervals.push_back(times[i] - times[i - 1]);
+            }
+        }
+    }
+    VfrEstimate result;
+    result.num_intervals = static_cast<int>(intervals.size());
+    if (intervals.isEmpty()) {
+        return result;
+    }
+    auto sorted = intervals;
+    auto median = sorted.begin() + sorted.size() / 2;
+    std::nth_element(sorted.begin(), median, sorted.end());
+    auto tolerance = tolerance_of(time_base);
+    auto num_irregular = std::count_if(intervals.cbegin(), intervals.cend(),
+                                       [&](double interval) { return std::abs(interval - *median) > tolerance; });
+    result.irregular_ratio = static_cast<double>(num_irregular) / intervals.size();
+    result.is_vfr = result.irregular_ratio > IRREGULAR_RATIO_THRESHOLD;
+    auto margin = result.is_vfr ? qMin(1.0, result.irregular_ratio / (2.0 * IRREGULAR_RATIO_THRESHOLD))
+                                : 1.0 - result.irregular_ratio / IRREGULAR_RATIO_THRESHOLD;
+    result.confidence = margin * qMin(1.0, static_cast<double>(intervals.size()) / CONFIDENT_NUM_INTERVALS);
+    return result;
+}
+void detect_vfr(ProcessRunner *runner, const QString &path, const ProbeResult &probe_result,
+                std::function<void(ProbeResult)> done, int priority) {
+    struct State {
+        ProbeResult probe_result;
+        QList<QList<double>> windows;
+        int num_remaining;
+    };
+    auto windows = spread_windows(probe_result.length, NUM_WINDOWS, WINDOW_DURATION);
+    auto state = std::make_shared<State>(State{probe_result, {}, static_cast<int>(windows.size())});
+    for (const auto &window : windows) {
+        runner->run(
+            "ffprobe", vfr_probe_arguments(path, window),
+            [state, done, path](const ProcessResult &result) {
+                if (result.is_success) {
+                    state->windows.push_back(parse_packet_times(result.stdout_text));
+                } else {
+                    qWarning() << "failed to sample timestamps of" << path << result.stderr_text + result.error;
+                }
+                if (--state->num_remaining > 0) {
+                    return;
+                }
+                auto estimate = estimate_vfr(state->windows, state->probe_result.time_base);
+                if (estimate.num_intervals > 0) {
+                    state->probe_result.info.is_vfr = estimate.is_vfr;
+                    state->probe_result.vfr_confidence = estimate.confidence;
+                }
+                done(state->probe_result);
+            },
+            priority);
+    }
+}
+}  // namespace concat
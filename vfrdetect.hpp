@@ -0,0 +1,54 @@
+#ifndef VIDEO_RE_ENCODER_VFRDETECT
+#define VIDEO_RE_ENCODER_VFRDETECT
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <chrono>
+#include <functional>
+
+#include "processrunner.hpp"
+#include "proberesult.hpp"
+#include "samplewindows.hpp"
+
+namespace concat {
+/**
+ * @brief whether frame intervals of video vary, estimated from sampled packet timestamps
+ */
+struct VfrEstimate {
+    bool is_vfr = false;
+    /// 0 to 1. low when few intervals were sampled or when irregular intervals are near the threshold
+    double confidence = 0.0;
+    /// fraction of intervals which differ from the median interval by more than rounding to time base
+    double irregular_ratio = 0.0;
+    int num_intervals = 0;
+};
+/**
+ * @brief arguments of ffprobe which write pts_time of video packets in window, one per line
+ */
+QStringList vfr_probe_arguments(const QString &path, const SampleWindow &window);
+/**
+ * @brief parse stdout of ffprobe run with vfr_probe_arguments(). packets without timestamp are skipped.
+ */
+QList<double> parse_packet_times(const QString &text);
+/**
+ * @brief estimate vfr from timestamps of windows
+ * @details timestamps are sorted in each window, as packets are in decoding order. intervals are compared with the
+ * median interval, allowing error of rounding to time base, so that 29.97 fps in milliseconds, whose intervals are
+ * 33 and 34, is cfr.
+ *
+ * @param windows timestamps of packets in seconds, per window
+ * @param time_base time base of video stream such as "1/90000". empty if unknown
+ */
+VfrEstimate estimate_vfr(const QList<QList<double>> &windows, const QString &time_base);
+/**
+ * @brief probe a few windows of file in parallel and decide is_vfr of probe result by estimate_vfr()
+ * @details whole file is never read. probe result is passed as it is if every window fails.
+ *
+ * @param done called with probe result whose is_vfr and vfr_confidence are updated
+ */
+void detect_vfr(ProcessRunner *runner, const QString &path, const ProbeResult &probe_result,
+                std::function<void(ProbeResult)> done, int priority = 0);
+}  // namespace concat
+
+#endif
@@ -42,6 +42,9 @@ VideoInfoWidget::VideoInfoWidget(QWidget *parent)
 
     connect(ui_->listWidget_args, &QListWidget::currentTextChanged, this, &VideoInfoWidget::emit_info_changed_);
     connect(ui_->listWidget_input_args, &QListWidget::currentTextChanged, this, &VideoInfoWidget::emit_info_changed_);
+
+    ui_->checkBox_crop->setVisible(false);
+    connect(ui_->checkBox_crop, &QCheckBox::clicked, this, &VideoInfoWidget::crop_toggled);
 }
 
 VideoInfoWidget::~VideoInfoWidget() { delete ui_; }
@@ -274,6 +277,19 @@ concat::VideoInfo VideoInfoWidget::info() const {
     }
     return result;
 }
+void VideoInfoWidget::set_crop(std::optional<QRect> crop, bool is_applied) {
+    ui_->checkBox_crop->setVisible(crop.has_value());
+    if (not crop.has_value()) {
+        return;
+    }
+    ui_->checkBox_crop->setText(tr("crop black bars (%1x%2 at %3,%4)")
+                                    .arg(crop->width())
+                                    .arg(crop->height())
+                                    .arg(crop->x())
+                                    .arg(crop->y()));
+    ui_->checkBox_crop->setChecked(is_applied);
+}
+void VideoInfoWidget::set_editable(bool is_editable) { ui_->widget_info->setEnabled(is_editable); }
 void VideoInfoWidget::update_everything_() {
     update_input_resolution_(ui_->comboBox_resolution->currentText());
     update_input_framerate_(ui_->comboBox_framerate->currentText());
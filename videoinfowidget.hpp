@@ -1,8 +1,10 @@
 #ifndef VIDEOINFOWIDGET_HPP
 #define VIDEOINFOWIDGET_HPP
 
+#include <QRect>
 #include <QWidget>
 #include <memory>
+#include <optional>
 
 #include "videoinfo.hpp"
 
@@ -20,8 +22,18 @@ class VideoInfoWidget : public QWidget {
     ~VideoInfoWidget();
     void set_infos(const concat::VideoInfo &initial_values, const concat::VideoInfo &input_info);
     concat::VideoInfo info() const;
+    /**
+     * @brief offer crop of source. crop stays editable while info isn't
+     *
+     * @param crop detected crop, or std::nullopt to hide the offer
+     * @param is_applied whether crop is checked
+     */
+    void set_crop(std::optional<QRect> crop, bool is_applied);
+    /// info is read only while preset is used
+    void set_editable(bool is_editable);
    signals:
     void info_changed(concat::VideoInfo new_value);
+    void crop_toggled(bool is_applied);
 
    private:
     Ui::VideoInfoWidget *ui_;
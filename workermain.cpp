@@ -0,0 +1,55 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QThread>
+#include <QtDebug>
+#include <ciso646>
+
+#include "encodeworker.hpp"
+#include "workerprotocol.hpp"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("videos_re_encoder_worker");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("run encode jobs sent by videos_re_encoder on this machine");
+    parser.addHelpOption();
+    QCommandLineOption listen_option("listen", "address to listen on. listen on 0.0.0.0 only in trusted network",
+                                     "address", "127.0.0.1");
+    QCommandLineOption port_option("port", "port to listen on", "port", QString::number(concat::DEFAULT_WORKER_PORT));
+    QCommandLineOption jobs_option("jobs", "number of jobs run concurrently", "number",
+                                   QString::number(qMax(1, QThread::idealThreadCount() / 4)));
+    QCommandLineOption ffmpeg_option("ffmpeg", "ffmpeg to run", "path", "ffmpeg");
+    QCommandLineOption map_option("map",
+                                  "translate paths seen by client to ones seen by this machine. can be repeated",
+                                  "client_prefix=worker_prefix");
+    parser.addOptions({listen_option, port_option, jobs_option, ffmpeg_option, map_option});
+    parser.process(a);
+
+    QList<concat::PathMapping> path_mappings;
+    for (const auto &text : parser.values(map_option)) {
+        auto mapping = concat::PathMapping::parse(text);
+        if (not mapping.has_value()) {
+            qCritical() << "invalid path mapping" << text;
+            return 1;
+        }
+        path_mappings.push_back(mapping.value());
+    }
+    bool ok_port = false, ok_jobs = false;
+    auto port = parser.value(port_option).toUShort(&ok_port);
+    auto jobs = parser.value(jobs_option).toInt(&ok_jobs);
+    QHostAddress address;
+    if (not(ok_port && ok_jobs && jobs > 0 && address.setAddress(parser.value(listen_option)))) {
+        qCritical() << "invalid option";
+        parser.showHelp(1);
+    }
+
+    concat::EncodeWorker worker(parser.value(ffmpeg_option), jobs, path_mappings);
+    if (not worker.listen(address, port)) {
+        qCritical() << "failed to listen on" << address.toString() << port << worker.error_string();
+        return 1;
+    }
+    qInfo() << "listening on" << address.toString() << worker.port() << "with" << jobs << "slots";
+    return a.exec();
+}
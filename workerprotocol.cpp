@@ -0,0 +1,48 @@
+#include "workerprotocol.hpp"
+
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QtDebug>
+#include <ciso646>
+
+namespace concat {
+QByteArray encode_worker_message(const QJsonObject &message) {
+    return QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n';
+}
+QList<QJsonObject> read_worker_messages(QIODevice *device) {
+    QList<QJsonObject> result;
+    while (device->canReadLine()) {
+        auto line = device->readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonParseError err;
+        auto document = QJsonDocument::fromJson(line, &err);
+        if (not document.isObject()) {
+            qWarning() << "ignored malformed message from worker connection" << err.errorString();
+            continue;
+        }
+        result.push_back(document.object());
+    }
+    return result;
+}
+std::optional<PathMapping> PathMapping::parse(const QString &text) {
+    auto separator = text.indexOf('=');
+    if (separator <= 0 || separator + 1 >= text.size()) {
+        return std::nullopt;
+    }
+    return PathMapping{text.left(separator), text.mid(separator + 1)};
+}
+QString map_path(const QString &path, const QList<PathMapping> &mappings) {
+    for (const auto &mapping : mappings) {
+        // "/mnt/a" matches "/mnt/a/b" but not "/mnt/ab"
+        auto size = mapping.client_prefix.size();
+        if (path.startsWith(mapping.client_prefix) &&
+            (path.size() == size || mapping.client_prefix.endsWith('/') || path[size] == '/')) {
+            return mapping.worker_prefix + path.mid(mapping.client_prefix.size());
+        }
+    }
+    return path;
+}
+}  // namespace concat
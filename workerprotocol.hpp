@@ -0,0 +1,60 @@
+#ifndef VIDEO_RE_ENCODER_WORKERPROTOCOL
+#define VIDEO_RE_ENCODER_WORKERPROTOCOL
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <optional>
+
+class QIODevice;
+
+/**
+ * @file
+ * @brief protocol between EncodeScheduler and remote worker daemon
+ * @details each message is a compact json object terminated by a newline. a field "type" tells kind of message.
+ *
+ * worker to client:
+ * - `{"type": "hello", "version": 1, "host": "...", "slots": 4}` sent when connected
+ * - `{"type": "started", "id": 3}`
+ * - `{"type": "output", "id": 3, "stdout": "...", "stderr": "..."}` output of ffmpeg. stderr contains progress lines
+ * - `{"type": "finished", "id": 3, "success": true, "error": "..."}`
+ *
+ * client to worker:
+ * - `{"type": "job", "id": 3, "arguments": [...], "input_path": "...", "output_path": "..."}` arguments of ffmpeg
+ * - `{"type": "cancel", "id": 3}`
+ *
+ * ids are chosen by client and are unique within a connection. paths are the ones seen by client, and worker
+ * translates them with its path mappings, so that files are shared through a network filesystem.
+ */
+namespace concat {
+constexpr int WORKER_PROTOCOL_VERSION = 1;
+constexpr quint16 DEFAULT_WORKER_PORT = 47625;
+/**
+ * @brief serialize message with its terminator
+ */
+QByteArray encode_worker_message(const QJsonObject &message);
+/**
+ * @brief read complete messages available in device. partial line is left in device.
+ */
+QList<QJsonObject> read_worker_messages(QIODevice *device);
+/**
+ * @brief prefix of path seen by client and the one seen by worker, such as "/mnt/videos" and "/srv/videos"
+ */
+struct PathMapping {
+    QString client_prefix;
+    QString worker_prefix;
+    /**
+     * @brief parse "client_prefix=worker_prefix"
+     */
+    static std::optional<PathMapping> parse(const QString &text);
+};
+/**
+ * @brief translate path with the first mapping whose client prefix matches. path is returned as is if none matches.
+ * @details prefix matches whole components of path only.
+ */
+QString map_path(const QString &path, const QList<PathMapping> &mappings);
+}  // namespace concat
+
+#endif